@@ -0,0 +1,72 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+AABB.h
+Axis-aligned bounding boxes - the simplest useful bounding volume,
+and the building block of our BVH.
+*/
+
+#pragma once
+
+#include "GLM/glm.hpp"
+
+#include <cfloat>
+
+namespace nou
+{
+	struct AABB
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+
+		//An "inside out" box, which becomes the other box when merged with anything.
+		static AABB Empty()
+		{
+			return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+		}
+
+		//The smallest box containing a sphere given as (center, radius).
+		static AABB FromSphere(const glm::vec4& sphere)
+		{
+			glm::vec3 center = glm::vec3(sphere);
+			glm::vec3 extent = glm::vec3(glm::max(sphere.w, 0.0f));
+
+			return { center - extent, center + extent };
+		}
+
+		static AABB Union(const AABB& a, const AABB& b)
+		{
+			return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+		}
+
+		glm::vec3 Center() const
+		{
+			return (min + max) * 0.5f;
+		}
+
+		//Half the surface area (the factor of 2 doesn't matter for comparing costs).
+		float HalfArea() const
+		{
+			glm::vec3 d = max - min;
+			return d.x * d.y + d.y * d.z + d.z * d.x;
+		}
+
+		bool Overlaps(const AABB& other) const
+		{
+			return glm::all(glm::lessThanEqual(min, other.max)) &&
+				   glm::all(glm::lessThanEqual(other.min, max));
+		}
+
+		bool Contains(const AABB& other) const
+		{
+			return glm::all(glm::lessThanEqual(min, other.min)) &&
+				   glm::all(glm::lessThanEqual(other.max, max));
+		}
+
+		bool operator==(const AABB& other) const
+		{
+			return min == other.min && max == other.max;
+		}
+	};
+}
@@ -0,0 +1,231 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+AssetManager.h
+Loads textures and meshes in the background, so that the game keeps
+running (and rendering) while they come in.
+
+Loading an asset has two halves:
+-Reading and decoding the file (parsing, decompressing, optimizing...),
+ which is where nearly all the time goes, but doesn't need OpenGL.
+ This runs on the JobSystem's worker threads.
+-Sending the result to the GPU, which has to happen on the main thread,
+ since that's the thread that owns the OpenGL context.
+ Finished reads wait in a queue, which Update() (called by App::FrameStart)
+ works through each frame - but only for as long as the upload budget
+ allows, so a level's worth of assets finishing at once gets spread over
+ several frames rather than causing one long hitch.
+
+Each load hands back an Asset handle straight away. The handle reports
+LOADING until the asset is on the GPU, after which Get() returns it.
+*/
+
+#pragma once
+
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "Texture.h"
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace nou
+{
+	enum class AssetState
+	{
+		LOADING,
+		READY,
+		FAILED
+	};
+
+	//A handle to an asset that's loading (or done loading).
+	//Handles are cheap to copy, and copies all refer to the same asset,
+	//which lives for as long as any handle to it does.
+	template<typename T>
+	class Asset
+	{
+		public:
+
+		Asset() = default;
+		~Asset() = default;
+
+		//A default-constructed handle doesn't refer to anything, and counts as FAILED.
+		AssetState GetState() const
+		{
+			return (m_slot != nullptr) ? m_slot->state.load(std::memory_order_acquire) : AssetState::FAILED;
+		}
+
+		bool IsReady() const { return GetState() == AssetState::READY; }
+
+		//Null until the asset is ready.
+		T* Get() const { return (IsReady()) ? m_slot->object.get() : nullptr; }
+
+		//What went wrong, once the state is FAILED.
+		std::string GetError() const
+		{
+			if (m_slot == nullptr)
+				return "Empty asset handle.";
+
+			return (GetState() == AssetState::FAILED) ? m_slot->error : "";
+		}
+
+		//Whether this handle refers to an asset at all.
+		bool IsValid() const { return m_slot != nullptr; }
+
+		//The name the asset was loaded with (usually its path). Valid handles only.
+		const std::string& GetName() const { return m_slot->name; }
+
+		protected:
+
+		friend class AssetManager;
+
+		struct Slot
+		{
+			std::string name;
+			std::atomic<AssetState> state = AssetState::LOADING;
+			std::unique_ptr<T> object;
+			std::string error;
+		};
+
+		std::shared_ptr<Slot> m_slot;
+	};
+
+	class AssetManager
+	{
+		public:
+
+		~AssetManager() = default;
+
+		//How long (in ms) Update() may spend on uploads each frame.
+		//Update() also stops early once TextureUploader's byte budget for the frame is spent.
+		//At least one upload happens per Update(), however long it takes.
+		static void SetUploadBudget(float ms);
+		static float GetUploadBudget();
+
+		//Loads a texture, as Texture2D's constructor would.
+		//Mipmaps are built on the worker, too.
+		static Asset<Texture2D> LoadTexture(const std::string& filename, bool useNearest = false, bool mipmaps = true);
+
+		//Loads a mesh from an OBJ, glTF, or GLB file (going by the extension),
+		//as OBJ::LoadMesh or GLTF::LoadMesh would - including the MeshCache.
+		//(flipUVY is ignored for OBJs.)
+		static Asset<Mesh> LoadMesh(const std::string& filename, bool flipUVY = true,
+									bool optimize = true, bool keepCPUCopy = true);
+
+		//Loads anything else. read runs on a worker and fills in a Staging (which has to be
+		//default constructible), returning false (and setting err) if it can't. create then
+		//runs on the main thread to turn that into the asset, returning null if it can't.
+		//E.g., TTK textures:
+		//	AssetManager::Load<TTK::Texture2D, TTK::Texture2D::ImageData>(path,
+		//		[path](auto& image, std::string& err) { ... TTK::Texture2D::DecodeFile(path, image) ... },
+		//		[](auto& image) { ... tex->LoadTextureFromData(image) ... });
+		template<typename T, typename Staging>
+		static Asset<T> Load(const std::string& name,
+							 std::function<bool(Staging& staging, std::string& err)> read,
+							 std::function<std::unique_ptr<T>(Staging& staging)> create);
+
+		//Sends finished assets to the GPU until the budget runs out.
+		//Call once per frame, from the main thread (App::FrameStart does this for you).
+		//Returns the number of assets uploaded.
+		static size_t Update();
+
+		//Blocks until the asset is ready (or has failed). Main thread only, since
+		//this does the asset's upload (and any others queued before it) itself.
+		template<typename T>
+		static void Wait(const Asset<T>& asset);
+
+		//Blocks until everything that's loading is done. Main thread only.
+		static void WaitAll();
+
+		//How many assets haven't finished loading yet.
+		static size_t GetPendingCount();
+
+		protected:
+
+		//Instantiating this class doesn't make sense, since all our functionality
+		//is exposed statically.
+		AssetManager() = default;
+
+		using Upload = std::function<void()>;
+
+		static void QueueUpload(Upload upload);
+		//Every read runs under this counter, so waiting can help the workers with them.
+		static JobSystem::Counter& GetReadCounter();
+		static void LoadStarted();
+		static void LoadFinished();
+		//Waits for at least one read (or upload) to finish.
+		static void Step();
+
+		template<typename T>
+		static void Fail(typename Asset<T>::Slot& slot, const std::string& err);
+	};
+
+	template<typename T, typename Staging>
+	Asset<T> AssetManager::Load(const std::string& name,
+								std::function<bool(Staging& staging, std::string& err)> read,
+								std::function<std::unique_ptr<T>(Staging& staging)> create)
+	{
+		Asset<T> asset;
+		asset.m_slot = std::make_shared<typename Asset<T>::Slot>();
+		asset.m_slot->name = name;
+
+		auto slot = asset.m_slot;
+
+		LoadStarted();
+
+		JobSystem::Run([slot, read, create]()
+		{
+			//Staging data is often move-only (e.g., a mapped file),
+			//so it's shared with the upload rather than copied into it.
+			auto staging = std::make_shared<Staging>();
+			std::string err;
+
+			if (!read(*staging, err))
+			{
+				Fail<T>(*slot, err);
+				return;
+			}
+
+			QueueUpload([slot, staging, create]()
+			{
+				std::unique_ptr<T> object = create(*staging);
+
+				if (object == nullptr)
+				{
+					Fail<T>(*slot, "Couldn't create asset from the data read.");
+					return;
+				}
+
+				slot->object = std::move(object);
+				slot->state.store(AssetState::READY, std::memory_order_release);
+
+				LoadFinished();
+			});
+		}, &GetReadCounter());
+
+		return asset;
+	}
+
+	template<typename T>
+	void AssetManager::Wait(const Asset<T>& asset)
+	{
+		while (asset.GetState() == AssetState::LOADING)
+			Step();
+	}
+
+	template<typename T>
+	void AssetManager::Fail(typename Asset<T>::Slot& slot, const std::string& err)
+	{
+		printf("Error loading %s: %s\n", slot.name.c_str(), err.c_str());
+
+		//The error has to be in place before anyone can see the state change.
+		slot.error = err;
+		slot.state.store(AssetState::FAILED, std::memory_order_release);
+
+		LoadFinished();
+	}
+}
@@ -0,0 +1,164 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+BVH.h
+A dynamic bounding volume hierarchy, for answering "what's over here?"
+without checking every object in the scene.
+
+Every object gets a box (a leaf), and leaves are grouped in pairs under
+boxes that contain both of them, and so on up to a single root. Any query
+(a frustum, a ray, another box) that misses a node can skip everything
+below it - so instead of touching all N objects, we only visit the parts
+of the tree that are actually near the query.
+
+How good the tree is depends on how we group things. We use the "surface
+area heuristic" (SAH): the chance of a random ray or query hitting a box
+is roughly proportional to its surface area, so we want the tree with the
+smallest total area of internal boxes. Build() does this properly from
+scratch; Insert() does a cheaper, greedy version for one object at a time.
+
+When objects move, we don't rebuild - we just update their leaves and
+"refit" the boxes above them. Over time, refitting can leave the tree in
+worse shape than a fresh build (objects that started together may have
+wandered apart), so it's worth calling Build() again now and then
+(e.g., after loading a level, or every few hundred frames).
+*/
+
+#pragma once
+
+#include "AABB.h"
+#include "Frustum.h"
+#include "TransformStore.h"
+
+#include "GLM/glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace nou
+{
+	class BVH
+	{
+		public:
+
+		//Identifies an object in the tree. Proxies are stable until the
+		//object is removed (even across Build calls).
+		using Proxy = uint32_t;
+		static constexpr uint32_t NONE = UINT32_MAX;
+
+		struct RayHit
+		{
+			uint32_t userData = NONE;
+			//Distance along the ray to where it enters the object's box.
+			float distance = 0.0f;
+		};
+
+		BVH();
+		~BVH() = default;
+
+		//Adds an object to the tree. User data is whatever you want to get
+		//back from queries (e.g., an index into your own array of objects).
+		Proxy Insert(const AABB& bounds, uint32_t userData);
+		void Remove(Proxy proxy);
+
+		//Changes an object's bounds. The boxes above it aren't touched until
+		//the next Refit(), so moving lots of objects at once is cheap.
+		void Update(Proxy proxy, const AABB& bounds);
+		//Fixes up the boxes above every object that moved since the last call.
+		//Only the paths from those objects up to the root are visited, and
+		//each path stops as soon as a box stops changing.
+		void Refit();
+
+		//Rebuilds the whole tree from scratch with a (binned) SAH split at every level.
+		void Build();
+
+		//Appends the user data of every object whose box is (at least partially)
+		//inside the frustum. Returns the number of objects found.
+		size_t QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const;
+		//Same, but for objects whose box overlaps the given one.
+		size_t QueryOverlap(const AABB& bounds, std::vector<uint32_t>& results) const;
+		//Finds the closest object box hit by the ray, up to maxDistance away.
+		//The direction doesn't need to be normalized, but the distance is in
+		//multiples of its length. Returns false if nothing was hit.
+		bool Raycast(const glm::vec3& origin, const glm::vec3& direction,
+					 float maxDistance, RayHit& hit) const;
+
+		const AABB& GetBounds(Proxy proxy) const;
+		uint32_t GetUserData(Proxy proxy) const;
+
+		//Number of objects in the tree.
+		size_t Size() const;
+		//Number of levels (a lone leaf has height 0, an empty tree -1).
+		int GetHeight() const;
+		//The SAH cost of the tree - the summed area of every internal box,
+		//relative to the root's. Lower is better; handy for seeing how
+		//much refitting has degraded the tree since the last Build.
+		float GetCost() const;
+		//Number of boxes recomputed by the last Refit call.
+		size_t LastRefitCount() const;
+
+		//For keeping transforms' world bounds in the tree.
+		//This turns on update tracking in the store, so that Sync only has to
+		//look at transforms that moved. Objects without bounds aren't added
+		//(and NONE is returned), since they'd just be in every query anyway.
+		//User data is the transform's handle.
+		Proxy InsertTransform(TransformStore& store, TransformStore::Handle handle);
+		//Call this before destroying the transform.
+		void RemoveTransform(TransformStore::Handle handle);
+		//Updates and refits every inserted transform that has moved since
+		//the last Sync. Call after DoFK.
+		void Sync(TransformStore& store);
+
+		protected:
+
+		struct Node
+		{
+			AABB bounds;
+			uint32_t parent;
+			//Leaves have no children. Free nodes have no children or parent,
+			//and use "next" to form the free list.
+			uint32_t child[2];
+			union
+			{
+				uint32_t userData;
+				uint32_t next;
+			};
+			//Leaves have height 0, free nodes -1.
+			int32_t height;
+			//Set while the leaf is waiting in m_moved.
+			bool moved;
+
+			bool IsLeaf() const { return child[0] == NONE; }
+		};
+
+		std::vector<Node> m_nodes;
+		uint32_t m_root;
+		uint32_t m_freeList;
+		size_t m_leafCount;
+
+		//Leaves updated since the last Refit.
+		std::vector<Proxy> m_moved;
+		size_t m_lastRefitCount;
+
+		//Transform handle -> proxy, for InsertTransform and Sync.
+		std::vector<Proxy> m_transformProxies;
+
+		//Scratch space for Build, kept around between calls.
+		std::vector<uint32_t> m_buildLeaves;
+		std::vector<glm::vec3> m_buildCentroids;
+		std::vector<uint32_t> m_buildNodes;
+
+		uint32_t AllocateNode();
+		void FreeNode(uint32_t index);
+
+		void InsertLeaf(uint32_t leaf);
+		void RemoveLeaf(uint32_t leaf);
+		//Recomputes bounds and heights from index up to the root.
+		void FixUpwards(uint32_t index);
+
+		//Partitions m_buildLeaves[begin, end) into two groups with the best
+		//split we can find, and returns where the second group starts.
+		uint32_t Split(uint32_t begin, uint32_t end);
+	};
+}
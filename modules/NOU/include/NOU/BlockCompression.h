@@ -0,0 +1,47 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+BlockCompression.h
+CPU encoders for the BC1, BC3, BC5, and BC7 block-compressed formats
+(see TextureData.h for what each is good for).
+
+Every format works on 4x4 blocks of texels, and stores each block as a
+couple of endpoint colours plus a small index per texel, which picks a
+colour on the line between the endpoints. So encoding a block is mostly:
+1. Find the line through colour space that best fits the block's texels
+   (the principal axis - the direction the colours are most spread along).
+2. Use the block's extremes along that line as the endpoints.
+3. Snap each texel to its nearest colour on the line.
+These encoders stop there (plus one refinement pass for BC1), which is
+fast and decent, if not as good as the slow, exhaustive encoders used
+for shipping games. BC7 only uses mode 6 (one line in RGBA, with 16
+steps along it), which is by far its most generally useful mode.
+
+Blocks are independent, so images are encoded in parallel on the JobSystem.
+*/
+
+#pragma once
+
+#include "TextureData.h"
+
+#include <cstdint>
+
+namespace nou::BlockCompression
+{
+	//Encodes one block. Texels are RGBA8, row by row (16 x 4 bytes).
+	//BC1 ignores alpha, and BC5 only uses red and green.
+	void EncodeBC1(const unsigned char* texels, uint8_t* block);
+	void EncodeBC3(const unsigned char* texels, uint8_t* block);
+	void EncodeBC5(const unsigned char* texels, uint8_t* block);
+	void EncodeBC7(const unsigned char* texels, uint8_t* block);
+
+	//Encodes a single image (width x height RGBA8 pixels) into out, which needs to
+	//hold GetImageSize(format, width, height) bytes. Edge blocks that hang off the
+	//image are padded by repeating its last row/column.
+	void EncodeImage(const unsigned char* pixels, int width, int height, TextureFormat format, uint8_t* out);
+
+	//Encodes every level of an RGBA8 texture (e.g., one from Mipmap::Build).
+	//Returns false if source isn't RGBA8. Encoding to RGBA8 is just a copy.
+	bool Encode(const TextureData& source, TextureFormat format, TextureData& out);
+}
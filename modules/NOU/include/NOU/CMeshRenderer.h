@@ -16,6 +16,7 @@ that we intend the class for use as a component with the ENTT framework.
 #include "Mesh.h"
 #include "Material.h"
 #include "Entity.h"
+#include "RenderQueue.h"
 
 #include <memory>
 
@@ -31,9 +32,8 @@ namespace nou
 		//This is called a move constructor. Among other things, move constructors
 		//are important when an object needs to be part of a container.
 		//ENTT uses a container system for components.
-		//Normally, this would be generated implicitly.
-		//Since we have a std::unique_ptr as a member, we need to tell the compiler
-		//to generate one for us.
+		//Normally, this would be generated implicitly - but since we've declared
+		//a virtual destructor, we need to tell the compiler to generate one for us.
 		//Depending on the class, you may need to write one of these yourself -
 		//See GLObjects.h for an example with the VAO class.
 		CMeshRenderer(CMeshRenderer&&) = default;
@@ -45,13 +45,25 @@ namespace nou
 
 		void SetMesh(const Mesh& mesh);
 		void SetMaterial(Material& mat);
+
+		//Draws immediately. Simple, but binds everything from scratch
+		//for every object.
 		virtual void Draw();
 
+		//Adds this object to a render queue instead, which will sort it in
+		//with everything else and skip any state that's already bound.
+		virtual void Submit(RenderQueue& queue, RenderQueue::Pass pass = RenderQueue::Pass::SOLID);
+
 		protected:
 
 		Entity* m_owner;
 		Material* m_mat;
-		std::unique_ptr<VertexArray> m_vao;
+		//The VAO lives with the mesh, so renderers drawing the same mesh share it.
+		const Mesh* m_mesh;
+
+		//The transform's global matrix, plus anything the mesh needs on top
+		//(see Mesh::GetPositionTransform).
+		glm::mat4 ModelMatrix() const;
 
 		//Having a default constructor makes it easier for us to inherit from
 		//this class later on (e.g., for a mesh renderer with skeletal animation).
@@ -25,7 +25,8 @@ namespace nou
 		//because of how ENTT manages memory.
 		//By putting the transform here and managing our own Entity objects carefully,
 		//we make sure that our pointers will be stable - which is important
-		//in a hierarchy with transforms storing pointers to parent/child objects.
+		//when other code holds on to an entity's transform.
+		//(The transform data itself lives in a TransformStore - see Transform.h.)
 		Transform transform;
 
 		static Entity Create();
@@ -0,0 +1,71 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+FrameUniforms.h
+Everything shaders need that stays the same for a whole frame (the camera,
+the lights), sent to the GPU once per frame rather than once per draw.
+
+Setting viewproj as a regular uniform means sending it again for every
+object drawn (and for every program, since uniforms belong to a program).
+Instead, it lives in a uniform buffer object (UBO) - a buffer that any
+program can read a block of uniforms from - bound once, to binding point 0:
+
+	layout(std140, binding = 0) uniform FrameBlock
+	{
+		mat4 view;
+		mat4 projection;
+		mat4 viewproj;
+		vec4 camPos;
+		vec4 lightDir;
+		vec4 lightColor;
+		vec4 ambient; //rgb is the colour, a is its power.
+	};
+
+(std140 is a standard layout, so we know exactly where everything goes
+without having to ask OpenGL. Its catch is that vec3s take up as much space
+as vec4s - which is why everything here is a vec4.)
+*/
+
+#pragma once
+
+#include "GLM/glm.hpp"
+#include "glad/glad.h"
+
+namespace nou
+{
+	class CCamera;
+
+	class FrameUniforms
+	{
+		public:
+
+		static const GLuint BINDING = 0;
+
+		~FrameUniforms() = default;
+
+		//A single directional light, plus ambient light.
+		//(Defaults match what NOU's shaders used to hard-code.)
+		static void SetLight(const glm::vec3& direction, const glm::vec3& color);
+		static void SetAmbient(const glm::vec3& color, float power);
+
+		//Sends this frame's data, with the given camera, to the GPU.
+		//RenderQueue::Begin does this for you.
+		static void Update(CCamera& camera);
+		//Same, but only if the data hasn't been sent this frame already (with this camera).
+		//Cheap enough to call before every draw.
+		static void Use(CCamera& camera);
+
+		//Marks the data as out of date. Called by App::FrameStart.
+		static void BeginFrame();
+
+		//Releases the buffer. Call while the OpenGL context is still around.
+		static void Shutdown();
+
+		protected:
+
+		//Instantiating this class doesn't make sense, since all our functionality
+		//is exposed statically.
+		FrameUniforms() = default;
+	};
+}
@@ -0,0 +1,66 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Frustum.h
+The six planes bounding what a camera can see, for culling objects
+that are entirely off screen before we bother drawing them.
+*/
+
+#pragma once
+
+#include "AABB.h"
+
+#include "GLM/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nou
+{
+	class Frustum
+	{
+		public:
+
+		enum class Result
+		{
+			OUTSIDE,
+			INTERSECTS,
+			INSIDE
+		};
+
+		//Extracts the planes from a view-projection matrix
+		//(e.g., CCamera::GetVP()). The planes end up in world space.
+		Frustum(const glm::mat4& viewProj);
+		~Frustum() = default;
+
+		//Spheres are given as (center.x, center.y, center.z, radius).
+		//A negative radius means "no bounds", which always counts as visible.
+		bool TestSphere(const glm::vec4& sphere) const;
+
+		//Tests a whole array of spheres at once, four at a time (with SSE),
+		//writing 1 (visible) or 0 (culled) for each.
+		//Returns the number of visible spheres.
+		size_t TestSpheres(const glm::vec4* spheres, size_t count, uint8_t* visible) const;
+
+		//Tests a box against the frustum. Unlike the sphere tests, this also tells
+		//us if the box is entirely inside - which, for a BVH node, means that
+		//everything below it is visible without any further testing.
+		Result TestAABB(const AABB& box) const;
+		//Same, but only against the planes whose bits (1 << plane) are set in
+		//planeMask - and clears the bits of any planes the box is entirely in
+		//front of. If a box is fully in front of a plane, so is everything inside
+		//it, so a BVH can hand the mask down and skip those planes for children.
+		Result TestAABB(const AABB& box, uint8_t& planeMask) const;
+
+		static constexpr uint8_t ALL_PLANES = 0x3F;
+
+		protected:
+
+		//Left, right, bottom, top, near, far.
+		//Each plane is (normal.x, normal.y, normal.z, distance), with normals
+		//facing inwards and normalized, so dot(plane, (p, 1)) is the signed
+		//distance of p from the plane.
+		glm::vec4 m_planes[6];
+	};
+}
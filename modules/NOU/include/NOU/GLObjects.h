@@ -13,6 +13,7 @@ You'll be learning a LOT more about this in your graphics class.
 #include <vector>
 #include <map>
 #include <string>
+#include <type_traits>
 
 #include "glad/glad.h"
 
@@ -30,6 +31,13 @@ namespace nou
 
 		template<typename T>
 		VertexBuffer(GLint elementLen, const std::vector<T>& data, bool dynamic = false)
+			: VertexBuffer(elementLen, data.data(), data.size(), dynamic)
+		{
+		}
+
+		//Same, for data that isn't in a vector (e.g., straight out of a memory-mapped file).
+		template<typename T>
+		VertexBuffer(GLint elementLen, const T* data, size_t count, bool dynamic = false)
 		{
 			m_elementLen = elementLen;
 			m_startIndex = 0;
@@ -37,7 +45,23 @@ namespace nou
 			m_dynamic = dynamic;
 
 			glGenBuffers(1, &m_id);
-			UpdateData(data);
+			UpdateData(data, (GLsizei)count, sizeof(T));
+		}
+
+		//For raw data that isn't just an array of floats (e.g., interleaved vertices,
+		//where each element is a whole vertex made up of several attributes).
+		//Such buffers are bound with the longer version of VertexArray::BindAttrib.
+		//See UpdateData for what size means.
+		VertexBuffer(const void* data, GLsizei len, GLsizei elementSize, bool dynamic = false,
+					 GLsizeiptr size = -1)
+		{
+			m_elementLen = 0;
+			m_startIndex = 0;
+			m_len = 0;
+			m_dynamic = dynamic;
+
+			glGenBuffers(1, &m_id);
+			UpdateData(data, len, elementSize, size);
 		}
 
 		~VertexBuffer()
@@ -83,13 +107,26 @@ namespace nou
 		template<typename T>
 		void UpdateData(const std::vector<T>& data)
 		{
-			m_len = (GLsizei)data.size();
-			m_elementSize = sizeof(T);
+			UpdateData(data.data(), (GLsizei)data.size(), sizeof(T));
+		}
+
+		//Uploads len elements of elementSize bytes each.
+		//When the data is one attribute out of somebody else's interleaved vertices
+		//(e.g., a glTF buffer), elementSize is the stride between them, and the last
+		//element can end before a whole stride does - so pass the number of bytes
+		//that are actually there as size, rather than reading past the end.
+		void UpdateData(const void* data, GLsizei len, GLsizei elementSize, GLsizeiptr size = -1)
+		{
+			m_len = len;
+			m_elementSize = elementSize;
+
+			if (size < 0)
+				size = (GLsizeiptr)m_len * m_elementSize;
 
 			GLenum usage = (m_dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
 
 			glBindBuffer(GL_ARRAY_BUFFER, m_id);
-			glBufferData(GL_ARRAY_BUFFER, m_len * m_elementSize, &(data[0]), usage);
+			glBufferData(GL_ARRAY_BUFFER, size, data, usage);
 		}
 
 		protected:
@@ -113,6 +150,85 @@ namespace nou
 		bool m_dynamic;
 	};
 
+	//Class for managing OpenGL index buffers (a.k.a. element buffers).
+	//Rather than spelling out every triangle's vertices in full (so that a vertex
+	//shared by six triangles gets stored, and run through the vertex shader,
+	//six times), we store each vertex once and describe the triangles with a
+	//list of indices into our vertex buffers.
+	//As with VertexBuffer, use these through pointers.
+	class IndexBuffer
+	{
+		public:
+
+		//Indices may be 8, 16, or 32-bit (GLubyte, GLushort, or GLuint).
+		//Smaller indices mean less memory, so use the smallest type
+		//that can address all of your vertices.
+		template<typename T>
+		IndexBuffer(const std::vector<T>& data)
+			: IndexBuffer(data.data(), data.size())
+		{
+		}
+
+		template<typename T>
+		IndexBuffer(const T* data, size_t count)
+		{
+			m_count = 0;
+			m_type = GL_UNSIGNED_INT;
+
+			glGenBuffers(1, &m_id);
+			UpdateData(data, count);
+		}
+
+		~IndexBuffer()
+		{
+			glDeleteBuffers(1, &m_id);
+		}
+
+		IndexBuffer(const IndexBuffer&) = delete;
+
+		//The number of indices in our buffer.
+		GLsizei Count() const { return m_count; }
+
+		//The OpenGL type of our indices (e.g., GL_UNSIGNED_SHORT).
+		GLenum Type() const { return m_type; }
+
+		GLuint GetID() const { return m_id; }
+
+		template<typename T>
+		void UpdateData(const std::vector<T>& data)
+		{
+			UpdateData(data.data(), data.size());
+		}
+
+		template<typename T>
+		void UpdateData(const T* data, size_t count)
+		{
+			static_assert(std::is_same<T, GLubyte>::value || std::is_same<T, GLushort>::value ||
+						  std::is_same<T, GLuint>::value, "Indices must be GLubyte, GLushort, or GLuint.");
+
+			m_count = (GLsizei)count;
+
+			if (sizeof(T) == 1)
+				m_type = GL_UNSIGNED_BYTE;
+			else if (sizeof(T) == 2)
+				m_type = GL_UNSIGNED_SHORT;
+			else
+				m_type = GL_UNSIGNED_INT;
+
+			//Which index buffer is bound to GL_ELEMENT_ARRAY_BUFFER is part of the
+			//currently bound VAO's state - so to avoid messing with whatever VAO
+			//happens to be bound, we upload through a different target.
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_id);
+			glBufferData(GL_COPY_WRITE_BUFFER, m_count * sizeof(T), data, GL_STATIC_DRAW);
+		}
+
+		protected:
+
+		GLuint m_id;
+		GLsizei m_count;
+		GLenum m_type;
+	};
+
 	//Class for managing OpenGL Vertex Array Objects (VAOs).
 	//Just as with VertexBuffer, as written, this class is intended to be used via pointers.
 	class VertexArray
@@ -136,6 +252,7 @@ namespace nou
 			m_drawMode = DrawMode::TRIANGLES;
 			glGenVertexArrays(1, &m_id);
 			m_len = 0;
+			m_ibo = nullptr;
 		}
 
 		~VertexArray()
@@ -240,29 +357,93 @@ namespace nou
 														 (long long)buf.ElementSize()));
 		}
 
+		//Same, but for buffers holding more than one attribute (i.e., interleaved
+		//vertices), or attributes that aren't stored as floats.
+		//The attribute is read from offset bytes into each element of the buffer.
+		//Type is the format it's stored in (e.g., GL_HALF_FLOAT, GL_SHORT) - if
+		//normalized is true, integers are mapped to [0, 1] (unsigned) or
+		//[-1, 1] (signed). Either way, the shader sees floats.
+		void BindAttrib(const VertexBuffer& buf, GLuint attribLoc, GLint components,
+						GLenum type, GLboolean normalized, size_t offset)
+		{
+			m_vbos[attribLoc] = &buf;
+
+			m_len = buf.Length();
+
+			glBindVertexArray(m_id);
+			glEnableVertexAttribArray(attribLoc);
+			glBindBuffer(GL_ARRAY_BUFFER, buf.GetID());
+			glVertexAttribPointer(attribLoc, components, type, normalized, buf.ElementSize(),
+								  reinterpret_cast<void*>(offset));
+		}
+
+		//Stops pulling data for the given attribute from a buffer.
+		void UnbindAttrib(GLuint attribLoc)
+		{
+			m_vbos.erase(attribLoc);
+
+			glBindVertexArray(m_id);
+			glDisableVertexAttribArray(attribLoc);
+		}
+
+		//Makes our draws use the given index buffer (pass nullptr to stop).
+		//The VAO remembers this, so there's no need to bind it again when drawing.
+		void SetIndexBuffer(const IndexBuffer* ibo)
+		{
+			m_ibo = ibo;
+
+			glBindVertexArray(m_id);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (ibo != nullptr) ? ibo->GetID() : 0);
+		}
+
+		const IndexBuffer* GetIndexBuffer() const { return m_ibo; }
+
 		void SetDrawMode(DrawMode drawMode)
 		{
 			m_drawMode = drawMode;
 		}
 
-		void Draw()
+		void Bind() const
 		{
+			glBindVertexArray(m_id);
+		}
+
+		//Pass false for bind if you know this VAO is already bound
+		//(e.g., when drawing several objects with the same mesh in a row).
+		//If we have an index buffer, our vertices are drawn in the order it specifies.
+		void Draw(bool bind = true)
+		{
+			if (m_vbos.empty())
+				return;
+
 			m_len = m_vbos.begin()->second->Length();
 
-			glBindVertexArray(m_id);
-			glDrawArrays((int)m_drawMode, 0, m_len);
+			if (bind)
+				glBindVertexArray(m_id);
+
+			if (m_ibo != nullptr)
+				glDrawElements((int)m_drawMode, m_ibo->Count(), m_ibo->Type(), nullptr);
+			else
+				glDrawArrays((int)m_drawMode, 0, m_len);
 		}
 
-		void DrawElements(const std::vector<GLuint>& indices, size_t count)
+		//Draws several copies of our data in one go.
+		//Shaders see baseInstance as gl_BaseInstance (see ObjectBuffer).
+		void DrawInstanced(GLsizei instances, GLuint baseInstance = 0, bool bind = true)
 		{
-			if (count == 0)
+			if (m_vbos.empty() || instances == 0)
 				return;
 
-			glBindVertexArray(m_id);
-			glDrawElements((int)m_drawMode,
-						   static_cast<GLsizei>(count),
-						   GL_UNSIGNED_INT,
-						   &(indices[0]));
+			m_len = m_vbos.begin()->second->Length();
+
+			if (bind)
+				glBindVertexArray(m_id);
+
+			if (m_ibo != nullptr)
+				glDrawElementsInstancedBaseInstance((int)m_drawMode, m_ibo->Count(), m_ibo->Type(),
+													nullptr, instances, baseInstance);
+			else
+				glDrawArraysInstancedBaseInstance((int)m_drawMode, 0, m_len, instances, baseInstance);
 		}
 
 		protected:
@@ -275,6 +456,9 @@ namespace nou
 
 		//A record of the VBOs associated with this VAO.
 		std::map<GLint, const VertexBuffer*> m_vbos;
+
+		//The index buffer our draws use (if any).
+		const IndexBuffer* m_ibo;
 	};
 }
 
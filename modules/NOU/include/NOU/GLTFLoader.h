@@ -10,8 +10,12 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 #pragma once
 
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 
+#include <memory>
 #include <string>
+#include <vector>
 
 //Forward declaration of objects defined by the tinyGLTF library.
 namespace tinygltf
@@ -22,6 +26,8 @@ namespace tinygltf
 
 namespace nou::GLTF
 {
+	//Points at one accessor's data inside a glTF buffer.
+	//Data is null if the accessor has no data of its own, or claims more than its buffer holds.
 	struct DataGetter
 	{
 		const unsigned char* data;
@@ -30,27 +36,88 @@ namespace nou::GLTF
 		int elementSize;
 	};
 
-	//Loads a 3D model into the mesh object given.
-	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY = true);
+	//Getters for everything we use from one primitive.
+	struct PrimitiveGetters
+	{
+		DataGetter indices, verts, normals, uvs;
+		bool hasNormals, hasUVs;
+	};
+
+	//Loads a 3D model (the first mesh in the file) into the mesh object given.
+	//If optimize is true, the mesh is run through the MeshOptimizer
+	//pipeline on the way (see MeshOptimizer.h).
+	//If keepCPUCopy is false, the mesh's data only lives on the GPU (see Mesh::RawData),
+	//and if optimize is false as well, it's uploaded straight from the file's buffers.
+	//The result is cached, and later loads read the cache instead (see MeshCache.h).
+	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY = true, bool optimize = true,
+				  bool keepCPUCopy = true);
+
+	//Same, but for every mesh in the file, in the order the file lists them
+	//(so a glTF mesh index is also an index into meshes).
+	//Meshes that fail to load are left empty.
+	void LoadMeshes(const std::string& filename, std::vector<std::unique_ptr<Mesh>>& meshes,
+					bool flipUVY = true, bool optimize = true, bool keepCPUCopy = true);
+
+	//Same, for a file that's already been parsed (the filename is still needed for caching).
+	void LoadMeshes(const std::string& filename, const tinygltf::Model& gltf,
+					std::vector<std::unique_ptr<Mesh>>& meshes,
+					bool flipUVY = true, bool optimize = true, bool keepCPUCopy = true);
 	
 	void DumpErrorsAndWarnings(const std::string& filename,
 							   const std::string& err,
 							   const std::string& warn);
 
 	//Parses the file with tinyGLTF.
+	//GLB files are memory mapped (see MappedFile.h) rather than read into a buffer first.
+	//Images aren't decoded - each one's Image::image holds its file (PNG, JPEG...) as is.
 	bool ParseGLTF(const std::string& filename, tinygltf::Model& gltf,
 				   std::string& err, std::string& warn);
 
-	//Takes a glTF model and extracts vertex positions, normals, and texture coordinates.
-	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
-					     std::string& err, std::string& warn);
+	//Takes one of a glTF model's meshes and extracts vertex positions, normals,
+	//texture coordinates, and the indices describing its triangles.
+	//If report isn't null, the geometry is optimized, and the results stored there.
+	//Otherwise, meshes with a single primitive go through UploadPrimitive.
+	bool ExtractGeometry(const tinygltf::Model& gltf, size_t meshIndex, Mesh& mesh,
+						 bool flipUVY, bool keepCPUCopy,
+					     std::string& err, std::string& warn,
+						 MeshOptimizer::Report* report = nullptr);
 
-	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t geomIndex, 
+	//Copies a mesh's geometry out into the arrays given (and optimizes it, if report
+	//isn't null). Doesn't touch OpenGL, so it's safe on any thread.
+	bool ExtractGeometry(const tinygltf::Model& gltf, size_t meshIndex, bool flipUVY,
+						 std::vector<glm::vec3>& verts, std::vector<glm::vec3>& normals,
+						 std::vector<glm::vec2>& uvs, std::vector<uint32_t>& indices,
+						 std::string& err, std::string& warn,
+						 MeshOptimizer::Report* report = nullptr);
+
+	//Everything LoadMesh does short of filling in a mesh (reading the cache, or parsing
+	//the file and saving it to the cache), leaving Mesh::SetData(staged.data) for the
+	//main thread. Safe on any thread - see AssetManager.
+	bool ReadMesh(const std::string& filename, MeshCache::Staged& staged, bool flipUVY, bool optimize,
+				  std::string& err, std::string& warn);
+
+	//Appends one primitive's vertices and indices to the arrays given.
+	//Indices are offset so they still point at the right vertices
+	//when several primitives end up in the same mesh.
+	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t meshIndex, size_t geomIndex,
 					      std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
-						  std::vector<glm::vec3>& normals, bool flipUVY,
-						  bool& hasNormals, bool& hasUVs,
+						  std::vector<glm::vec3>& normals, std::vector<uint32_t>& indices,
+						  bool flipUVY, bool& hasNormals, bool& hasUVs,
 						  std::string& err, std::string& warn);
 
+	//Fills the mesh from a mesh's only primitive without copying it first:
+	//accessors are handed to OpenGL right where they sit in the glTF's buffers
+	//(interleaved ones included), along with the indices in their original size.
+	//Only UVs are copied, and only if they need flipping.
+	bool UploadPrimitive(const tinygltf::Model& gltf, size_t meshIndex, Mesh& mesh,
+						 bool flipUVY, bool keepCPUCopy,
+						 std::string& err, std::string& warn);
+
+	//Finds one primitive's data, and checks that it's in a format we can use.
+	//Attributes we can't use are dropped (with a warning) - anything else is an error.
+	bool BuildPrimitiveGetters(const tinygltf::Model& gltf, size_t meshIndex, size_t geomIndex,
+							   PrimitiveGetters& getters, std::string& err, std::string& warn);
+
 	//Utility functions for more easily accessing data stored in glTF buffers.
 	int FindAccessor(const tinygltf::Primitive& geom, const std::string& name);
 	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex);
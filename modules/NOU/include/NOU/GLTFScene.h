@@ -0,0 +1,109 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+GLTFScene.h
+Imports a whole glTF scene - node hierarchy, meshes, and materials - as entities.
+
+Scene files often place the same prop (a crate, a tree...) hundreds of times,
+as nodes that all point at the same mesh. So everything heavy is loaded once
+per asset, rather than once per node:
+-Each glTF mesh becomes one Mesh, shared by every entity that uses it
+ (and loaded through the MeshCache, like GLTF::LoadMesh).
+-Materials and textures go through an AssetCache, so they're shared between
+ nodes - and between files imported with the same cache.
+Every node still gets an entity of its own, since it needs its own transform,
+but that only costs a handle and a few matrices.
+*/
+
+#pragma once
+
+#include "Entity.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "Texture.h"
+#include "TextureCache.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nou::GLTF
+{
+	//Keeps hold of textures and materials, so that anything imported twice
+	//is only loaded once. Entities refer to what's in here, so the cache
+	//has to outlive every scene imported with it.
+	class AssetCache
+	{
+		public:
+
+		//Materials without a texture use program, and those with one use texturedProgram
+		//(which should sample a texture called "albedo", like texturedlit.frag does).
+		AssetCache(const ShaderProgram& program, const ShaderProgram& texturedProgram);
+		~AssetCache() = default;
+
+		AssetCache(const AssetCache&) = delete;
+		AssetCache& operator=(const AssetCache&) = delete;
+
+		//Finds the texture with the given key (and filtering), or creates it with load
+		//if it isn't here yet. A key is anything that identifies an image, e.g., its path.
+		//Textures live in the TextureCache, so other caches (and materials loading
+		//the same file themselves) share them too - this one just holds handles.
+		TextureHandle GetTexture(const std::string& key, bool useNearest,
+								 const std::function<std::unique_ptr<Texture2D>()>& load);
+
+		//Same, for materials.
+		Material& GetMaterial(const std::string& key,
+							  const std::function<std::unique_ptr<Material>()>& create);
+
+		//Plain white and untextured, for meshes that don't have a material.
+		Material& GetDefaultMaterial();
+
+		const ShaderProgram& GetProgram(bool textured) const;
+
+		size_t GetTextureCount() const;
+		size_t GetMaterialCount() const;
+
+		//How many lookups found what they wanted already loaded, and how many had to load it.
+		size_t GetHits() const;
+		size_t GetMisses() const;
+
+		//Lets go of everything - make sure nothing is still using it!
+		void Clear();
+
+		protected:
+
+		const ShaderProgram* m_program;
+		const ShaderProgram* m_texturedProgram;
+
+		std::unordered_map<std::string, TextureHandle> m_textures;
+		std::unordered_map<std::string, std::unique_ptr<Material>> m_materials;
+		std::unique_ptr<Material> m_defaultMaterial;
+
+		size_t m_hits;
+		size_t m_misses;
+	};
+
+	//Everything a scene import creates that isn't shared through an AssetCache.
+	struct Scene
+	{
+		//One per glTF mesh, in the file's order.
+		std::vector<std::unique_ptr<Mesh>> meshes;
+		//One per node in the scene, with parents before their children.
+		std::vector<std::unique_ptr<Entity>> entities;
+		//The entities for the scene's top-level nodes.
+		std::vector<Entity*> roots;
+	};
+
+	//Imports the file's default scene (or its first, if it doesn't name one).
+	//Every node becomes an entity, parented as in the file, and nodes with a mesh
+	//get a CMeshRenderer. A glTF mesh made of several primitives is drawn with
+	//the material of the first one.
+	//The entities refer to the scene's meshes and the cache's materials, so both
+	//need to stay around for as long as the entities do.
+	//See GLTF::LoadMesh for the other options.
+	bool LoadScene(const std::string& filename, Scene& scene, AssetCache& cache,
+				   bool flipUVY = true, bool optimize = true, bool keepCPUCopy = true);
+}
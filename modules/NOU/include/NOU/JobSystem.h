@@ -0,0 +1,105 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+JobSystem.h
+A small work-stealing thread pool.
+
+Each worker thread has its own queue of jobs. Workers take new work from
+the back of their own queue (so the most recently spawned - and most
+cache-friendly - job runs first), and when they run dry, they "steal"
+from the front of somebody else's queue. This keeps everyone busy without
+every thread fighting over one shared queue.
+
+Anything that touches OpenGL has to happen on the main thread (the one
+that owns the context), so there is also a separate main-thread queue,
+which is emptied by App::FrameStart() each frame.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace nou
+{
+	class JobSystem
+	{
+		public:
+
+		using Job = std::function<void()>;
+		//Processes the range [begin, end).
+		using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+		//Tracks how many jobs (and their children) are still unfinished.
+		//Any job spawned from inside a job without its own counter is added
+		//to its parent's counter, so waiting on a counter waits for the
+		//whole family.
+		class Counter
+		{
+			public:
+
+			Counter() : m_count(0) {}
+
+			Counter(const Counter&) = delete;
+			Counter& operator=(const Counter&) = delete;
+
+			bool IsDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+			protected:
+
+			friend class JobSystem;
+			std::atomic<uint32_t> m_count;
+		};
+
+		~JobSystem() = default;
+
+		//Starts the worker threads. The calling thread becomes the "main" thread.
+		//Passing 0 uses one worker per hardware thread, minus one for the main thread.
+		//Calling this more than once does nothing.
+		static void Init(size_t numWorkers = 0);
+		//Finishes any queued jobs and joins the worker threads.
+		static void Shutdown();
+
+		//The number of worker threads (not including the main thread).
+		static size_t GetWorkerCount();
+		//0 for the main thread (or any thread outside the pool), 1..N for workers.
+		static size_t GetThreadIndex();
+		static bool IsMainThread();
+
+		//Queues a job. If counter is null, the job is added to the counter
+		//of the job we're currently running inside (if any).
+		//Without any workers (or before Init), the job just runs immediately.
+		static void Run(Job job, Counter* counter = nullptr);
+
+		//Blocks until the counter reaches zero. The waiting thread runs
+		//other jobs in the meantime rather than sitting idle.
+		//Note that this does NOT run main-thread jobs - don't wait on work that
+		//is itself waiting for the main thread.
+		static void Wait(Counter& counter);
+
+		//Splits [begin, end) into chunks of roughly grainSize and processes
+		//them in parallel, returning once every chunk is done.
+		//Passing 0 for grainSize picks a size that gives each thread a few chunks.
+		static void ParallelFor(size_t begin, size_t end, const RangeJob& job, size_t grainSize = 0);
+
+		//Queues a job to run on the main thread - e.g., uploading data to the GPU
+		//once a worker has finished loading it.
+		static void RunOnMainThread(Job job);
+		//Runs everything queued for the main thread. Call from the main thread only.
+		//Returns the number of jobs run.
+		static size_t PumpMainThread();
+
+		protected:
+
+		//Instantiating this class doesn't make sense, since all our functionality
+		//is exposed statically.
+		JobSystem() = default;
+
+		static void Execute(Job& job, Counter* counter);
+		static bool TryRunOne(size_t self);
+		static void WorkerLoop(size_t index);
+	};
+}
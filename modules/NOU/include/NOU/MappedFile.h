@@ -0,0 +1,59 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+MappedFile.h
+Read-only access to a whole file through memory mapping.
+
+Rather than copying a file into a buffer of our own (which is what reading
+through a stream does, a few bytes at a time), mapping asks the OS to make
+the file appear directly in our address space. Pages are loaded on demand
+as we touch them, straight from the OS's file cache, so there's no extra
+copy - and no need to allocate memory for the whole file up front.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace nou
+{
+	class MappedFile
+	{
+		public:
+
+		MappedFile() = default;
+		//Maps the file straight away - check IsOpen() to see if it worked.
+		MappedFile(const std::string& filename);
+		~MappedFile();
+
+		//Only one object should own a mapping, but ownership can be handed off.
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		//Maps the given file (unmapping whatever we had before).
+		//Returns false if the file couldn't be opened or mapped.
+		//An empty file opens successfully, with a null Data() and a Size() of 0.
+		bool Open(const std::string& filename);
+		void Close();
+
+		bool IsOpen() const;
+		//The file's contents. Valid until Close() (or destruction).
+		const char* Data() const;
+		size_t Size() const;
+
+		protected:
+
+		const char* m_data = nullptr;
+		size_t m_size = 0;
+		bool m_open = false;
+
+		//The file and mapping HANDLEs on Windows. Elsewhere, the file
+		//can be closed as soon as it's mapped, so these go unused.
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+	};
+}
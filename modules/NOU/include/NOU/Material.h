@@ -10,6 +10,7 @@ used by a model.
 #pragma once
 
 #include "Texture.h"
+#include "TextureCache.h"
 #include "Shader.h"
 
 #include "GLM/glm.hpp"
@@ -24,19 +25,56 @@ namespace nou
 
 		glm::vec3 m_color;
 
+		//If the program reads its matrices from the ObjectBuffer (like NOU's do),
+		//RenderQueue can draw many copies of a mesh with this material in a single call.
+		//If it has a materialIndex uniform, our colour and (first four) textures
+		//are read from the MaterialTable instead of being sent as uniforms.
 		Material(const ShaderProgram& program);
-		~Material() = default;
+		~Material();
+
+		//Our sort ID doubles as our entry in the MaterialTable, so copies can't share it.
+		Material(const Material&) = delete;
+		Material& operator=(const Material&) = delete;
 
 		//Returns true if the texture was added successfully.
 		//This will fail if you try to use more than the maximum number of textures.
 		//(Which we have set at 16 via our specification of MAX_SLOT).
+		//Programs that read textures from the MaterialTable get them in the order
+		//they were added (the first goes in slot 0, and so on) - the name isn't used.
+		//Only MaterialTable::MAX_TEXTURES fit, so adding more fails. It also fails
+		//if the texture can't go in the table (e.g., it didn't load) - the texture's
+		//slot still gets used, but shows plain white.
 		bool AddTexture(const std::string& name, const Texture2D& tex);
+		//Same, for a texture from the TextureCache. The material holds on to the handle,
+		//so the texture stays loaded for as long as the material is around.
+		bool AddTexture(const std::string& name, const TextureHandle& tex);
+		//Same, loading the texture through the TextureCache - so if another material
+		//already uses the same file (with the same filtering), they share a texture.
+		bool AddTexture(const std::string& name, const std::string& filename, bool useNearest = false);
 
 		//Should be called by the material's user before drawing the object (i.e., mesh).
+		//Equivalent to calling Bind() and then Apply().
 		void Use();
 
+		//Makes this material's shader program current.
+		void Bind() const;
+		//Sends this material's colour and textures to the current program.
+		//If several objects in a row use the same material, this only needs
+		//to be done once for all of them.
+		void Apply() const;
+
+		const ShaderProgram& GetProgram() const;
+
+		//A small number identifying this material, used by RenderQueue
+		//to group draws using the same material together.
+		//(At most 65536 materials can exist at once - creating another throws.)
+		uint16_t GetSortID() const;
+
 		protected:
 
+		//Whether another texture fits (complaining if it's the table that's full).
+		bool HasRoomFor(const std::string& name) const;
+
 		//Small utility struct for managing how and where OpenGL will deal with our texture(s).
 		struct TexUniform
 		{
@@ -49,6 +87,19 @@ namespace nou
 		static const GLenum MAX_SLOT = GL_TEXTURE15;
 
 		std::vector<TexUniform> m_tex;
+		//Keeps cached textures we use from being evicted.
+		std::vector<TextureHandle> m_handles;
 		const ShaderProgram* m_program;
+
+		uint16_t m_sortID;
+		//Our sort ID is also our MaterialTable entry, so two live materials can't share one.
+		//IDs of destroyed materials are handed out again before any new ones.
+		static uint32_t m_nextSortID;
+		static std::vector<uint16_t> m_freeSortIDs;
+
+		//Where the program wants our index in the MaterialTable (-1 if it doesn't use it),
+		//and the colour last sent there.
+		GLint m_tableLoc;
+		mutable glm::vec3 m_tableColor;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+MaterialTable.h
+Keeps every material's colour and textures in one big GPU buffer, so that
+switching materials doesn't mean binding any textures.
+
+The usual way to give a shader a texture is to bind it to a texture unit,
+and point a sampler uniform at that unit - for every texture, every time
+the material changes. Instead, each material gets an entry (indexed by its
+sort ID) in a shader storage buffer, and shaders find everything they need
+there, given just the material's index:
+
+	layout(std430, binding = 0) buffer MaterialBlock { MaterialData materials[]; };
+	uniform uint materialIndex;
+
+Textures are stored in one of two ways, depending on what the driver supports:
+-With GL_ARB_bindless_texture, as "bindless" handles - 64-bit numbers that
+ the shader can turn straight into a sampler, no texture unit involved.
+-Otherwise, each texture is copied into a layer of a texture array shared by
+ all textures of the same size and format (a "page"). The pages are bound
+ once, to units 16 and up, and the entry holds the page and layer to use.
+ (This does mean the texture takes up its memory twice.)
+Shaders can tell which one they're getting from whether the extension's
+macro is defined - see texturedlit.frag.
+
+Material uses the table automatically if its program has a materialIndex
+uniform. Materials whose programs don't have one send their colour and
+textures as plain uniforms instead, and their entry is simply never read.
+*/
+
+#pragma once
+
+#include "Texture.h"
+
+#include "GLM/glm.hpp"
+#include "glad/glad.h"
+
+#include <cstdint>
+
+namespace nou
+{
+	class MaterialTable
+	{
+		public:
+
+		//Textures per material, in the order they were added to it.
+		static const int MAX_TEXTURES = 4;
+		//Where the material buffer is bound (as a shader storage buffer).
+		static const GLuint BINDING = 0;
+		//Texture pages (when bindless textures aren't supported) are bound
+		//to units FIRST_PAGE_UNIT through FIRST_PAGE_UNIT + MAX_PAGES - 1.
+		static const GLuint FIRST_PAGE_UNIT = 16;
+		static const int MAX_PAGES = 8;
+
+		~MaterialTable() = default;
+
+		static bool IsBindless();
+
+		static void SetColor(uint16_t material, const glm::vec3& color);
+		//Returns false if the slot is out of range, or the texture can't be stored
+		//(e.g., an empty texture, or too many different sizes and formats for the pages),
+		//in which case the slot is left as it was.
+		static bool SetTexture(uint16_t material, int slot, const Texture2D& tex);
+		//A 1x1 plain white texture. Every slot without a texture (not set yet,
+		//cleared, or its texture couldn't be stored) samples this instead,
+		//so shaders never sample a texture that isn't there.
+		static const Texture2D& GetDefaultTexture();
+		//Clears the material's entry (letting go of any texture pages it used),
+		//leaving every slot with the default texture.
+		static void Remove(uint16_t material);
+
+		//Called when a texture is deleted (by ~Texture2D). Any material still using it
+		//gets the default texture instead, and its bindless handle is made non-resident
+		//(deleting a texture with a resident handle isn't allowed).
+		static void ForgetTexture(GLuint texture);
+
+		//Sends any changes to the GPU, and binds the table (if it isn't already).
+		//Material::Apply does this for you.
+		static void Bind();
+
+		//Releases the buffer, pages, default texture, and every resident handle.
+		//Call while the OpenGL context is still around.
+		static void Shutdown();
+
+		protected:
+
+		//Instantiating this class doesn't make sense, since all our functionality
+		//is exposed statically.
+		MaterialTable() = default;
+
+		//Where empty slots point - the default texture's handle, or its page and layer.
+		static glm::uvec2 GetDefaultLocation();
+
+		//Makes the texture's bindless handle resident (if it isn't already), returning
+		//it as (low, high) bits. Every call needs a matching ReleaseTexture.
+		static bool AddResident(GLuint texture, glm::uvec2& location);
+		//Lets go of one slot's use of the texture (its handle, or its page copy).
+		static void ReleaseTexture(GLuint texture);
+
+		//Finds (or makes) room for a copy of the texture in a page, returning (page, layer).
+		static bool AddToPage(const Texture2D& tex, glm::uvec2& location);
+		static void RemoveFromPage(GLuint texture);
+	};
+}
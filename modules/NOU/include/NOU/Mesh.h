@@ -12,6 +12,7 @@ Very basic class for managing the data associated with a 3D model.
 
 #include "GLM/glm.hpp"
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <map>
@@ -34,47 +35,246 @@ namespace nou
 			SKIN_WEIGHT = 4
 		};
 
-		Mesh() = default;
+		//How vertex data is stored on the GPU.
+		enum class VertexFormat
+		{
+			//One buffer per attribute, all 32-bit floats (32 bytes per vertex
+			//with positions, normals, and UVs). Works with any shader.
+			FLOAT,
+			//One interleaved buffer (so a vertex is one contiguous read), with:
+			//-Positions as 32-bit floats.
+			//-Normals octahedral-encoded into two 16-bit integers.
+			//-UVs as 16-bit integers (if they're all in [0, 1]) or half floats.
+			//20 bytes per vertex. Needs a *_compressed.vert shader, which
+			//decodes the normals.
+			COMPRESSED,
+			//Same as COMPRESSED, but with positions stored as half floats,
+			//relative to the mesh's bounds. 16 bytes per vertex (12 without UVs).
+			//Half floats have about 3 significant digits, so this is best
+			//kept for small or distant objects. See GetPositionTransform.
+			COMPRESSED_HALF_POSITIONS
+		};
+
+		//Everything needed to fill in a mesh in one go, pointing at memory
+		//owned by somebody else (e.g., a memory-mapped MeshCache file, or a glTF buffer).
+		//Normals and UVs may be null, and indices may be 8, 16, or 32-bit.
+		struct RawData
+		{
+			const glm::vec3* verts = nullptr;
+			const glm::vec3* normals = nullptr;
+			const glm::vec2* uvs = nullptr;
+			size_t vertCount = 0;
+
+			//Bytes from one vertex's attribute to the next, for attributes that are
+			//interleaved with other data. 0 means tightly packed.
+			size_t vertStride = 0;
+			size_t normalStride = 0;
+			size_t uvStride = 0;
+
+			const void* indices = nullptr;
+			size_t indexCount = 0;
+			size_t indexSize = sizeof(uint32_t);
+
+			//Bounds worked out ahead of time, so we don't need to go through
+			//every vertex again to find them.
+			//If computeBounds is true, these are ignored and found from the vertices instead.
+			glm::vec3 boundsMin = glm::vec3(0.0f);
+			glm::vec3 boundsMax = glm::vec3(0.0f);
+			glm::vec4 boundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+			bool computeBounds = false;
+
+			//Whether to keep our usual copy of the data on the CPU. Without it, the
+			//data only lives on the GPU - which saves memory (and a copy), but the
+			//vertex format can't be changed afterwards, and the mesh can't be cached.
+			bool keepCPUCopy = true;
+		};
+
+		Mesh();
 		virtual ~Mesh() = default;
 
+		//Changes how our vertex data is stored on the GPU. The data is re-uploaded
+		//(we keep a copy on the CPU), and the mesh's VAO is updated to match.
+		//Does nothing if the data was set without a CPU copy (see RawData).
+		void SetVertexFormat(VertexFormat format);
+		VertexFormat GetVertexFormat() const;
+		//Size of one vertex on the GPU, in bytes.
+		size_t GetVertexSize() const;
+
+		//Half float positions are stored relative to the mesh's bounds (so that
+		//they fall in [-1, 1], where half floats are most precise). This matrix
+		//takes them back to model space - renderers multiply it onto the end of
+		//the model matrix. Identity for other formats.
+		const glm::mat4& GetPositionTransform() const;
+		bool HasPositionTransform() const;
+
 		void SetVerts(const std::vector<glm::vec3>& verts);
 		void SetNormals(const std::vector<glm::vec3>& normals);
 		void SetUVs(const std::vector<glm::vec2>& uvs);
+		//Sets the triangles of the mesh as indices into the vertex data.
+		//Without indices, every three vertices make a triangle (i.e., vertices
+		//shared between triangles have to be repeated).
+		//On the GPU, indices are stored in 16 bits when they fit.
+		void SetIndices(const std::vector<uint32_t>& indices);
+
+		const std::vector<uint32_t>& GetIndices() const;
+
+		const std::vector<glm::vec3>& GetVerts() const;
+		const std::vector<glm::vec3>& GetNormals() const;
+		const std::vector<glm::vec2>& GetUVs() const;
+
+		//Replaces all of our vertex and index data at once. With the FLOAT
+		//format, the GPU buffers are filled straight from the memory given
+		//(strides and all), and the CPU copy is only made if asked for.
+		void SetData(const RawData& data);
+
+		//False if the last SetData skipped the CPU copy, in which case
+		//GetVerts and co. return empty arrays.
+		bool HasCPUCopy() const;
 
 		//Fetches a vertex buffer associated with the desired attribute.
 		//Used by mesh rendering components to grab the requisite data
 		//associated with this model in OpenGL.
+		//(For compressed formats, this is the one interleaved buffer holding everything.)
 		const VertexBuffer* GetVBO(Attrib attrib) const;
 
+		//Bounds of the mesh in model space, updated whenever SetVerts is called.
+		//The sphere is (center, radius) - with a negative radius if the mesh is empty.
+		const glm::vec3& GetBoundsMin() const;
+		const glm::vec3& GetBoundsMax() const;
+		const glm::vec4& GetBoundingSphere() const;
+
+		//Fetches a vertex array with all of this mesh's buffers bound.
+		//Renderers drawing the same mesh share this, so drawing several
+		//copies of a mesh in a row only needs one VAO bind.
+		//Returns nullptr if the mesh has no data yet.
+		VertexArray* GetVAO() const;
+
+		//A small number identifying this mesh, used by RenderQueue
+		//to group draws of the same mesh together.
+		uint16_t GetSortID() const;
+
+		//Works out the bounds of count vertices, stride bytes apart (0 for tightly packed),
+		//the same way SetVerts does. Doesn't touch OpenGL, so it's safe on any thread
+		//(e.g., for loaders filling in RawData ahead of time).
+		static void ComputeBounds(const glm::vec3* verts, size_t count, size_t stride,
+								  glm::vec3& boundsMin, glm::vec3& boundsMax, glm::vec4& boundingSphere);
+
 		protected:
 
 		std::vector<glm::vec3> m_verts;
 		std::vector<glm::vec3> m_normals;
 		std::vector<glm::vec2> m_uvs;
+		std::vector<uint32_t> m_indices;
 
+		glm::vec3 m_boundsMin;
+		glm::vec3 m_boundsMax;
+		glm::vec4 m_boundingSphere;
+
+		void ComputeBounds();
+
+		bool m_hasCPUCopy;
+
+		VertexFormat m_format;
 		std::map<Attrib, std::unique_ptr<VertexBuffer>> m_vbo;
+		//Used instead of m_vbo for compressed formats.
+		std::unique_ptr<VertexBuffer> m_interleaved;
+		glm::mat4 m_positionTransform;
+
+		//Packs our vertex data into m_interleaved, and points the VAO at it.
+		void UploadInterleaved();
+		//Gets rid of every vertex buffer (and unbinds them from our VAO).
+		void ClearVBOs();
+		std::unique_ptr<IndexBuffer> m_ibo;
+		std::unique_ptr<VertexArray> m_vao;
+
+		uint16_t m_sortID;
+		static uint16_t m_nextSortID;
+
+		//Uploads our indices (in whichever format the caller picked).
+		template<typename T>
+		void SetIBO(const std::vector<T>& data)
+		{
+			SetIBO(data.data(), data.size());
+		}
+
+		template<typename T>
+		void SetIBO(const T* data, size_t count)
+		{
+			if (m_ibo == nullptr)
+				m_ibo = std::make_unique<IndexBuffer>(data, count);
+			else
+				m_ibo->UpdateData(data, count);
+
+			if (m_vao == nullptr)
+				m_vao = std::make_unique<VertexArray>();
+
+			m_vao->SetIndexBuffer(m_ibo.get());
+		}
 
 		//Sets up a VertexBuffer for the desired attribute.
 		template<typename T>
 		void SetVBO(Attrib attrib, GLint elementLen, const std::vector<T>& data)
+		{
+			SetVBO(attrib, elementLen, data.data(), data.size());
+		}
+
+		//Stride is the number of bytes from one element to the next, if the data
+		//is interleaved with something else (0 means tightly packed).
+		template<typename T>
+		void SetVBO(Attrib attrib, GLint elementLen, const T* data, size_t count, size_t stride = 0)
 		{
 			//We shouldn't be trying to send an empty array!
 			//A VBO with no data would just lead to memory access errors.
-			if (data.size() == 0)
+			if (count == 0)
 			{
+				if (m_vao != nullptr)
+					m_vao->UnbindAttrib((GLuint)attrib);
+
 				m_vbo.erase(attrib);
 				return;
 			}
 
+			if (stride == 0)
+				stride = sizeof(T);
+
+			//The last element ends sizeof(T) bytes in, not a whole stride.
+			GLsizeiptr size = (GLsizeiptr)((count - 1) * stride + sizeof(T));
+
 			auto it = m_vbo.find(attrib);
 
+			//The stride is baked into the VAO when a buffer is bound,
+			//so if it's changed, we start over with a new buffer.
+			if (it != m_vbo.end() && it->second->ElementSize() != (GLsizei)stride)
+			{
+				m_vbo.erase(it);
+				it = m_vbo.end();
+			}
+
 			//If our VBO does not already exist, make a new one.
 			if (it == m_vbo.end())
-				m_vbo.insert({attrib,
-					std::make_unique<VertexBuffer>(elementLen, data)});
+			{
+				if (m_vao == nullptr)
+					m_vao = std::make_unique<VertexArray>();
+
+				std::unique_ptr<VertexBuffer> vbo;
+
+				if (stride == sizeof(T))
+				{
+					vbo = std::make_unique<VertexBuffer>(elementLen, data, count);
+					m_vao->BindAttrib(*vbo, (GLuint)attrib);
+				}
+				else
+				{
+					vbo = std::make_unique<VertexBuffer>(data, (GLsizei)count, (GLsizei)stride, false, size);
+					m_vao->BindAttrib(*vbo, (GLuint)attrib, elementLen, GL_FLOAT, GL_FALSE, 0);
+				}
+
+				m_vbo.insert({ attrib, std::move(vbo) });
+			}
 			//If our VBO does exist, update it with the new data specified.
+			//(The VAO refers to the buffer itself, so it doesn't need to change.)
 			else
-				it->second->UpdateData(data);
+				it->second->UpdateData(data, (GLsizei)count, (GLsizei)stride, size);
 		}
 	};
 }
\ No newline at end of file
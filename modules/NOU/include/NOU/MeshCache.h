@@ -0,0 +1,145 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+MeshCache.h
+Saves loaded meshes in a compact binary format, so that the next run can
+skip parsing (and optimizing) them all over again.
+
+A cache file is laid out as:
+
+	[Header][Stream x streamCount][payload]
+
+The header says which source file (and loader options) the mesh came from,
+plus the source's size and modification time when it was cached - if any of
+those have changed, the cache is out of date and gets ignored. The streams
+describe the vertex layout: which attribute each blob of the payload holds,
+and in what format. The payload itself is the vertex data, then the indices,
+exactly as they're sent to the GPU - so loading is just mapping the file
+(see MappedFile.h) and handing pointers to OpenGL.
+
+For glTF files, the same goes for any buffers kept in separate files
+(e.g., a .gltf's .bin) - changing just the .bin still invalidates the cache.
+
+The payload can optionally be gzipped, which makes files much smaller but
+means decompressing them on load, rather than reading them in place.
+
+Everything is stored in the machine's own byte order, since a cache is only
+ever read back on the machine that wrote it.
+*/
+
+#pragma once
+
+#include "Mesh.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nou::MeshCache
+{
+	//Bump this whenever the file layout (or what a loader writes) changes,
+	//so that old cache files are ignored rather than misread.
+	constexpr uint32_t VERSION = 1;
+
+	constexpr uint32_t FLAG_GZIP = 1 << 0;
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+
+		//Identifies the source - a hash of its path, the loader options used, and
+		//the size and modification time of any buffer files it refers to -
+		//along with its own size and last modification time when it was cached.
+		uint64_t key;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+
+		uint32_t flags;
+		uint32_t streamCount;
+
+		uint32_t vertCount;
+		uint32_t indexCount;
+		//Size of one index in bytes (2 or 4).
+		uint32_t indexSize;
+		uint32_t padding;
+
+		float boundsMin[3];
+		float boundsMax[3];
+		float boundingSphere[4];
+
+		//Where the indices start in the payload, and the size of the whole
+		//payload - before compression, and as stored in the file.
+		uint64_t indexOffset;
+		uint64_t payloadSize;
+		uint64_t storedSize;
+	};
+
+	//One vertex attribute's blob in the payload.
+	struct Stream
+	{
+		//A Mesh::Attrib, e.g., POSITION.
+		uint32_t attrib;
+		//Components per vertex, and their OpenGL type (e.g., 3 x GL_FLOAT).
+		uint32_t components;
+		uint32_t type;
+		uint32_t stride;
+		uint64_t offset;
+	};
+
+	//A mesh that's been read (from the cache, or by a loader) but not sent to the GPU yet.
+	//Reading doesn't touch OpenGL, so it can happen on a worker thread, leaving only
+	//Mesh::SetData(staged.data) for the main thread. Owns whatever data points at.
+	struct Staged
+	{
+		Mesh::RawData data;
+
+		//For data read from a cache file.
+		MappedFile file;
+		std::vector<char> payload;
+
+		//For data from a loader (see StageGeometry).
+		std::vector<glm::vec3> verts;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> uvs;
+		std::vector<uint32_t> indices;
+		std::vector<uint16_t> shortIndices;
+	};
+
+	//Cache files go here. Relative paths are relative to the working directory.
+	//The directory is created when the first file is saved.
+	void SetDirectory(const std::string& directory);
+	const std::string& GetDirectory();
+
+	//Turns the cache off (or back on) for every loader.
+	void SetEnabled(bool enabled);
+	bool IsEnabled();
+
+	//Whether new cache files are gzipped (off by default).
+	void SetCompression(bool compress);
+
+	//Where the cache file for a source and set of loader options lives.
+	//Options are whatever flags the loader needs to tell apart different
+	//results from the same file (e.g., flipping UVs).
+	std::string GetCachePath(const std::string& source, uint32_t options);
+
+	//Fills the mesh from the cache, if it has an up-to-date copy of the source.
+	//Returns false (leaving the mesh alone) if not.
+	//See Mesh::RawData for keepCPUCopy.
+	bool Load(const std::string& source, uint32_t options, Mesh& mesh, bool keepCPUCopy = true);
+
+	//Everything Load does, short of filling in a mesh - so unlike Load, it's safe on any thread.
+	bool Read(const std::string& source, uint32_t options, Staged& staged);
+
+	//Points staged.data at the geometry in staged's arrays (with 16-bit indices
+	//when they fit, as Mesh::SetIndices would), and works out its bounds.
+	void StageGeometry(Staged& staged);
+
+	//Writes the mesh's data to the cache for the source.
+	bool Save(const std::string& source, uint32_t options, const Mesh& mesh);
+	//Same, for data that isn't in a mesh (yet). Safe on any thread.
+	//Vertex data has to be tightly packed.
+	bool Save(const std::string& source, uint32_t options, const Mesh::RawData& data);
+}
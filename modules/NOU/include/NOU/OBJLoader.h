@@ -0,0 +1,67 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+OBJLoader.h
+Utility functions for loading models in the Wavefront OBJ format.
+
+OBJ is plain text, and scanned models can easily run to hundreds of MB of it,
+so this loader is built for speed rather than simplicity:
+-The file is memory mapped (see MappedFile.h), rather than streamed.
+-Lines are scanned by hand, and numbers are converted with std::from_chars,
+ which skips all the locale and formatting machinery behind operator>>.
+-Big files are split into chunks (on line boundaries) which are parsed in
+ parallel on the JobSystem, then stitched back together.
+
+Face corners that share the same position, UV, and normal are welded into
+a single vertex, so the result is always indexed.
+Materials (mtllib/usemtl), groups, and smoothing groups are ignored.
+*/
+
+#pragma once
+
+#include "Mesh.h"
+#include "MeshCache.h"
+
+#include "GLM/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nou::OBJ
+{
+	//Welded geometry, with one entry per vertex in each array, and three
+	//indices per triangle. Normals and UVs are left empty if the file
+	//didn't use any (vertices missing them when others have them get
+	//(0, 0, 1) and (0, 0) respectively).
+	struct Geometry
+	{
+		std::vector<glm::vec3> verts;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> uvs;
+		std::vector<uint32_t> indices;
+	};
+
+	//Files smaller than this are parsed in one piece - splitting them up
+	//would cost more than it saves.
+	constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+	//Loads a 3D model into the mesh object given.
+	//If optimize is true, the mesh is run through the MeshOptimizer
+	//pipeline on the way (see MeshOptimizer.h).
+	//The result is cached, and later loads read the cache instead (see MeshCache.h).
+	void LoadMesh(const std::string& filename, Mesh& mesh, bool optimize = true);
+
+	//Everything LoadMesh does short of filling in a mesh, leaving Mesh::SetData(staged.data)
+	//for the main thread. Safe on any thread - see AssetManager.
+	bool ReadMesh(const std::string& filename, MeshCache::Staged& staged, bool optimize, std::string& err);
+
+	//Maps and parses a whole file.
+	bool ParseFile(const std::string& filename, Geometry& geom, std::string& err);
+
+	//Parses OBJ text that's already in memory.
+	//Polygons with more than three corners are split into triangle fans.
+	bool Parse(const char* text, size_t len, Geometry& geom, std::string& err);
+}
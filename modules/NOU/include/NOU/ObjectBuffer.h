@@ -0,0 +1,94 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+ObjectBuffer.h
+A ring of per-object data (model and normal matrices) that shaders read
+from a storage buffer, instead of having the matrices set as uniforms
+before every draw.
+
+Each frame, every object drawn gets an entry written into the ring, and the
+shader finds its entry by index:
+
+	layout(std430, binding = 1) readonly buffer ObjectBlock { ObjectData objects[]; };
+	...
+	ObjectData obj = objects[gl_BaseInstance + gl_InstanceID];
+
+The index comes in through the draw call's base instance (which is why
+everything drawn this way is drawn "instanced", even if it's only one
+copy) - so a run of objects with the same mesh and material is a single
+draw, and a single object costs no uniform updates at all.
+
+Like TextureUploader, the ring stays mapped for as long as the program runs,
+and we write straight into it. Each frame's stretch of the ring is fenced off,
+so it isn't written over until the GPU is done drawing with it. Persistent
+mapping (and gl_BaseInstance in the shaders) need OpenGL 4.6.
+*/
+
+#pragma once
+
+#include "GLM/glm.hpp"
+#include "glad/glad.h"
+
+#include <cstddef>
+
+namespace nou
+{
+	//One object's entry. Laid out as std430 wants it: a mat3's
+	//columns are padded to vec4s.
+	struct ObjectData
+	{
+		glm::mat4 model;
+		glm::vec4 normal[3];
+
+		void Set(const glm::mat4& modelMat, const glm::mat3& normalMat)
+		{
+			model = modelMat;
+
+			for (int i = 0; i < 3; ++i)
+				normal[i] = glm::vec4(normalMat[i], 0.0f);
+		}
+	};
+
+	class ObjectBuffer
+	{
+		public:
+
+		static const GLuint BINDING = 1;
+
+		~ObjectBuffer() = default;
+
+		//Size of the ring in objects (65536 by default - about 7 MB).
+		//Changes take effect the next time the ring is created (i.e., after Shutdown()).
+		static void SetCapacity(size_t objects);
+		static size_t GetCapacity();
+
+		//Makes room for count entries (at most the capacity), returning the index
+		//of the first one (to draw with as the base instance), and where to write them.
+		//Returns false if the ring couldn't be created (which is reported once) - in which
+		//case there's no way to draw with an ObjectBlock shader, so don't. Main thread only.
+		//Issue the draws reading the entries before allocating any more: once the ring
+		//wraps around, entries are only protected by fences placed after their draws.
+		static bool Allocate(size_t count, GLuint& first, ObjectData*& data);
+
+		//Fences off last frame's entries. Called by App::FrameStart.
+		static void BeginFrame();
+
+		//How many times we had to wait for the GPU to finish with entries
+		//before writing over them (i.e., the ring was too small for a frame or two).
+		static size_t GetStallCount();
+
+		//Releases the ring. Call while the OpenGL context is still around.
+		static void Shutdown();
+
+		protected:
+
+		//Instantiating this class doesn't make sense, since all our functionality
+		//is exposed statically.
+		ObjectBuffer() = default;
+
+		static bool CreateRing();
+		//Fences off everything written since the last fence.
+		static void Close();
+	};
+}
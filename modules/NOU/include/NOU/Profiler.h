@@ -0,0 +1,30 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Profiler.h
+A small ImGui overlay showing how the frame (and the framework's
+caches and streaming) is doing.
+*/
+
+#pragma once
+
+namespace nou
+{
+	class Profiler
+	{
+		public:
+
+		~Profiler() = default;
+
+		//Draws the overlay in the top left corner of the window.
+		//Call between App::StartImgui() and App::EndImgui().
+		static void DrawOverlay();
+
+		protected:
+
+		//Instantiating this class doesn't make sense, since all our functionality
+		//is exposed statically.
+		Profiler() = default;
+	};
+}
@@ -0,0 +1,159 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+RenderQueue.h
+Collects draw calls for a frame, sorts them, and submits them with as
+few OpenGL state changes as possible.
+
+Switching shader programs, textures, and vertex arrays is some of the most
+expensive stuff a renderer does. If we draw objects in whatever order they
+happen to be in, we end up re-binding the same few programs and materials
+over and over. Instead, every draw gets a 64-bit "sort key" that packs
+together everything we care about, from most to least important:
+
+	[pass:4][program:12][material:16][mesh:16][depth:16]
+
+Sorting by that key puts draws sharing a program next to each other, and
+within those, draws sharing a material, and so on - so when we submit,
+we only touch state that actually differs from the previous draw.
+(Blended, i.e. transparent, draws are the exception - they have to go
+back-to-front, so their depth moves up to just below the pass.)
+
+Once sorted, copies of the same mesh with the same material end up right
+next to each other, and each such run is collapsed into a single instanced
+draw call:
+-If the material's program reads its matrices from the ObjectBuffer, they're
+ written there, and the run is drawn with that same program. (Even a lone
+ object is drawn this way, since it saves setting any uniforms.)
+-Otherwise, each object is drawn on its own, with its matrices as uniforms.
+The camera and lights go to FrameUniforms once, in Begin().
+*/
+
+#pragma once
+
+#include "Material.h"
+#include "GLObjects.h"
+
+#include "GLM/glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace nou
+{
+	class CCamera;
+
+	class RenderQueue
+	{
+		public:
+
+		//(Not OPAQUE/TRANSPARENT - Windows headers #define both of those.)
+		enum class Pass
+		{
+			SOLID = 0,
+			BLENDED = 1
+		};
+
+		//What the last Flush() actually did, versus what drawing every object
+		//on its own (as CMeshRenderer::Draw does) would have cost.
+		struct Stats
+		{
+			//Objects submitted, and draw calls actually made for them.
+			size_t objects = 0;
+			size_t draws = 0;
+
+			//Draw calls that were instanced, and how many objects they covered.
+			size_t instancedDraws = 0;
+			size_t instances = 0;
+
+			size_t programBinds = 0;
+			size_t programBindsAvoided = 0;
+
+			size_t materialBinds = 0;
+			size_t materialBindsAvoided = 0;
+
+			size_t meshBinds = 0;
+			size_t meshBindsAvoided = 0;
+		};
+
+		RenderQueue();
+		~RenderQueue() = default;
+
+		//Runs of at least this many draws sharing a mesh and material
+		//are drawn instanced (if the material's program uses the ObjectBuffer).
+		//Set to 0 to turn instancing off.
+		void SetMinInstances(size_t minInstances);
+
+		//Starts a new frame. The camera is used for depth sorting, and
+		//is sent to FrameUniforms (or as the viewproj uniform, to programs
+		//that don't use them).
+		void Begin(CCamera& camera);
+
+		//Queues up one draw. The transform matrices are copied, so the
+		//caller is free to change them before Flush().
+		void Submit(Material& mat, VertexArray& vao, uint16_t meshID,
+					const glm::mat4& model, const glm::mat3& normal,
+					Pass pass = Pass::SOLID);
+
+		//Sorts and draws everything submitted since Begin(), then empties the queue.
+		void Flush();
+
+		const Stats& GetStats() const;
+		size_t Size() const;
+
+		protected:
+
+		struct DrawItem
+		{
+			Material* mat;
+			VertexArray* vao;
+			glm::mat4 model;
+			glm::mat3 normal;
+		};
+
+		struct SortEntry
+		{
+			uint64_t key;
+			uint32_t item;
+		};
+
+		//How a batch is drawn (see the top of this file).
+		enum class BatchMode
+		{
+			OBJECT_BUFFER,
+			SINGLE
+		};
+
+		//A run of sorted draws sharing a mesh and material.
+		//Instanced batches draw all of them at once, others one object at a time.
+		struct Batch
+		{
+			size_t first;
+			size_t count;
+			BatchMode mode;
+			bool instanced;
+		};
+
+		std::vector<DrawItem> m_items;
+		std::vector<SortEntry> m_keys;
+		//Scratch space for the radix sort, kept around between frames.
+		std::vector<SortEntry> m_sortBuffer;
+
+		glm::mat4 m_view = glm::mat4(1.0f);
+		glm::mat4 m_viewProj = glm::mat4(1.0f);
+
+		std::vector<Batch> m_batches;
+
+		size_t m_minInstances;
+
+		Stats m_stats;
+
+		void Sort();
+		void BuildBatches();
+		//Writes the batch's matrices to the ObjectBuffer, and draws it.
+		void DrawObjects(const Batch& batch);
+		//Draws [first, end) one at a time, with their matrices as uniforms.
+		void DrawSingles(size_t first, size_t end);
+	};
+}
@@ -8,8 +8,12 @@ Utility classes for managing OpenGL shaders and shader programs.
 
 #pragma once
 
+#include "UniformID.h"
+
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "glad/glad.h"
@@ -62,24 +66,113 @@ namespace nou
 		//Fetches the shader program currently in use.
 		static const ShaderProgram* Current();
 
+		//A small number identifying this program, used by RenderQueue
+		//to group draws using the same program together.
+		uint16_t GetSortID() const;
+
+		//What the program's uniforms and blocks look like, as found when it's
+		//linked. Uniforms inside blocks aren't listed - they don't get locations.
+		struct UniformInfo
+		{
+			//Arrays go by their plain name, e.g., "bones" rather than "bones[0]".
+			std::string name;
+			GLint location;
+			//e.g., GL_FLOAT_MAT4 or GL_SAMPLER_2D.
+			GLenum type;
+			GLint arraySize;
+			//The texture unit a sampler reads from (-1 for anything else).
+			GLint unit;
+		};
+
+		struct BlockInfo
+		{
+			std::string name;
+			//GL_UNIFORM_BLOCK or GL_SHADER_STORAGE_BLOCK.
+			GLenum blockType;
+			GLint binding;
+			GLint size;
+		};
+
+		const std::vector<UniformInfo>& GetUniforms() const;
+		const std::vector<BlockInfo>& GetBlocks() const;
+
+		//Null if the program has no (active) uniform or block by that name.
+		const UniformInfo* FindUniform(UniformID id) const;
+		const BlockInfo* FindBlock(UniformID id) const;
+
+		//Whether the program reads the camera and lights from FrameUniforms (i.e., has
+		//a FrameBlock), and matrices from the ObjectBuffer (i.e., has an ObjectBlock).
+		//If not, they're expected as plain uniforms (viewproj, model, normal).
+		bool UsesFrameUniforms() const;
+		bool UsesObjectBuffer() const;
+
 		//Utility functions for managing uniforms - variables
 		//we send to the shader that persist until we change them.
+		//Prefer the UniformID versions (e.g., "model"_u) for anything you set often -
+		//they're just a lookup in the table we built at link time.
+		//A uniform the program doesn't have gets location -1, which GL ignores.
+		GLint GetUniformLoc(UniformID id) const;
+		//Names that aren't in the table (e.g., "lights[2].color") are asked of GL
+		//instead. The answer is remembered, so the UniformID versions find them too
+		//from then on.
 		GLint GetUniformLoc(const std::string& name) const;
 
 		template<typename T>
-		void SetUniform(const std::string& name, const T& value) const;
+		void SetUniform(GLint loc, const T& value) const;
+
+		template<typename T>
+		void SetUniform(UniformID id, const T& value) const
+		{
+			SetUniform(GetUniformLoc(id), value);
+		}
+
+		template<typename T>
+		void SetUniform(const std::string& name, const T& value) const
+		{
+			SetUniform(GetUniformLoc(name), value);
+		}
+
+		template<typename T>
+		void SetUniformArray(GLint loc, T* data, int len) const;
 
 		template<typename T>
-		void SetUniformArray(const std::string& name, T* data, int len) const;
+		void SetUniformArray(UniformID id, T* data, int len) const
+		{
+			SetUniformArray(GetUniformLoc(id), data, len);
+		}
+
+		template<typename T>
+		void SetUniformArray(const std::string& name, T* data, int len) const
+		{
+			SetUniformArray(GetUniformLoc(name), data, len);
+		}
 
 		protected:
 
 		//The OpenGL ID of our shader program.
 		GLuint m_id;
 
+		uint16_t m_sortID;
+		static uint16_t m_nextSortID;
+
+		std::vector<UniformInfo> m_uniforms;
+		std::vector<BlockInfo> m_blocks;
+
+		//Name hashes to indices in m_uniforms and m_blocks.
+		std::unordered_map<uint32_t, size_t> m_uniformLookup;
+		std::unordered_map<uint32_t, size_t> m_blockLookup;
+		//Locations GL gave us for names that weren't in m_uniforms (-1 included).
+		mutable std::unordered_map<uint32_t, GLint> m_extraLocs;
+
+		bool m_usesFrameUniforms;
+		bool m_usesObjectBuffer;
+
 		//The shader program currently in use.
 		static const ShaderProgram* m_current;
 
 		void Link();
+
+		//Asks GL about every active uniform and block, and fills in the tables above.
+		void Reflect();
 	};
 }
\ No newline at end of file
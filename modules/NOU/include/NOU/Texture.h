@@ -8,6 +8,8 @@ Simple wrapper for STB image loading into 2D textures.
 
 #pragma once
 
+#include "TextureData.h"
+
 #include "glad/glad.h"
 
 #include <string>
@@ -18,15 +20,42 @@ namespace nou
 	{
 		public:
 
-		Texture2D(const std::string& filename, bool useNearest = false);
+		//Loads an image file, or a KTX file (which may be compressed, and
+		//comes with its own mipmaps - see TextureData.h).
+		//If mipmaps is true, images get a mip chain built for them when they're loaded.
+		Texture2D(const std::string& filename, bool useNearest = false, bool mipmaps = true);
+		//Decodes an image file that's already in memory (e.g., one embedded in a GLB).
+		Texture2D(const unsigned char* encoded, size_t size, bool useNearest = false, bool mipmaps = true);
+		//Uploads pixels that are already decoded: RGBA, 8 bits per channel,
+		//with the bottom row first (i.e., already flipped for OpenGL).
+		Texture2D(int width, int height, const unsigned char* pixels, bool useNearest = false, bool mipmaps = true);
+		//Uploads texture data as-is, mip levels and all.
+		Texture2D(const TextureData& data, bool useNearest = false);
 		~Texture2D();
 
+		Texture2D(const Texture2D&) = delete;
+		Texture2D& operator=(const Texture2D&) = delete;
+
 		GLuint GetID() const;
 		void GetDimensions(int& width, int& height) const;
 
+		TextureFormat GetFormat() const;
+		int GetMipCount() const;
+		//Roughly how much VRAM the texture takes up, in bytes (all mip levels included).
+		size_t GetSize() const;
+		bool IsNearest() const;
+
 		private:
 
+		//Sends decoded RGBA pixels (width x height) to a new OpenGL texture.
+		void Create(const unsigned char* pixels, int width, int height, bool useNearest, bool mipmaps);
+		void Create(const TextureData& data, bool useNearest);
+
 		GLuint m_id;
 		int m_width, m_height;
+		TextureFormat m_format;
+		int m_mipCount;
+		size_t m_size;
+		bool m_nearest;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TextureCache.h
+Makes sure each texture is only loaded (and only takes up VRAM) once,
+however many materials use it.
+
+Textures are looked up by path plus sampling options (the same image with
+nearest and linear filtering needs two textures), and handed out as
+TextureHandles, which count how many users each texture has. When the
+last handle to a texture goes away, the texture isn't deleted straight
+away - somebody might want it again in a moment (e.g., when switching
+back and forth between two levels). Instead, it's kept until the textures
+in the cache take up more memory than the budget allows, at which point
+the least recently used unreferenced ones are evicted first.
+
+Everything here touches OpenGL, so use it from the main thread only.
+*/
+
+#pragma once
+
+#include "Texture.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace nou
+{
+	class TextureCache;
+
+	//A reference to a texture in the TextureCache. Copying a handle adds a reference,
+	//and the texture is kept alive as long as any handle to it exists.
+	class TextureHandle
+	{
+		public:
+
+		//What the cache keeps for each texture (only TextureCache.cpp needs to know what's in it).
+		struct Entry;
+
+		TextureHandle() = default;
+		~TextureHandle();
+
+		TextureHandle(const TextureHandle& other);
+		TextureHandle& operator=(const TextureHandle& other);
+		TextureHandle(TextureHandle&& other) noexcept;
+		TextureHandle& operator=(TextureHandle&& other) noexcept;
+
+		//Null for an empty handle.
+		const Texture2D* Get() const;
+		const Texture2D& operator*() const { return *Get(); }
+		const Texture2D* operator->() const { return Get(); }
+		explicit operator bool() const { return m_entry != nullptr; }
+
+		//Lets go of the texture (leaving the handle empty).
+		void Reset();
+
+		protected:
+
+		friend class TextureCache;
+
+		explicit TextureHandle(Entry* entry);
+
+		Entry* m_entry = nullptr;
+	};
+
+	class TextureCache
+	{
+		public:
+
+		struct Stats
+		{
+			//Lookups that found the texture already loaded, and ones that had to load it.
+			size_t hits;
+			size_t misses;
+			size_t evictions;
+
+			//How many textures are loaded, and how many of those nobody's using.
+			size_t textureCount;
+			size_t unreferencedCount;
+
+			//VRAM taken up by every texture in the cache (as far as we can tell - drivers
+			//are free to pad things out), and how much they're allowed.
+			size_t residentBytes;
+			size_t budgetBytes;
+		};
+
+		~TextureCache() = default;
+
+		//Loads a texture file (see Texture2D), or finds it if it's already loaded.
+		static TextureHandle Load(const std::string& filename, bool useNearest = false, bool mipmaps = true);
+
+		//Same, for textures that don't come straight from a file (e.g., images embedded in a glTF).
+		//The key is anything that uniquely identifies the image, and create is only called
+		//if it isn't loaded already.
+		static TextureHandle Get(const std::string& key, bool useNearest, bool mipmaps,
+								 const std::function<std::unique_ptr<Texture2D>()>& create);
+
+		//How much VRAM unreferenced textures can stay around in (512 MB by default).
+		//Textures in use are never evicted, even if they go over the budget alone.
+		static void SetBudget(size_t bytes);
+		static size_t GetBudget();
+
+		//Evicts every unreferenced texture, regardless of the budget.
+		//(App::Cleanup does this before the OpenGL context goes away.)
+		static void EvictUnused();
+
+		static Stats GetStats();
+
+		protected:
+
+		friend class TextureHandle;
+
+		//Instantiating this class doesn't make sense, since all our functionality
+		//is exposed statically.
+		TextureCache() = default;
+
+		static void AddRef(TextureHandle::Entry* entry);
+		static void Release(TextureHandle::Entry* entry);
+		//Evicts least recently used unreferenced textures until we're within budget.
+		static void Trim();
+	};
+}
@@ -0,0 +1,130 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TextureData.h
+Texture data on the CPU side: mip chains, block-compressed formats,
+and reading/writing them in KTX files.
+
+Mipmaps
+When a texture is drawn smaller than it really is (e.g., on a faraway wall),
+each pixel on screen covers lots of texels. Sampling just one or four of them
+flickers, and jumps all over the texture in memory, which is terrible for the
+GPU's texture cache. Mipmaps fix this by storing pre-shrunk copies of the
+texture (each half the size of the last, down to 1x1), so the GPU can sample
+whichever copy is closest to the size being drawn. They cost 1/3 more memory.
+We build the chain on the CPU, with either:
+-A box filter, which just averages each 2x2 block. Fast, slightly blurry.
+-A Kaiser filter (a windowed sinc), which keeps small levels much sharper.
+ Slower, so it's better suited to building textures offline.
+
+Block compression
+GPUs can sample textures that are stored compressed, in fixed-size blocks of
+4x4 texels, so compressed textures take less memory AND less bandwidth:
+-BC1: RGB, 8 bytes per block (8x smaller than RGBA8). For colour maps.
+-BC3: RGBA, 16 bytes per block (4x smaller). BC1 colour plus smooth alpha.
+-BC5: two channels, 16 bytes per block. Ideal for tangent-space normal maps.
+-BC7: RGBA, 16 bytes per block, with much higher quality than BC1/BC3.
+Compressing takes a while, so it's done offline (see BlockCompression.h and
+the TextureEncoder tool), and the results are saved as KTX files.
+
+KTX
+A simple container made for OpenGL, which stores a texture's mip levels along
+with the OpenGL format they're in, ready to be handed straight to the GPU.
+Our KTX files store rows bottom-first, the way Texture2D flips images on load.
+*/
+
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//BC1 and BC3 (a.k.a. DXT1 and DXT5) come from the S3TC extension, which every
+//desktop GPU supports, but which never made it into core OpenGL.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace nou
+{
+	enum class TextureFormat
+	{
+		RGBA8,
+		BC1,
+		BC3,
+		BC5,
+		BC7
+	};
+
+	enum class MipFilter
+	{
+		BOX,
+		KAISER
+	};
+
+	//A texture, and optionally its mip chain, as it will be laid out on the GPU.
+	struct TextureData
+	{
+		struct Level
+		{
+			int width, height;
+			//Where the level's data is in bytes, and how big it is.
+			size_t offset, size;
+		};
+
+		TextureFormat format = TextureFormat::RGBA8;
+		int width = 0, height = 0;
+
+		//Largest first. Level 0 is the texture itself.
+		std::vector<Level> levels;
+		std::vector<unsigned char> bytes;
+
+		const unsigned char* GetLevelData(size_t level) const;
+
+		//Total size of every level, in bytes.
+		size_t GetSize() const;
+	};
+
+	//Whether the format is one of the compressed ones.
+	bool IsCompressed(TextureFormat format);
+	//The OpenGL internal format used for the format, e.g., GL_RGBA8.
+	GLenum GetGLFormat(TextureFormat format);
+	//The number of bytes a width x height image takes up in the format.
+	size_t GetImageSize(TextureFormat format, int width, int height);
+	//How many levels a full mip chain for an image this size has.
+	int GetMipCount(int width, int height);
+
+	namespace Mipmap
+	{
+		//Fills out with an RGBA8 copy of pixels (width x height, RGBA8) and, if mipmaps
+		//is true, the rest of its mip chain, built with the given filter.
+		//Each level is split across the JobSystem, so this is quickest on the main thread
+		//(or wherever you can spare the workers), but fine to call from a worker too.
+		void Build(const unsigned char* pixels, int width, int height, TextureData& out,
+				   bool mipmaps = true, MipFilter filter = MipFilter::BOX);
+
+		//Shrinks one RGBA8 level to the next one down (half size, rounded down, min 1).
+		void Downsample(const unsigned char* src, int srcWidth, int srcHeight,
+						unsigned char* dst, int dstWidth, int dstHeight, MipFilter filter);
+	}
+
+	namespace KTX
+	{
+		//Reads a KTX file that's already in memory. Only 2D textures (with or without
+		//mipmaps) in one of the TextureFormats are supported.
+		bool Read(const unsigned char* data, size_t size, TextureData& out, std::string& err);
+		//Maps and reads a whole file.
+		bool Load(const std::string& filename, TextureData& out, std::string& err);
+		bool Save(const std::string& filename, const TextureData& data);
+
+		//Whether the filename ends in .ktx.
+		bool IsKTXFile(const std::string& filename);
+	}
+}
@@ -0,0 +1,95 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TextureUploader.h
+Streams pixel data to textures through a ring of pixel buffer memory.
+
+Handing glTexImage2D a pointer to pixels in our own memory means the driver
+has to copy them out before the call can return - and for a big image, that
+copy (plus whatever synchronization the driver needs to do it) can stall the
+whole frame.
+
+Instead, we keep one big pixel buffer object (PBO) mapped for as long as the
+program runs (a "persistent" mapping), and treat it as a ring:
+-Pixels are copied into the next free stretch of the ring.
+-glTexSubImage2D is told to read them from the PBO rather than from us, so it
+ returns right away, and the GPU pulls the data over on its own time.
+-Each upload drops a fence into the command stream. Before a stretch of the
+ ring is written over, we wait on the fence of the upload that used it last,
+ so we never scribble on pixels the GPU hasn't read yet. (If the ring is big
+ enough, the GPU is long finished by the time we come back around, and the
+ wait costs nothing.)
+
+Images bigger than the whole ring, and drivers without persistent mapping
+(anything before GL 4.4), fall back to a plain upload from client memory.
+
+Uploads are also counted against a per-frame byte budget. Uploading still
+works once the budget is spent - it's up to whoever's streaming (e.g.,
+AssetManager::Update) to check IsFrameBudgetSpent() and hold off until the
+next frame.
+*/
+
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstddef>
+
+namespace nou
+{
+	class TextureUploader
+	{
+		public:
+
+		~TextureUploader() = default;
+
+		//Size of the ring in bytes (32 MB by default).
+		//Changes take effect the next time the ring is created (i.e., after Shutdown()).
+		static void SetRingSize(size_t bytes);
+		static size_t GetRingSize();
+
+		//How many bytes can be streamed per frame (16 MB by default).
+		static void SetFrameBudget(size_t bytes);
+		static size_t GetFrameBudget();
+		static size_t GetBytesThisFrame();
+		static bool IsFrameBudgetSpent();
+
+		//Starts a new frame's budget. Called by App::FrameStart.
+		static void BeginFrame();
+
+		//Uploads pixels to the given mip level of the texture currently bound to target,
+		//like glTexSubImage2D (so storage for the level has to exist already).
+		//size is the number of bytes in pixels. Main thread only.
+		static void Upload(GLenum target, GLint level, GLsizei width, GLsizei height,
+						   GLenum format, GLenum type, const void* pixels, size_t size);
+
+		//Same, for block-compressed data (like glCompressedTexSubImage2D), where format
+		//is the compressed format, e.g., GL_COMPRESSED_RGBA_BPTC_UNORM.
+		static void UploadCompressed(GLenum target, GLint level, GLsizei width, GLsizei height,
+									 GLenum format, const void* data, size_t size);
+
+		//How many times an upload had to wait for the GPU to finish with ring memory.
+		//If this keeps climbing, the ring is too small for how much you're streaming.
+		static size_t GetStallCount();
+
+		//Releases the ring. Call while the OpenGL context is still around.
+		static void Shutdown();
+
+		protected:
+
+		//Instantiating this class doesn't make sense, since all our functionality
+		//is exposed statically.
+		TextureUploader() = default;
+
+		static bool CreateRing();
+		//Finds room for size bytes in the ring, waiting for the GPU if need be.
+		static size_t Allocate(size_t size);
+
+		//Copies data into the ring and binds it for unpacking, returning the offset to
+		//upload from. Returns false (having done nothing) if it has to go direct instead.
+		static bool Stage(const void* data, size_t size, size_t& offset);
+		//Unbinds the ring, and fences off what was staged.
+		static void Finish(size_t offset, size_t size);
+	};
+}
@@ -10,12 +10,14 @@ Simple class for managing object transforms with basic hierarchy support.
 
 #define GLM_ENABLE_EXPERIMENTAL
 
+#include "TransformStore.h"
+
 #include "GLM/glm.hpp"
 #include "GLM/gtx/quaternion.hpp"
 
-#include <vector>
-
 //Simple implementation of a transform component.
+//The actual data lives in a TransformStore - a Transform is just a handle
+//that knows where to find it.
 
 namespace nou
 {
@@ -23,19 +25,27 @@ namespace nou
 	{
 		public:
 
-		glm::vec3 m_pos;
-		glm::vec3 m_scale;
-		glm::quat m_rotation;
-
-		Transform();
-		Transform(const Transform& other) = default;
+		Transform(TransformStore& store = TransformStore::Default());
+		//Copying a transform creates a new object in the same store, with the
+		//same local position/rotation/scale and the same parent (but no children).
+		Transform(const Transform& other);
+		Transform& operator=(const Transform& other);
 		virtual ~Transform();
 
+		const glm::vec3& GetPosition() const;
+		const glm::quat& GetRotation() const;
+		const glm::vec3& GetScale() const;
+
+		void SetPosition(const glm::vec3& pos);
+		void SetRotation(const glm::quat& rotation);
+		void SetScale(const glm::vec3& scale);
+
 		//This will update the transform on the object
 		//and all of its children.
 		//If you are using a Scene concept, then you would
 		//call this once per frame before making all of your draw
 		//calls on the root node of your Scene.
+		//(Or call DoFK on the TransformStore to update everything at once.)
 		//(FK stands for "forward kinematics", by the way.)
 		void DoFK();
 
@@ -50,25 +60,28 @@ namespace nou
 
 		//This will return the current normal matrix of the object
 		//(used for lighting). As above, make sure you have called
-		//the appropriate update first.
-		glm::mat3 GetNormal() const;
+		//the appropriate update first - it's computed alongside the
+		//global transform, so this is just a lookup.
+		const glm::mat3& GetNormal() const;
 
-		//Sets a pointer to the parent object and updates child references
-		//for the old and new parent objects accordingly.
+		//Sets the bounding sphere of whatever's attached to this transform,
+		//in local space (see TransformStore::SetBounds).
+		void SetBounds(const glm::vec4& sphere);
+
+		//Whether this object survived the last TransformStore::Cull call.
+		bool IsVisible() const;
+
+		//Updates the parent of this object in the store.
 		//Pass in nullptr if you wish for the object to not have a parent.
+		//The parent must live in the same store as this object.
 		void SetParent(Transform* parent);
 
-		protected:
+		TransformStore& GetStore() const;
+		TransformStore::Handle GetHandle() const;
 
-		Transform* m_parent;
-		std::vector<Transform*> m_children;
-
-		glm::mat4 m_global;
+		protected:
 
-		//These functions are protected since they will be handled
-		//by SetParent - we don't want to have to manually update this ourselves
-		//whenever we switch an object's parent!
-		void AddChild(Transform* child);
-		void RemoveChild(Transform* child);
+		TransformStore* m_store;
+		TransformStore::Handle m_handle;
 	};
-}
\ No newline at end of file
+}
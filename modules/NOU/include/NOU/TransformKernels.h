@@ -0,0 +1,58 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TransformKernels.h
+Batched (SIMD) routines for building transform matrices.
+
+Building a local matrix the "textbook" way - translate * rotate * scale -
+costs three full 4x4 matrix multiplies per object. Since we know what
+those matrices look like, we can write the result out directly instead,
+and do it for 4 (SSE) or 8 (AVX2) objects at a time.
+The best version the CPU supports is picked when the program starts.
+*/
+
+#pragma once
+
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "GLM/glm.hpp"
+#include "GLM/gtx/quaternion.hpp"
+
+#include <cstdint>
+
+namespace nou::TransformKernels
+{
+	enum class ISA
+	{
+		SCALAR = 0,
+		SSE4,
+		AVX2
+	};
+
+	//The best instruction set supported by this CPU.
+	ISA Detect();
+
+	//The instruction set currently in use.
+	ISA GetISA();
+
+	//Overrides the instruction set in use (e.g., for benchmarking).
+	//Requests for something the CPU can't do are clamped to Detect().
+	void SetISA(ISA isa);
+
+	const char* GetISAName(ISA isa);
+
+	//Writes out[i] = translate(pos[i]) * toMat4(normalize(rot[i])) * scale(scale[i])
+	//for count objects.
+	void ComposeTRS(const glm::vec3* pos, const glm::quat* rot, const glm::vec3* scale,
+					glm::mat4* out, size_t count);
+
+	//For each index i in indices (in order), writes
+	//global[i] = global[parent[i]] * local[i], or just local[i] if parent[i] is NONE.
+	//Indices must be sorted so that parents are handled before their children.
+	void ConcatParents(const uint32_t* parent, const glm::mat4* local, glm::mat4* global,
+					   const uint32_t* indices, size_t count);
+
+	//Used to mark roots in the parent array passed to ConcatParents.
+	static constexpr uint32_t NONE = UINT32_MAX;
+}
@@ -0,0 +1,243 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TransformStore.h
+Scene-level storage for transform hierarchies.
+
+Rather than having every transform live wherever its owner happens to be
+in memory (and chasing pointers to parents and children each frame),
+the store keeps all local TRS data and global matrices in flat arrays.
+Those arrays are sorted so that every parent comes before its children,
+and every subtree occupies one contiguous range - so FK is just a single
+loop from front to back.
+
+Changing a transform marks it (and everything below it) as dirty, and FK
+only revisits dirty subtrees. Static objects cost nothing once they've
+been computed.
+*/
+
+#pragma once
+
+#include "Frustum.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include "GLM/glm.hpp"
+#include "GLM/gtx/quaternion.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace nou
+{
+	class BVH;
+
+	class TransformStore
+	{
+		public:
+
+		//Handles are stable for the lifetime of a transform.
+		//Dense indices (i.e., positions in the arrays below) are NOT -
+		//they change whenever the hierarchy is re-sorted.
+		using Handle = uint32_t;
+		static constexpr uint32_t NONE = UINT32_MAX;
+
+		//The store used by default for every Transform (and thus every Entity).
+		static TransformStore& Default();
+
+		TransformStore();
+		~TransformStore() = default;
+
+		//Handles point back into the store, so copying or moving it would
+		//leave them pointing at the wrong place.
+		TransformStore(const TransformStore&) = delete;
+		TransformStore& operator=(const TransformStore&) = delete;
+
+		//Creates a new root transform with identity TRS.
+		Handle Create();
+		//Removes a transform from the store.
+		//Any children it had are detached and become roots.
+		void Destroy(Handle handle);
+
+		//Pass NONE if you wish for the transform to not have a parent.
+		//Returns false (and does nothing) if this would create a cycle.
+		bool SetParent(Handle handle, Handle parent);
+		Handle GetParent(Handle handle) const;
+
+		const glm::vec3& GetPosition(Handle handle) const;
+		const glm::quat& GetRotation(Handle handle) const;
+		const glm::vec3& GetScale(Handle handle) const;
+
+		void SetPosition(Handle handle, const glm::vec3& pos);
+		void SetRotation(Handle handle, const glm::quat& rotation);
+		void SetScale(Handle handle, const glm::vec3& scale);
+
+		//Returns the global transform as of the last FK pass (or RecomputeGlobal call).
+		//The reference is only valid until the store is next modified.
+		const glm::mat4& GetGlobal(Handle handle) const;
+		//Returns the normal matrix (inverse-transpose of the top 3x3 of the global
+		//transform), which is kept up to date right alongside it.
+		const glm::mat3& GetNormal(Handle handle) const;
+
+		//Sets the object's bounding sphere in local space - (center, radius).
+		//The world space version is kept up to date during FK.
+		//A negative radius means the object has no bounds (and is never culled).
+		void SetBounds(Handle handle, const glm::vec4& sphere);
+		//Returns the world space bounding sphere as of the last FK pass.
+		const glm::vec4& GetWorldBounds(Handle handle) const;
+
+		//Tests every object's world bounds against a camera's frustum in one go,
+		//and remembers which ones are visible. Call after DoFK.
+		//Returns the number of visible objects.
+		size_t Cull(const Frustum& frustum);
+		//Same, but only visits the parts of a BVH near the frustum, rather than
+		//testing every object. Every object with bounds should be in the BVH
+		//(see BVH::InsertTransform), and the BVH should be synced first.
+		//Below a certain number of objects (see SetBVHCullThreshold), this
+		//just does the same as the version above.
+		size_t Cull(const Frustum& frustum, const BVH& bvh);
+		//Whether the object was inside the frustum at the last Cull call.
+		//Objects created since then count as visible.
+		bool IsVisible(Handle handle) const;
+		//Results of the last Cull call.
+		size_t LastVisibleCount() const;
+		size_t LastCulledCount() const;
+
+		//Returns true if the object's global transform is out of date.
+		bool IsDirty(Handle handle) const;
+
+		//Updates the global transform of every dirty object in the store.
+		//Each dirty subtree is one linear pass over contiguous memory.
+		//Big updates are split into chunks of whole subtrees and spread
+		//across the JobSystem's threads - since no two chunks share a node,
+		//they can write their results without any locking.
+		void DoFK();
+
+		//Updates the global transform of one object and all of its descendants
+		//(along with any dirty ancestors, so the result is correct).
+		void DoFK(Handle root);
+
+		//Recomputes (and returns) the global transform of one object.
+		//Only the dirty part of its chain of ancestors is revisited - if nothing
+		//has moved, this just returns the cached result.
+		const glm::mat4& RecomputeGlobal(Handle handle);
+
+		//The number of live transforms in the store.
+		size_t Size() const;
+
+		//When tracking is on, the store keeps a list of every transform whose
+		//global matrix (and world bounds) has been recomputed since the last
+		//ClearUpdated call - e.g., for keeping a BVH in sync with only the
+		//objects that actually moved. A handle may appear more than once.
+		//Off by default, since otherwise the list would just keep growing.
+		void SetTrackUpdates(bool track);
+		const std::vector<Handle>& GetUpdated() const;
+		void ClearUpdated();
+
+		//The number of global transforms recomputed by the last DoFK call.
+		//Handy for checking that static objects are really being skipped.
+		size_t LastUpdateCount() const;
+
+		//Updates touching fewer nodes than this stay on the calling thread,
+		//since handing out jobs has a cost of its own.
+		//Set to 0 to always go wide, or SIZE_MAX to never.
+		void SetParallelThreshold(size_t threshold);
+		//Cull ignores the BVH for stores with fewer objects than this, since
+		//testing every sphere with SSE beats walking the tree until there are
+		//a lot of them (around 200k, in the BVH benchmark).
+		//Set to 0 to always use the BVH.
+		void SetBVHCullThreshold(size_t threshold);
+
+		protected:
+
+		//All of these are indexed by dense index, and kept in
+		//parent-before-child (depth-first) order by Reorder().
+		std::vector<glm::vec3> m_pos;
+		std::vector<glm::quat> m_rotation;
+		std::vector<glm::vec3> m_scale;
+		std::vector<glm::mat4> m_local;
+		std::vector<glm::mat4> m_global;
+		std::vector<glm::mat3> m_normal;
+		//Bounding spheres, as (center, radius).
+		std::vector<glm::vec4> m_localBounds;
+		std::vector<glm::vec4> m_worldBounds;
+		std::vector<uint8_t> m_visible;
+
+		//Set when the local TRS has changed and m_local needs rebuilding.
+		std::vector<uint8_t> m_localDirty;
+		//Set when m_global is out of date. If a node is dirty, then so is
+		//every node in its subtree.
+		std::vector<uint8_t> m_globalDirty;
+
+		//Dense index of each node's parent, or NONE for roots.
+		std::vector<uint32_t> m_parent;
+		//Number of nodes in each node's subtree (including itself).
+		//The subtree of node i is the range [i, i + m_subtreeSize[i]).
+		std::vector<uint32_t> m_subtreeSize;
+		//Handle owning each dense slot.
+		std::vector<Handle> m_handle;
+
+		//Handle -> dense index (NONE for handles not currently in use).
+		std::vector<uint32_t> m_dense;
+		std::vector<Handle> m_freeHandles;
+
+		//Roots of the subtrees that have been marked dirty since the last FK pass.
+		std::vector<Handle> m_dirtyRoots;
+
+		//Set whenever the hierarchy changes in a way that breaks our ordering.
+		//We re-sort lazily, the next time the order actually matters.
+		bool m_orderDirty;
+		//Set after a re-sort, when m_dirtyRoots no longer tells us everything
+		//that needs updating - the next FK pass checks every node instead.
+		bool m_fullUpdate;
+
+		size_t m_lastUpdateCount;
+		bool m_trackUpdates;
+		size_t m_lastVisibleCount;
+		size_t m_lastCulledCount;
+		size_t m_parallelThreshold;
+		size_t m_bvhCullThreshold;
+
+		//A contiguous range of dense indices, [first, second).
+		using Range = std::pair<uint32_t, uint32_t>;
+
+		//Reused between FK passes so we aren't allocating every frame.
+		//There's one of these per job system thread, so FK chunks
+		//running in parallel don't trip over each other.
+		struct Scratch
+		{
+			std::vector<uint32_t> dirty;
+			std::vector<Handle> updated;
+		};
+
+		std::vector<Scratch> m_scratch;
+		std::vector<Handle> m_updated;
+		//Results of BVH queries in Cull.
+		std::vector<uint32_t> m_cullResults;
+		//The dirty subtrees to visit this FK pass.
+		std::vector<Range> m_ranges;
+		//The same work split up into chunks for the job system.
+		//Chunk c is m_chunkRanges[m_chunks[c]] up to m_chunkRanges[m_chunks[c + 1]].
+		std::vector<Range> m_chunkRanges;
+		std::vector<size_t> m_chunks;
+		std::vector<size_t> m_chunkCounts;
+		//Nodes too big to fit in one chunk, which we update before going wide.
+		std::vector<uint32_t> m_heads;
+
+		uint32_t Dense(Handle handle) const;
+		void Reorder();
+
+		void MarkDirty(uint32_t index);
+		void ComputeLocal(uint32_t index);
+		void ComputeGlobal(uint32_t index);
+
+		//Updates every range in m_ranges (each a whole subtree, or a run of
+		//sibling subtrees), in parallel if there's enough work to go around.
+		size_t UpdateRanges();
+		void SplitRange(const Range& range, size_t target, size_t& chunkSize);
+		void AddToChunk(uint32_t begin, uint32_t end, size_t target, size_t& chunkSize);
+		size_t UpdateRange(uint32_t begin, uint32_t end, Scratch& scratch);
+	};
+}
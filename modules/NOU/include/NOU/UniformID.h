@@ -0,0 +1,57 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+UniformID.h
+Names for shader uniforms (and blocks) that are hashed at compile time.
+
+Looking a uniform up by std::string means building a string and hashing
+it every single time we set a uniform - usually several times per draw.
+Instead, we can write "model"_u, which the compiler turns into a 32-bit
+FNV-1a hash of "model", and ShaderProgram finds the uniform by comparing
+numbers. The hash only depends on the name, so the same ID works with
+every program that has a uniform by that name.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace nou
+{
+	struct UniformID
+	{
+		uint32_t hash = 0;
+
+		constexpr UniformID() = default;
+		constexpr explicit UniformID(uint32_t hash) : hash(hash) {}
+		constexpr UniformID(const char* name, size_t len) : hash(Hash(name, len)) {}
+
+		//For names we only know at runtime (this one does do the hashing every time).
+		explicit UniformID(const std::string& name) : UniformID(name.data(), name.size()) {}
+
+		static constexpr uint32_t Hash(const char* name, size_t len)
+		{
+			uint32_t hash = 2166136261u;
+
+			for (size_t i = 0; i < len; ++i)
+			{
+				hash ^= static_cast<uint8_t>(name[i]);
+				hash *= 16777619u;
+			}
+
+			return hash;
+		}
+
+		constexpr bool operator==(UniformID other) const { return hash == other.hash; }
+		constexpr bool operator!=(UniformID other) const { return hash != other.hash; }
+	};
+
+	//e.g., program.SetUniform("viewproj"_u, camera.GetVP());
+	constexpr UniformID operator""_u(const char* name, size_t len)
+	{
+		return UniformID(name, len);
+	}
+}
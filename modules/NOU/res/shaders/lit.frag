@@ -9,37 +9,55 @@ You'll learn a lot about lighting in graphics - this shader just gives us a simp
 way to make sure that everything looks right with our normals, etc.
 */
 
-#version 420 core
+#version 430 core
 
 layout(location = 0) in vec4 inPos;
 layout(location = 1) in vec3 inNorm;
 
 layout(location = 0) out vec4 outColor;
 
-uniform vec3 camPos;
+//The camera and lights, set once per frame (see FrameUniforms.h).
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewproj;
+    vec4 camPos;
+    vec4 lightDir;
+    vec4 lightColor;
+    //rgb is the colour, a is its power.
+    vec4 ambient;
+};
+
+//Our material's colour and textures, from the MaterialTable (see MaterialTable.h).
+struct MaterialData
+{
+    vec4 color;
+    uvec2 textures[4];
+};
 
-uniform vec3 matColor = vec3(1.0f, 1.0f, 1.0f);
+layout(std430, binding = 0) readonly buffer MaterialBlock
+{
+    MaterialData materials[];
+};
 
-uniform vec3 lightColor = vec3(0.9f, 0.9f, 0.9f);
-uniform vec3 lightDir = normalize(vec3(-1.0f, -1.0f, -1.0f));
-uniform vec3 ambientColor = vec3(1.0f, 1.0f, 1.0f);
-uniform float ambientPower = 0.2f;
+uniform uint materialIndex;
 
 void main()
 {
     vec3 norm = normalize(inNorm); 
 
-    vec3 eye = normalize(camPos - inPos.xyz);
-    vec3 toLight = -lightDir;
+    vec3 eye = normalize(camPos.xyz - inPos.xyz);
+    vec3 toLight = -lightDir.xyz;
 
     vec3 avg = normalize(eye + toLight);
 
     float diffPower = max(dot(norm, toLight), 0.0f);
-    vec3 diff = diffPower * lightColor;
+    vec3 diff = diffPower * lightColor.rgb;
 
-    vec3 ambient = ambientPower * ambientColor;
+    vec3 ambientLight = ambient.a * ambient.rgb;
 
-    vec3 result = (ambient + diff) * matColor;
+    vec3 result = (ambientLight + diff) * materials[materialIndex].color.rgb;
 
     outColor = vec4(result, 1.0f);
 }
\ No newline at end of file
@@ -8,11 +8,33 @@ Passes world vertex position, transformed normal direction, and UV coordinates
 to the fragment shader.
 */
 
-#version 420 core
+#version 460 core
 
-uniform mat4 model;
-uniform mat3 normal;
-uniform mat4 viewproj;
+//The camera and lights, set once per frame (see FrameUniforms.h).
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewproj;
+    vec4 camPos;
+    vec4 lightDir;
+    vec4 lightColor;
+    //rgb is the colour, a is its power.
+    vec4 ambient;
+};
+
+//Every object drawn this frame, each finding its own entry from the
+//draw's base instance (see ObjectBuffer.h).
+struct ObjectData
+{
+    mat4 model;
+    mat3 normal;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBlock
+{
+    ObjectData objects[];
+};
 
 layout(location = 0) in vec4 inPos;
 layout(location = 1) in vec3 inNorm;
@@ -22,8 +44,10 @@ layout(location = 1) out vec3 outNorm;
 
 void main()
 {
-    outNorm = normal * inNorm;
-    outPos = model * inPos;
+    ObjectData obj = objects[gl_BaseInstance + gl_InstanceID];
+
+    outNorm = obj.normal * inNorm;
+    outPos = obj.model * inPos;
 
     gl_Position = viewproj * outPos;
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+lit_compressed.vert
+Vertex shader.
+Same as lit.vert, but for meshes using one of the compressed vertex formats
+(see Mesh::VertexFormat), whose normals need decoding. Pair with lit.frag.
+*/
+
+#version 460 core
+
+//The camera and lights, set once per frame (see FrameUniforms.h).
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewproj;
+    vec4 camPos;
+    vec4 lightDir;
+    vec4 lightColor;
+    //rgb is the colour, a is its power.
+    vec4 ambient;
+};
+
+//Every object drawn this frame, each finding its own entry from the
+//draw's base instance (see ObjectBuffer.h).
+struct ObjectData
+{
+    mat4 model;
+    mat3 normal;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBlock
+{
+    ObjectData objects[];
+};
+
+layout(location = 0) in vec4 inPos;
+//Octahedral-encoded - two numbers rather than three.
+layout(location = 1) in vec2 inNormOct;
+
+layout(location = 0) out vec4 outPos;
+layout(location = 1) out vec3 outNorm;
+
+//Undoes the octahedral encoding done in Mesh.cpp (see EncodeOct there).
+vec3 DecodeOct(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    ObjectData obj = objects[gl_BaseInstance + gl_InstanceID];
+
+    outNorm = obj.normal * DecodeOct(inNormOct);
+    outPos = obj.model * inPos;
+
+    gl_Position = viewproj * outPos;
+}
\ No newline at end of file
@@ -9,7 +9,8 @@ You'll learn a lot about lighting in graphics - this shader just gives us a simp
 way to make sure that everything looks right with our normals, etc.
 */
 
-#version 420 core
+#version 430 core
+#extension GL_ARB_bindless_texture : enable
 
 layout(location = 0) in vec4 inPos;
 layout(location = 1) in vec3 inNorm;
@@ -17,32 +18,66 @@ layout(location = 2) in vec2 inUV;
 
 layout(location = 0) out vec4 outColor;
 
-uniform vec3 camPos;
+//The camera and lights, set once per frame (see FrameUniforms.h).
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewproj;
+    vec4 camPos;
+    vec4 lightDir;
+    vec4 lightColor;
+    //rgb is the colour, a is its power.
+    vec4 ambient;
+};
+
+//Our material's colour and textures, from the MaterialTable (see MaterialTable.h).
+struct MaterialData
+{
+    vec4 color;
+    uvec2 textures[4];
+};
+
+layout(std430, binding = 0) readonly buffer MaterialBlock
+{
+    MaterialData materials[];
+};
+
+uniform uint materialIndex;
 
-uniform vec3 matColor = vec3(1.0f, 1.0f, 1.0f);
-uniform sampler2D albedo;
+#ifndef GL_ARB_bindless_texture
+//Without bindless textures, ours are copied into layers of these arrays instead.
+layout(binding = 16) uniform sampler2DArray texturePages[8];
+#endif
+
+//Samples the material's slot-th texture.
+vec4 SampleMaterial(int slot, vec2 uv)
+{
+    uvec2 tex = materials[materialIndex].textures[slot];
 
-uniform vec3 lightColor = vec3(0.9f, 0.9f, 0.9f);
-uniform vec3 lightDir = normalize(vec3(-1.0f, -1.0f, -1.0f));
-uniform vec3 ambientColor = vec3(1.0f, 1.0f, 1.0f);
-uniform float ambientPower = 0.2f;
+#ifdef GL_ARB_bindless_texture
+    return texture(sampler2D(tex), uv);
+#else
+    return texture(texturePages[tex.x], vec3(uv, tex.y));
+#endif
+}
 
 void main()
 {
     vec3 norm = normalize(inNorm); 
 
-    vec3 eye = normalize(camPos - inPos.xyz);
-    vec3 toLight = -lightDir;
+    vec3 eye = normalize(camPos.xyz - inPos.xyz);
+    vec3 toLight = -lightDir.xyz;
 
     vec3 avg = normalize(eye + toLight);
 
     float diffPower = max(dot(norm, toLight), 0.0f);
-    vec3 diff = diffPower * lightColor;
+    vec3 diff = diffPower * lightColor.rgb;
 
-    vec3 ambient = ambientPower * ambientColor;
+    vec3 ambientLight = ambient.a * ambient.rgb;
 
-    vec4 texCol = texture(albedo, inUV);
-    vec3 result = (ambient + diff) * matColor * texCol.rgb;
+    vec4 texCol = SampleMaterial(0, inUV);
+    vec3 result = (ambientLight + diff) * materials[materialIndex].color.rgb * texCol.rgb;
 
     outColor = vec4(result, texCol.a);
 }
\ No newline at end of file
@@ -7,18 +7,47 @@ Fragment shader.
 Samples colour from a given albedo texture without any lighting.
 */
 
-#version 420 core
+#version 430 core
+#extension GL_ARB_bindless_texture : enable
 
 layout(location = 2) in vec2 inUV;
 
 layout(location = 0) out vec4 outColor;
 
-uniform vec3 matColor = vec3(1.0f, 1.0f, 1.0f);
-uniform sampler2D albedo;
+//Our material's colour and textures, from the MaterialTable (see MaterialTable.h).
+struct MaterialData
+{
+    vec4 color;
+    uvec2 textures[4];
+};
+
+layout(std430, binding = 0) readonly buffer MaterialBlock
+{
+    MaterialData materials[];
+};
+
+uniform uint materialIndex;
+
+#ifndef GL_ARB_bindless_texture
+//Without bindless textures, ours are copied into layers of these arrays instead.
+layout(binding = 16) uniform sampler2DArray texturePages[8];
+#endif
+
+//Samples the material's slot-th texture.
+vec4 SampleMaterial(int slot, vec2 uv)
+{
+    uvec2 tex = materials[materialIndex].textures[slot];
+
+#ifdef GL_ARB_bindless_texture
+    return texture(sampler2D(tex), uv);
+#else
+    return texture(texturePages[tex.x], vec3(uv, tex.y));
+#endif
+}
 
 void main()
 {
-    vec4 texCol = texture(albedo, inUV);
+    vec4 texCol = SampleMaterial(0, inUV);
 
-    outColor = vec4(matColor * texCol.rgb, texCol.a);
+    outColor = vec4(materials[materialIndex].color.rgb * texCol.rgb, texCol.a);
 }
\ No newline at end of file
@@ -7,18 +7,43 @@ Vertex shader.
 Passes world vertex position and UV coordinates to the fragment shader.
 */
 
-#version 420 core
+#version 460 core
+
+//The camera and lights, set once per frame (see FrameUniforms.h).
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewproj;
+    vec4 camPos;
+    vec4 lightDir;
+    vec4 lightColor;
+    //rgb is the colour, a is its power.
+    vec4 ambient;
+};
+
+//Every object drawn this frame, each finding its own entry from the
+//draw's base instance (see ObjectBuffer.h).
+struct ObjectData
+{
+    mat4 model;
+    mat3 normal;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBlock
+{
+    ObjectData objects[];
+};
 
 layout(location = 0) in vec4 inPos;
 layout(location = 2) in vec2 inUV;
 
 layout(location = 2) out vec2 outUV;
 
-uniform mat4 model;
-uniform mat4 viewproj;
-
 void main()
 {
+    ObjectData obj = objects[gl_BaseInstance + gl_InstanceID];
+
     outUV = inUV;
-    gl_Position = viewproj * model * inPos;
+    gl_Position = viewproj * obj.model * inPos;
 }
\ No newline at end of file
@@ -7,13 +7,25 @@ Fragment shader.
 Outputs uniform colour without any lighting.
 */
 
-#version 420 core
+#version 430 core
 
 layout(location = 0) out vec4 outColor;
 
-uniform vec3 matColor = vec3(1.0f, 1.0f, 1.0f);
+//Our material's colour and textures, from the MaterialTable (see MaterialTable.h).
+struct MaterialData
+{
+    vec4 color;
+    uvec2 textures[4];
+};
+
+layout(std430, binding = 0) readonly buffer MaterialBlock
+{
+    MaterialData materials[];
+};
+
+uniform uint materialIndex;
 
 void main()
 {
-    outColor = vec4(matColor, 1.0f);
+    outColor = vec4(materials[materialIndex].color.rgb, 1.0f);
 }
\ No newline at end of file
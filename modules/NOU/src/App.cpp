@@ -8,6 +8,13 @@ Minimal utility class for GLFW window management.
 
 #include "NOU/App.h"
 #include "NOU/Input.h"
+#include "NOU/AssetManager.h"
+#include "NOU/FrameUniforms.h"
+#include "NOU/JobSystem.h"
+#include "NOU/MaterialTable.h"
+#include "NOU/ObjectBuffer.h"
+#include "NOU/TextureCache.h"
+#include "NOU/TextureUploader.h"
 
 #define IMGUI_IMPL_OPENGL_LOADER_GLAD
 #include "imgui.h"
@@ -90,6 +97,10 @@ namespace nou
 		//This initializes the background colour we want to use to clear our window.
 		//This default is black.
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+		//Spin up our worker threads. The thread that created the window
+		//(i.e., this one) becomes the main thread.
+		JobSystem::Init();
 	}
 
 	void App::InitImgui()
@@ -122,6 +133,15 @@ namespace nou
 
 	void App::Cleanup()
 	{
+		JobSystem::Shutdown();
+		//Textures still in use belong to whoever's using them, but the ones nobody
+		//wants have to go before the context they live in does.
+		TextureCache::EvictUnused();
+		MaterialTable::Shutdown();
+		ObjectBuffer::Shutdown();
+		FrameUniforms::Shutdown();
+		TextureUploader::Shutdown();
+
 		if (m_imguiInit)
 		{
 			ImGui_ImplOpenGL3_Shutdown();
@@ -149,6 +169,19 @@ namespace nou
 		Input::FrameStart();
 		glfwPollEvents();
 
+		//Texture streaming gets a fresh byte budget every frame.
+		TextureUploader::BeginFrame();
+		//Last frame's per-object data is fenced off, and its camera is out of date.
+		ObjectBuffer::BeginFrame();
+		FrameUniforms::BeginFrame();
+
+		//Run anything the worker threads have queued for the main thread
+		//(e.g., GPU uploads for assets that just finished loading).
+		JobSystem::PumpMainThread();
+
+		//Send any assets that have finished loading to the GPU (a few at a time).
+		AssetManager::Update();
+
 		//Clear our window.
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	}
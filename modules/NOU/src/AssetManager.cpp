@@ -0,0 +1,243 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+AssetManager.cpp
+Loads textures and meshes in the background, so that the game keeps
+running (and rendering) while they come in.
+*/
+
+#include "NOU/AssetManager.h"
+#include "NOU/GLTFLoader.h"
+#include "NOU/MappedFile.h"
+#include "NOU/MeshCache.h"
+#include "NOU/OBJLoader.h"
+#include "NOU/TextureUploader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//stb_image's vertical flip is a single global flag, which anyone (like Texture2D)
+//can change at any time - not something we want to depend on halfway through a
+//decode on another thread. So we compile a private copy of stb_image here, whose
+//flag is never touched, and do the flipping ourselves.
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace fs = std::filesystem;
+
+namespace nou
+{
+	namespace
+	{
+		std::mutex s_uploadMutex;
+		std::deque<std::function<void()>> s_uploads;
+
+		std::atomic<float> s_uploadBudget = 2.0f;
+		std::atomic<size_t> s_pending = 0;
+
+		JobSystem::Counter s_reads;
+
+		//Runs queued uploads until the budget (in ms) runs out, or forever if it's negative.
+		//Also stops once the frame's texture streaming budget is spent (see TextureUploader).
+		//Always runs at least one, so that loading can't stall on a tiny budget.
+		size_t RunUploads(float budget)
+		{
+			using Clock = std::chrono::steady_clock;
+
+			auto start = Clock::now();
+			size_t count = 0;
+
+			do
+			{
+				std::function<void()> upload;
+
+				{
+					std::lock_guard<std::mutex> lock(s_uploadMutex);
+
+					if (s_uploads.empty())
+						break;
+
+					upload = std::move(s_uploads.front());
+					s_uploads.pop_front();
+				}
+
+				upload();
+				++count;
+			}
+			while (budget < 0.0f ||
+				   (std::chrono::duration<float, std::milli>(Clock::now() - start).count() < budget &&
+					!TextureUploader::IsFrameBudgetSpent()));
+
+			return count;
+		}
+
+		bool ReadTexture(const std::string& filename, bool mipmaps, TextureData& staging, std::string& err)
+		{
+			if (KTX::IsKTXFile(filename))
+				return KTX::Load(filename, staging, err);
+
+			MappedFile file;
+
+			if (!file.Open(filename))
+			{
+				err = "Couldn't open file.";
+				return false;
+			}
+
+			int width, height, channels;
+			stbi_uc* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.Data()),
+												  static_cast<int>(file.Size()),
+												  &width, &height, &channels, STBI_rgb_alpha);
+
+			if (data == nullptr)
+			{
+				err = "Couldn't decode image.";
+				return false;
+			}
+
+			//Flip while copying, since OpenGL wants the bottom row first (see Texture2D).
+			size_t rowSize = static_cast<size_t>(width) * 4;
+			std::vector<unsigned char> pixels(rowSize * height);
+
+			for (int y = 0; y < height; ++y)
+			{
+				memcpy(pixels.data() + rowSize * y,
+					   data + rowSize * (static_cast<size_t>(height) - 1 - y), rowSize);
+			}
+
+			stbi_image_free(data);
+
+			//Building mipmaps is easily the slowest part of loading an image,
+			//so it's well worth doing here rather than on the main thread.
+			Mipmap::Build(pixels.data(), width, height, staging, mipmaps);
+
+			return true;
+		}
+
+		bool ReadMesh(const std::string& filename, MeshCache::Staged& staged,
+					  bool flipUVY, bool optimize, std::string& err)
+		{
+			std::string ext = fs::path(filename).extension().string();
+			std::transform(ext.begin(), ext.end(), ext.begin(),
+						   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+			if (ext == ".obj")
+				return OBJ::ReadMesh(filename, staged, optimize, err);
+
+			if (ext == ".gltf" || ext == ".glb")
+			{
+				std::string warn;
+				bool read = GLTF::ReadMesh(filename, staged, flipUVY, optimize, err, warn);
+
+				if (read && !warn.empty())
+					GLTF::DumpErrorsAndWarnings(filename, "", warn);
+
+				return read;
+			}
+
+			err = "Unsupported mesh format \"" + ext + "\".";
+			return false;
+		}
+	}
+
+	void AssetManager::SetUploadBudget(float ms)
+	{
+		s_uploadBudget = ms;
+	}
+
+	float AssetManager::GetUploadBudget()
+	{
+		return s_uploadBudget;
+	}
+
+	Asset<Texture2D> AssetManager::LoadTexture(const std::string& filename, bool useNearest, bool mipmaps)
+	{
+		return Load<Texture2D, TextureData>(filename,
+		[filename, mipmaps](TextureData& staging, std::string& err)
+		{
+			return ReadTexture(filename, mipmaps, staging, err);
+		},
+		[useNearest](TextureData& staging)
+		{
+			return std::make_unique<Texture2D>(staging, useNearest);
+		});
+	}
+
+	Asset<Mesh> AssetManager::LoadMesh(const std::string& filename, bool flipUVY,
+									   bool optimize, bool keepCPUCopy)
+	{
+		return Load<Mesh, MeshCache::Staged>(filename,
+		[filename, flipUVY, optimize](MeshCache::Staged& staged, std::string& err)
+		{
+			return ReadMesh(filename, staged, flipUVY, optimize, err);
+		},
+		[keepCPUCopy](MeshCache::Staged& staged)
+		{
+			auto mesh = std::make_unique<Mesh>();
+
+			staged.data.keepCPUCopy = keepCPUCopy;
+			mesh->SetData(staged.data);
+
+			return mesh;
+		});
+	}
+
+	size_t AssetManager::Update()
+	{
+		return RunUploads(s_uploadBudget);
+	}
+
+	void AssetManager::WaitAll()
+	{
+		while (GetPendingCount() > 0)
+			Step();
+	}
+
+	size_t AssetManager::GetPendingCount()
+	{
+		return s_pending.load(std::memory_order_acquire);
+	}
+
+	void AssetManager::QueueUpload(Upload upload)
+	{
+		std::lock_guard<std::mutex> lock(s_uploadMutex);
+		s_uploads.push_back(std::move(upload));
+	}
+
+	JobSystem::Counter& AssetManager::GetReadCounter()
+	{
+		return s_reads;
+	}
+
+	void AssetManager::LoadStarted()
+	{
+		s_pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void AssetManager::LoadFinished()
+	{
+		s_pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	void AssetManager::Step()
+	{
+		//Someone's waiting, so the budget doesn't apply.
+		if (RunUploads(-1.0f) > 0)
+			return;
+
+		//Nothing to upload yet, so help the workers finish reading instead.
+		if (!s_reads.IsDone())
+			JobSystem::Wait(s_reads);
+		else
+			std::this_thread::yield();
+	}
+}
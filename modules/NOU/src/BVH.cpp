@@ -0,0 +1,729 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+BVH.cpp
+A dynamic bounding volume hierarchy, for answering "what's over here?"
+without checking every object in the scene.
+*/
+
+#include "NOU/BVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace nou
+{
+	//More bins find slightly better splits, but take longer to evaluate.
+	//Past 16 or so there isn't much left to gain.
+	static const int NUM_BINS = 16;
+
+	//Traversal stack size for frustum queries. A tree this tall would need
+	//billions of objects if it were balanced.
+	static const int STACK_SIZE = 64;
+
+	//Slab test - where (if anywhere) does the ray enter the box?
+	//The ray is inside the box wherever it's between the box's min and max
+	//planes on all three axes at once.
+	static bool RayHitsBox(const AABB& box, const glm::vec3& origin, const glm::vec3& invDir,
+						   float maxDistance, float& enter)
+	{
+		glm::vec3 t0 = (box.min - origin) * invDir;
+		glm::vec3 t1 = (box.max - origin) * invDir;
+
+		//(Not "near" and "far" - old Windows headers #define those.)
+		glm::vec3 entry = glm::min(t0, t1);
+		glm::vec3 exit = glm::max(t0, t1);
+
+		float tNear = std::max(std::max(entry.x, entry.y), std::max(entry.z, 0.0f));
+		float tFar = std::min(std::min(exit.x, exit.y), std::min(exit.z, maxDistance));
+
+		enter = tNear;
+		return tNear <= tFar;
+	}
+
+	BVH::BVH()
+	{
+		m_root = NONE;
+		m_freeList = NONE;
+		m_leafCount = 0;
+		m_lastRefitCount = 0;
+	}
+
+	uint32_t BVH::AllocateNode()
+	{
+		uint32_t index;
+
+		if (m_freeList != NONE)
+		{
+			index = m_freeList;
+			m_freeList = m_nodes[index].next;
+		}
+		else
+		{
+			index = static_cast<uint32_t>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+
+		Node& node = m_nodes[index];
+		node.bounds = AABB::Empty();
+		node.parent = NONE;
+		node.child[0] = NONE;
+		node.child[1] = NONE;
+		node.userData = 0;
+		node.height = 0;
+		node.moved = false;
+
+		return index;
+	}
+
+	void BVH::FreeNode(uint32_t index)
+	{
+		Node& node = m_nodes[index];
+		node.parent = NONE;
+		node.child[0] = NONE;
+		node.child[1] = NONE;
+		node.height = -1;
+		node.moved = false;
+		node.next = m_freeList;
+
+		m_freeList = index;
+	}
+
+	BVH::Proxy BVH::Insert(const AABB& bounds, uint32_t userData)
+	{
+		uint32_t leaf = AllocateNode();
+		m_nodes[leaf].bounds = bounds;
+		m_nodes[leaf].userData = userData;
+
+		InsertLeaf(leaf);
+		++m_leafCount;
+
+		return leaf;
+	}
+
+	void BVH::Remove(Proxy proxy)
+	{
+		assert(proxy < m_nodes.size() && m_nodes[proxy].height == 0);
+
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+		--m_leafCount;
+	}
+
+	void BVH::Update(Proxy proxy, const AABB& bounds)
+	{
+		Node& leaf = m_nodes[proxy];
+
+		if (leaf.bounds == bounds)
+			return;
+
+		leaf.bounds = bounds;
+
+		if (!leaf.moved)
+		{
+			leaf.moved = true;
+			m_moved.push_back(proxy);
+		}
+	}
+
+	void BVH::Refit()
+	{
+		m_lastRefitCount = 0;
+
+		for (Proxy proxy : m_moved)
+		{
+			//Removed since it was moved.
+			if (!m_nodes[proxy].moved)
+				continue;
+
+			m_nodes[proxy].moved = false;
+
+			uint32_t index = m_nodes[proxy].parent;
+
+			while (index != NONE)
+			{
+				Node& node = m_nodes[index];
+				AABB bounds = AABB::Union(m_nodes[node.child[0]].bounds, m_nodes[node.child[1]].bounds);
+
+				++m_lastRefitCount;
+
+				//If this box didn't change, nothing above it will either
+				//(at least, not because of this object).
+				if (bounds == node.bounds)
+					break;
+
+				node.bounds = bounds;
+				index = node.parent;
+			}
+		}
+
+		m_moved.clear();
+	}
+
+	void BVH::FixUpwards(uint32_t index)
+	{
+		while (index != NONE)
+		{
+			Node& node = m_nodes[index];
+			const Node& a = m_nodes[node.child[0]];
+			const Node& b = m_nodes[node.child[1]];
+
+			node.bounds = AABB::Union(a.bounds, b.bounds);
+			node.height = 1 + std::max(a.height, b.height);
+
+			index = node.parent;
+		}
+	}
+
+	//Greedily walks down from the root, at each step either stopping (and pairing
+	//the leaf up with the current node) or moving into whichever child would grow
+	//the least, depending on which adds the least area to the tree.
+	void BVH::InsertLeaf(uint32_t leaf)
+	{
+		if (m_root == NONE)
+		{
+			m_root = leaf;
+			m_nodes[leaf].parent = NONE;
+			return;
+		}
+
+		AABB leafBounds = m_nodes[leaf].bounds;
+		uint32_t index = m_root;
+
+		while (!m_nodes[index].IsLeaf())
+		{
+			const Node& node = m_nodes[index];
+
+			float area = node.bounds.HalfArea();
+			float combinedArea = AABB::Union(node.bounds, leafBounds).HalfArea();
+
+			//Making a new parent for this node and the leaf adds a box this big.
+			float cost = 2.0f * combinedArea;
+			//Going any further down, this node grows to fit the leaf regardless.
+			float inheritedCost = 2.0f * (combinedArea - area);
+
+			float childCost[2];
+
+			for (int c = 0; c < 2; ++c)
+			{
+				const Node& child = m_nodes[node.child[c]];
+				float grownArea = AABB::Union(child.bounds, leafBounds).HalfArea();
+
+				//Pairing with a leaf adds a whole new box, but going into an internal
+				//node only costs however much it has to grow.
+				if (child.IsLeaf())
+					childCost[c] = grownArea + inheritedCost;
+				else
+					childCost[c] = (grownArea - child.bounds.HalfArea()) + inheritedCost;
+			}
+
+			if (cost < childCost[0] && cost < childCost[1])
+				break;
+
+			index = (childCost[0] < childCost[1]) ? node.child[0] : node.child[1];
+		}
+
+		uint32_t sibling = index;
+		uint32_t oldParent = m_nodes[sibling].parent;
+		//(This may reallocate m_nodes, so no holding on to references across it.)
+		uint32_t newParent = AllocateNode();
+
+		m_nodes[newParent].parent = oldParent;
+		m_nodes[newParent].child[0] = sibling;
+		m_nodes[newParent].child[1] = leaf;
+
+		if (oldParent == NONE)
+			m_root = newParent;
+		else
+		{
+			Node& parent = m_nodes[oldParent];
+			parent.child[(parent.child[0] == sibling) ? 0 : 1] = newParent;
+		}
+
+		m_nodes[sibling].parent = newParent;
+		m_nodes[leaf].parent = newParent;
+
+		FixUpwards(newParent);
+	}
+
+	//The leaf's parent goes away, and its sibling takes the parent's place.
+	void BVH::RemoveLeaf(uint32_t leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = NONE;
+			return;
+		}
+
+		uint32_t parent = m_nodes[leaf].parent;
+		uint32_t grandparent = m_nodes[parent].parent;
+		uint32_t sibling = (m_nodes[parent].child[0] == leaf) ?
+			m_nodes[parent].child[1] : m_nodes[parent].child[0];
+
+		m_nodes[sibling].parent = grandparent;
+
+		if (grandparent == NONE)
+			m_root = sibling;
+		else
+		{
+			Node& node = m_nodes[grandparent];
+			node.child[(node.child[0] == parent) ? 0 : 1] = sibling;
+		}
+
+		FreeNode(parent);
+		m_nodes[leaf].parent = NONE;
+
+		FixUpwards(grandparent);
+	}
+
+	void BVH::Build()
+	{
+		m_buildLeaves.clear();
+		m_buildNodes.clear();
+		m_moved.clear();
+
+		//Keep the leaves (so proxies stay valid), but throw out everything else.
+		m_buildCentroids.resize(m_nodes.size());
+
+		for (uint32_t i = 0; i < m_nodes.size(); ++i)
+		{
+			Node& node = m_nodes[i];
+
+			if (node.height == 0)
+			{
+				node.moved = false;
+				m_buildLeaves.push_back(i);
+				m_buildCentroids[i] = node.bounds.Center();
+			}
+			else if (node.height > 0)
+				FreeNode(i);
+		}
+
+		m_root = NONE;
+
+		if (m_buildLeaves.empty())
+			return;
+
+		struct Task
+		{
+			uint32_t begin;
+			uint32_t end;
+			uint32_t parent;
+			int slot;
+		};
+
+		//Going top-down with our own stack, rather than recursion - a really
+		//lopsided scene could otherwise make for a very deep call stack.
+		std::vector<Task> stack;
+		stack.push_back({ 0, static_cast<uint32_t>(m_buildLeaves.size()), NONE, 0 });
+
+		while (!stack.empty())
+		{
+			Task task = stack.back();
+			stack.pop_back();
+
+			uint32_t index;
+
+			if (task.end - task.begin == 1)
+				index = m_buildLeaves[task.begin];
+			else
+			{
+				index = AllocateNode();
+				m_buildNodes.push_back(index);
+
+				uint32_t mid = Split(task.begin, task.end);
+
+				stack.push_back({ mid, task.end, index, 1 });
+				stack.push_back({ task.begin, mid, index, 0 });
+			}
+
+			m_nodes[index].parent = task.parent;
+
+			if (task.parent == NONE)
+				m_root = index;
+			else
+				m_nodes[task.parent].child[task.slot] = index;
+		}
+
+		//Every internal node was created before its children, so going backwards
+		//through them means children always have their bounds before their parents.
+		for (auto it = m_buildNodes.rbegin(); it != m_buildNodes.rend(); ++it)
+		{
+			Node& node = m_nodes[*it];
+			const Node& a = m_nodes[node.child[0]];
+			const Node& b = m_nodes[node.child[1]];
+
+			node.bounds = AABB::Union(a.bounds, b.bounds);
+			node.height = 1 + std::max(a.height, b.height);
+		}
+	}
+
+	//Binned SAH: rather than trying every possible split position, drop each
+	//object's centroid into one of a handful of evenly spaced bins along each
+	//axis, and only consider splitting between bins. The cost of a split is
+	//(area of the left box * objects on the left) + (same for the right),
+	//i.e., roughly how many objects a random query would end up testing.
+	uint32_t BVH::Split(uint32_t begin, uint32_t end)
+	{
+		uint32_t* leaves = m_buildLeaves.data();
+		const glm::vec3* centroids = m_buildCentroids.data();
+
+		AABB centroidBounds = AABB::Empty();
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			centroidBounds.min = glm::min(centroidBounds.min, centroids[leaves[i]]);
+			centroidBounds.max = glm::max(centroidBounds.max, centroids[leaves[i]]);
+		}
+
+		glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+
+		int bestAxis = -1;
+		int bestBin = 0;
+		float bestCost = FLT_MAX;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			//Everything is in the same spot on this axis, so it's no use to us.
+			if (!(extent[axis] > 0.0f))
+				continue;
+
+			AABB binBounds[NUM_BINS];
+			uint32_t binCounts[NUM_BINS] = {};
+
+			for (auto& bounds : binBounds)
+				bounds = AABB::Empty();
+
+			float scale = NUM_BINS / extent[axis];
+
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				int bin = static_cast<int>((centroids[leaves[i]][axis] - centroidBounds.min[axis]) * scale);
+				bin = std::min(bin, NUM_BINS - 1);
+
+				binBounds[bin] = AABB::Union(binBounds[bin], m_nodes[leaves[i]].bounds);
+				++binCounts[bin];
+			}
+
+			//Sweep from the right to get the cost of everything to the right of
+			//each split, then from the left to finish the job.
+			float rightCost[NUM_BINS];
+			AABB right = AABB::Empty();
+			uint32_t rightCount = 0;
+
+			for (int bin = NUM_BINS - 1; bin > 0; --bin)
+			{
+				right = AABB::Union(right, binBounds[bin]);
+				rightCount += binCounts[bin];
+				rightCost[bin] = (rightCount > 0) ? right.HalfArea() * rightCount : 0.0f;
+			}
+
+			AABB left = AABB::Empty();
+			uint32_t leftCount = 0;
+
+			for (int bin = 1; bin < NUM_BINS; ++bin)
+			{
+				left = AABB::Union(left, binBounds[bin - 1]);
+				leftCount += binCounts[bin - 1];
+
+				//A split with nothing on one side isn't a split.
+				if (leftCount == 0 || leftCount == end - begin)
+					continue;
+
+				float cost = left.HalfArea() * leftCount + rightCost[bin];
+
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = bin;
+				}
+			}
+		}
+
+		//Every centroid is in the same spot - any split is as good as another.
+		if (bestAxis < 0)
+			return begin + (end - begin) / 2;
+
+		float scale = NUM_BINS / extent[bestAxis];
+		float minimum = centroidBounds.min[bestAxis];
+
+		uint32_t* mid = std::partition(leaves + begin, leaves + end, [&](uint32_t leaf)
+		{
+			int bin = static_cast<int>((centroids[leaf][bestAxis] - minimum) * scale);
+			return std::min(bin, NUM_BINS - 1) < bestBin;
+		});
+
+		return static_cast<uint32_t>(mid - leaves);
+	}
+
+	size_t BVH::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const
+	{
+		if (m_root == NONE)
+			return 0;
+
+		size_t found = results.size();
+
+		//Nodes that are entirely in front of some of the planes don't need testing
+		//against those planes again - and neither does anything below them.
+		struct Entry
+		{
+			uint32_t node;
+			uint8_t planeMask;
+		};
+
+		//Each node we visit swaps itself for (at most) its two children, so the
+		//stack never holds more than one entry per level, plus one. That fits
+		//in a plain array for any reasonably balanced tree - only very lopsided
+		//ones (e.g., lots of Inserts along a line, with no Build) need the heap.
+		Entry fixedStack[STACK_SIZE];
+		std::vector<Entry> deepStack;
+		Entry* stack = fixedStack;
+
+		if (m_nodes[m_root].height >= STACK_SIZE)
+		{
+			deepStack.resize(m_nodes[m_root].height + 1);
+			stack = deepStack.data();
+		}
+
+		size_t top = 0;
+		stack[top++] = { m_root, Frustum::ALL_PLANES };
+
+		while (top > 0)
+		{
+			Entry entry = stack[--top];
+			const Node& node = m_nodes[entry.node];
+
+			Frustum::Result result = frustum.TestAABB(node.bounds, entry.planeMask);
+
+			if (result == Frustum::Result::OUTSIDE)
+				continue;
+
+			if (node.IsLeaf())
+			{
+				results.push_back(node.userData);
+				continue;
+			}
+
+			if (result == Frustum::Result::INTERSECTS)
+			{
+				stack[top++] = { node.child[1], entry.planeMask };
+				stack[top++] = { node.child[0], entry.planeMask };
+				continue;
+			}
+
+			//The whole box is inside, so everything under it is too -
+			//just grab its leaves without testing anything else.
+			size_t base = top;
+			stack[top++] = { node.child[1], 0 };
+			stack[top++] = { node.child[0], 0 };
+
+			while (top > base)
+			{
+				const Node& inside = m_nodes[stack[--top].node];
+
+				if (inside.IsLeaf())
+					results.push_back(inside.userData);
+				else
+				{
+					stack[top++] = { inside.child[1], 0 };
+					stack[top++] = { inside.child[0], 0 };
+				}
+			}
+		}
+
+		return results.size() - found;
+	}
+
+	size_t BVH::QueryOverlap(const AABB& bounds, std::vector<uint32_t>& results) const
+	{
+		if (m_root == NONE)
+			return 0;
+
+		size_t found = results.size();
+
+		std::vector<uint32_t> stack;
+		stack.reserve(64);
+		stack.push_back(m_root);
+
+		while (!stack.empty())
+		{
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+
+			if (!node.bounds.Overlaps(bounds))
+				continue;
+
+			if (node.IsLeaf())
+				results.push_back(node.userData);
+			else
+			{
+				stack.push_back(node.child[1]);
+				stack.push_back(node.child[0]);
+			}
+		}
+
+		return results.size() - found;
+	}
+
+	bool BVH::Raycast(const glm::vec3& origin, const glm::vec3& direction,
+					  float maxDistance, RayHit& hit) const
+	{
+		if (m_root == NONE)
+			return false;
+
+		//Dividing by zero here is fine - it gives us infinities,
+		//which the slab test handles correctly.
+		glm::vec3 invDir = 1.0f / direction;
+
+		float best = maxDistance;
+		bool found = false;
+
+		float enter;
+
+		if (!RayHitsBox(m_nodes[m_root].bounds, origin, invDir, best, enter))
+			return false;
+
+		//Each entry remembers where the ray entered its box, so that once we've
+		//found a hit, we can skip anything that starts further away.
+		std::vector<std::pair<uint32_t, float>> stack;
+		stack.reserve(64);
+		stack.push_back({ m_root, enter });
+
+		while (!stack.empty())
+		{
+			auto entry = stack.back();
+			stack.pop_back();
+
+			if (entry.second > best)
+				continue;
+
+			const Node& node = m_nodes[entry.first];
+
+			if (node.IsLeaf())
+			{
+				best = entry.second;
+				hit.userData = node.userData;
+				hit.distance = entry.second;
+				found = true;
+				continue;
+			}
+
+			float childEnter[2];
+			bool childHit[2];
+
+			for (int c = 0; c < 2; ++c)
+				childHit[c] = RayHitsBox(m_nodes[node.child[c]].bounds, origin, invDir, best, childEnter[c]);
+
+			//Visit the nearer child first (i.e., push it last), since it's
+			//more likely to give us a close hit to cut the other one short.
+			int nearer = (childHit[0] && (!childHit[1] || childEnter[0] <= childEnter[1])) ? 0 : 1;
+			int farther = 1 - nearer;
+
+			if (childHit[farther])
+				stack.push_back({ node.child[farther], childEnter[farther] });
+
+			if (childHit[nearer])
+				stack.push_back({ node.child[nearer], childEnter[nearer] });
+		}
+
+		return found;
+	}
+
+	const AABB& BVH::GetBounds(Proxy proxy) const
+	{
+		return m_nodes[proxy].bounds;
+	}
+
+	uint32_t BVH::GetUserData(Proxy proxy) const
+	{
+		return m_nodes[proxy].userData;
+	}
+
+	size_t BVH::Size() const
+	{
+		return m_leafCount;
+	}
+
+	int BVH::GetHeight() const
+	{
+		return (m_root == NONE) ? -1 : m_nodes[m_root].height;
+	}
+
+	float BVH::GetCost() const
+	{
+		if (m_root == NONE)
+			return 0.0f;
+
+		float rootArea = m_nodes[m_root].bounds.HalfArea();
+
+		if (!(rootArea > 0.0f))
+			return 0.0f;
+
+		float total = 0.0f;
+
+		for (const Node& node : m_nodes)
+		{
+			if (node.height > 0)
+				total += node.bounds.HalfArea();
+		}
+
+		return total / rootArea;
+	}
+
+	size_t BVH::LastRefitCount() const
+	{
+		return m_lastRefitCount;
+	}
+
+	BVH::Proxy BVH::InsertTransform(TransformStore& store, TransformStore::Handle handle)
+	{
+		store.SetTrackUpdates(true);
+
+		const glm::vec4& sphere = store.GetWorldBounds(handle);
+
+		if (sphere.w < 0.0f)
+			return NONE;
+
+		if (handle >= m_transformProxies.size())
+			m_transformProxies.resize(handle + 1, NONE);
+
+		Proxy& proxy = m_transformProxies[handle];
+
+		if (proxy != NONE)
+			Update(proxy, AABB::FromSphere(sphere));
+		else
+			proxy = Insert(AABB::FromSphere(sphere), handle);
+
+		return proxy;
+	}
+
+	void BVH::RemoveTransform(TransformStore::Handle handle)
+	{
+		if (handle >= m_transformProxies.size() || m_transformProxies[handle] == NONE)
+			return;
+
+		Remove(m_transformProxies[handle]);
+		m_transformProxies[handle] = NONE;
+	}
+
+	void BVH::Sync(TransformStore& store)
+	{
+		for (TransformStore::Handle handle : store.GetUpdated())
+		{
+			if (handle >= m_transformProxies.size() || m_transformProxies[handle] == NONE)
+				continue;
+
+			const glm::vec4& sphere = store.GetWorldBounds(handle);
+
+			//(If the bounds have since been taken away, the old box is as good as any.)
+			if (sphere.w >= 0.0f)
+				Update(m_transformProxies[handle], AABB::FromSphere(sphere));
+		}
+
+		store.ClearUpdated();
+		Refit();
+	}
+}
@@ -0,0 +1,536 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+BlockCompression.cpp
+CPU encoders for the BC1, BC3, BC5, and BC7 block-compressed formats.
+*/
+
+#include "NOU/BlockCompression.h"
+#include "NOU/JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace nou::BlockCompression
+{
+	namespace
+	{
+		//Fits a line through the block's colours (with N channels each), and returns
+		//the points where the texels at either extreme of it project onto the line.
+		template<int N>
+		void FitLine(const float (&texels)[16][N], float (&lo)[N], float (&hi)[N])
+		{
+			float mean[N] = {};
+
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < N; ++c)
+					mean[c] += texels[i][c] / 16.0f;
+			}
+
+			//The principal axis is the covariance matrix's biggest eigenvector,
+			//which a few rounds of power iteration find well enough.
+			float cov[N][N] = {};
+
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int a = 0; a < N; ++a)
+				{
+					for (int b = 0; b < N; ++b)
+						cov[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+				}
+			}
+
+			float axis[N];
+
+			for (int c = 0; c < N; ++c)
+				axis[c] = 1.0f;
+
+			for (int iter = 0; iter < 8; ++iter)
+			{
+				float next[N] = {};
+				float length = 0.0f;
+
+				for (int a = 0; a < N; ++a)
+				{
+					for (int b = 0; b < N; ++b)
+						next[a] += cov[a][b] * axis[b];
+
+					length += next[a] * next[a];
+				}
+
+				//A flat block (every texel the same colour) has no axis to speak of.
+				if (length < 1e-8f)
+					break;
+
+				length = std::sqrt(length);
+
+				for (int c = 0; c < N; ++c)
+					axis[c] = next[c] / length;
+			}
+
+			float tMin = 0.0f, tMax = 0.0f;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float t = 0.0f;
+
+				for (int c = 0; c < N; ++c)
+					t += (texels[i][c] - mean[c]) * axis[c];
+
+				tMin = std::min(tMin, t);
+				tMax = std::max(tMax, t);
+			}
+
+			for (int c = 0; c < N; ++c)
+			{
+				lo[c] = std::clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+				hi[c] = std::clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+			}
+		}
+
+		//Snaps every texel to its closest palette entry, returning the total squared error.
+		template<int N>
+		float PickIndices(const float (&texels)[16][N], const float (*palette)[N], int paletteSize, int* indices)
+		{
+			float total = 0.0f;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float best = 1e30f;
+
+				for (int p = 0; p < paletteSize; ++p)
+				{
+					float err = 0.0f;
+
+					for (int c = 0; c < N; ++c)
+						err += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+
+					if (err < best)
+					{
+						best = err;
+						indices[i] = p;
+					}
+				}
+
+				total += best;
+			}
+
+			return total;
+		}
+
+		//Given which palette entry each texel uses (as a weight on the first endpoint),
+		//finds the endpoints that minimize the squared error (a least squares fit).
+		template<int N>
+		bool SolveEndpoints(const float (&texels)[16][N], const float* weights, float (&e0)[N], float (&e1)[N])
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[N] = {}, bx[N] = {};
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float a = weights[i], b = 1.0f - a;
+
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+
+				for (int c = 0; c < N; ++c)
+				{
+					ax[c] += a * texels[i][c];
+					bx[c] += b * texels[i][c];
+				}
+			}
+
+			float det = aa * bb - ab * ab;
+
+			if (std::abs(det) < 1e-6f)
+				return false;
+
+			for (int c = 0; c < N; ++c)
+			{
+				e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+				e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+			}
+
+			return true;
+		}
+
+		//Packs bits least significant first, as every BC format expects.
+		class BitWriter
+		{
+			public:
+
+			BitWriter(uint8_t* out, size_t size) : m_out(out), m_pos(0) { memset(out, 0, size); }
+
+			void Write(uint32_t value, int bits)
+			{
+				for (int i = 0; i < bits; ++i, ++m_pos)
+				{
+					if (value & (1u << i))
+						m_out[m_pos / 8] |= static_cast<uint8_t>(1u << (m_pos % 8));
+				}
+			}
+
+			private:
+
+			uint8_t* m_out;
+			size_t m_pos;
+		};
+
+		uint16_t Pack565(const float (&c)[3])
+		{
+			int r = static_cast<int>(c[0] * 31.0f / 255.0f + 0.5f);
+			int g = static_cast<int>(c[1] * 63.0f / 255.0f + 0.5f);
+			int b = static_cast<int>(c[2] * 31.0f / 255.0f + 0.5f);
+
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		//Expands back to 8 bits the way the GPU does.
+		void Unpack565(uint16_t packed, float (&c)[3])
+		{
+			int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+
+			c[0] = static_cast<float>((r << 3) | (r >> 2));
+			c[1] = static_cast<float>((g << 2) | (g >> 4));
+			c[2] = static_cast<float>((b << 3) | (b >> 2));
+		}
+
+		//BC1 palette entries 0-3 as a weight on the first endpoint.
+		const float BC1_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		float TryBC1(const float (&texels)[16][3], uint16_t c0, uint16_t c1, int* indices)
+		{
+			float palette[4][3], e0[3], e1[3];
+			Unpack565(c0, e0);
+			Unpack565(c1, e1);
+
+			for (int p = 0; p < 4; ++p)
+			{
+				for (int c = 0; c < 3; ++c)
+					palette[p][c] = BC1_WEIGHTS[p] * e0[c] + (1.0f - BC1_WEIGHTS[p]) * e1[c];
+			}
+
+			return PickIndices<3>(texels, palette, 4, indices);
+		}
+
+		//The 8 byte colour half of BC1 and BC3 - always in 4 colour mode.
+		void EncodeColor(const unsigned char* rgba, uint8_t* block)
+		{
+			float texels[16][3];
+
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < 3; ++c)
+					texels[i][c] = rgba[i * 4 + c];
+			}
+
+			float lo[3], hi[3];
+			FitLine<3>(texels, lo, hi);
+
+			uint16_t c0 = Pack565(hi), c1 = Pack565(lo);
+			int indices[16];
+			float error = TryBC1(texels, c0, c1, indices);
+
+			//Refit the endpoints to the indices we ended up with, in case that does better.
+			float weights[16], e0[3], e1[3];
+
+			for (int i = 0; i < 16; ++i)
+				weights[i] = BC1_WEIGHTS[indices[i]];
+
+			if (SolveEndpoints<3>(texels, weights, e0, e1))
+			{
+				uint16_t r0 = Pack565(e0), r1 = Pack565(e1);
+				int refined[16];
+
+				if (TryBC1(texels, r0, r1, refined) < error)
+				{
+					c0 = r0;
+					c1 = r1;
+					memcpy(indices, refined, sizeof(indices));
+				}
+			}
+
+			//4 colour mode is signalled by c0 > c1, so swap them around if need be.
+			if (c0 < c1)
+			{
+				std::swap(c0, c1);
+
+				for (int& index : indices)
+					index ^= 1;
+			}
+			else if (c0 == c1)
+			{
+				//That's 3 colour mode, but with both endpoints equal, entry 0 is all we need.
+				std::fill(std::begin(indices), std::end(indices), 0);
+			}
+
+			BitWriter bits(block, 8);
+			bits.Write(c0, 16);
+			bits.Write(c1, 16);
+
+			for (int index : indices)
+				bits.Write(index, 2);
+		}
+
+		//A single channel (BC4), as used for BC3's alpha and BC5's red and green.
+		void EncodeChannel(const unsigned char* rgba, int channel, uint8_t* block)
+		{
+			int lo = 255, hi = 0;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				lo = std::min<int>(lo, rgba[i * 4 + channel]);
+				hi = std::max<int>(hi, rgba[i * 4 + channel]);
+			}
+
+			BitWriter bits(block, 8);
+			bits.Write(hi, 8);
+			bits.Write(lo, 8);
+
+			//With a0 > a1, there are 6 steps between the endpoints. With equal endpoints,
+			//every texel is just a0, so the indices can stay 0.
+			if (hi == lo)
+				return;
+
+			float palette[8];
+			palette[0] = static_cast<float>(hi);
+			palette[1] = static_cast<float>(lo);
+
+			for (int i = 2; i < 8; ++i)
+				palette[i] = ((8 - i) * hi + (i - 1) * lo) / 7.0f;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				float value = rgba[i * 4 + channel];
+				int best = 0;
+
+				for (int p = 1; p < 8; ++p)
+				{
+					if (std::abs(palette[p] - value) < std::abs(palette[best] - value))
+						best = p;
+				}
+
+				bits.Write(best, 3);
+			}
+		}
+
+		//BC7 mode 6's 4 bit index weights, out of 64.
+		const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		//Mode 6 endpoints are 7 bits per channel, plus one extra low bit (the "p-bit")
+		//shared by all of an endpoint's channels. Picks whichever p-bit fits best.
+		void QuantizeBC7(const float (&e)[4], int (&q)[4], int& p)
+		{
+			float bestErr = 1e30f;
+
+			for (int bit = 0; bit < 2; ++bit)
+			{
+				int candidate[4];
+				float err = 0.0f;
+
+				for (int c = 0; c < 4; ++c)
+				{
+					candidate[c] = std::clamp(static_cast<int>(std::floor((e[c] - bit) / 2.0f + 0.5f)), 0, 127);
+					float value = static_cast<float>((candidate[c] << 1) | bit);
+					err += (value - e[c]) * (value - e[c]);
+				}
+
+				if (err < bestErr)
+				{
+					bestErr = err;
+					p = bit;
+					memcpy(q, candidate, sizeof(q));
+				}
+			}
+		}
+
+		float TryBC7(const float (&texels)[16][4], const float (&e0)[4], const float (&e1)[4],
+					 int (&q0)[4], int (&q1)[4], int& p0, int& p1, int* indices)
+		{
+			QuantizeBC7(e0, q0, p0);
+			QuantizeBC7(e1, q1, p1);
+
+			float palette[16][4];
+
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					int a = (q0[c] << 1) | p0, b = (q1[c] << 1) | p1;
+					palette[i][c] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * a + BC7_WEIGHTS[i] * b + 32) >> 6);
+				}
+			}
+
+			return PickIndices<4>(texels, palette, 16, indices);
+		}
+	}
+
+	void EncodeBC1(const unsigned char* texels, uint8_t* block)
+	{
+		EncodeColor(texels, block);
+	}
+
+	void EncodeBC3(const unsigned char* texels, uint8_t* block)
+	{
+		EncodeChannel(texels, 3, block);
+		EncodeColor(texels, block + 8);
+	}
+
+	void EncodeBC5(const unsigned char* texels, uint8_t* block)
+	{
+		EncodeChannel(texels, 0, block);
+		EncodeChannel(texels, 1, block + 8);
+	}
+
+	void EncodeBC7(const unsigned char* texels, uint8_t* block)
+	{
+		float points[16][4];
+
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+				points[i][c] = texels[i * 4 + c];
+		}
+
+		float e0[4], e1[4];
+		FitLine<4>(points, e0, e1);
+
+		int q0[4], q1[4], p0, p1, indices[16];
+		float error = TryBC7(points, e0, e1, q0, q1, p0, p1, indices);
+
+		//As with BC1, see if refitting the endpoints to the indices helps.
+		float weights[16], r0[4], r1[4];
+
+		for (int i = 0; i < 16; ++i)
+			weights[i] = 1.0f - BC7_WEIGHTS[indices[i]] / 64.0f;
+
+		if (SolveEndpoints<4>(points, weights, r0, r1))
+		{
+			int rq0[4], rq1[4], rp0, rp1, refined[16];
+
+			if (TryBC7(points, r0, r1, rq0, rq1, rp0, rp1, refined) < error)
+			{
+				memcpy(q0, rq0, sizeof(q0));
+				memcpy(q1, rq1, sizeof(q1));
+				p0 = rp0;
+				p1 = rp1;
+				memcpy(indices, refined, sizeof(indices));
+			}
+		}
+
+		//The first texel's index only gets 3 bits (its top bit is assumed to be 0),
+		//so if it needs the top bit, swap the endpoints and flip every index instead.
+		if (indices[0] >= 8)
+		{
+			std::swap(q0, q1);
+			std::swap(p0, p1);
+
+			for (int& index : indices)
+				index = 15 - index;
+		}
+
+		BitWriter bits(block, 16);
+
+		//Mode 6 is signalled by six 0 bits, then a 1.
+		bits.Write(1 << 6, 7);
+
+		for (int c = 0; c < 4; ++c)
+		{
+			bits.Write(q0[c], 7);
+			bits.Write(q1[c], 7);
+		}
+
+		bits.Write(p0, 1);
+		bits.Write(p1, 1);
+
+		for (int i = 0; i < 16; ++i)
+			bits.Write(indices[i], (i == 0) ? 3 : 4);
+	}
+
+	void EncodeImage(const unsigned char* pixels, int width, int height, TextureFormat format, uint8_t* out)
+	{
+		if (format == TextureFormat::RGBA8)
+		{
+			memcpy(out, pixels, GetImageSize(format, width, height));
+			return;
+		}
+
+		int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+		size_t blockSize = (format == TextureFormat::BC1) ? 8 : 16;
+
+		JobSystem::ParallelFor(0, blocksY, [&](size_t begin, size_t end)
+		{
+			unsigned char texels[16 * 4];
+
+			for (size_t by = begin; by < end; ++by)
+			{
+				for (int bx = 0; bx < blocksX; ++bx)
+				{
+					//Gather the block, repeating the last row/column past the edges.
+					for (int y = 0; y < 4; ++y)
+					{
+						int py = std::min(static_cast<int>(by) * 4 + y, height - 1);
+
+						for (int x = 0; x < 4; ++x)
+						{
+							int px = std::min(bx * 4 + x, width - 1);
+							memcpy(texels + (y * 4 + x) * 4, pixels + (static_cast<size_t>(py) * width + px) * 4, 4);
+						}
+					}
+
+					uint8_t* block = out + (by * blocksX + bx) * blockSize;
+
+					switch (format)
+					{
+						case TextureFormat::BC1:
+							EncodeBC1(texels, block);
+							break;
+						case TextureFormat::BC3:
+							EncodeBC3(texels, block);
+							break;
+						case TextureFormat::BC5:
+							EncodeBC5(texels, block);
+							break;
+						default:
+							EncodeBC7(texels, block);
+							break;
+					}
+				}
+			}
+		});
+	}
+
+	bool Encode(const TextureData& source, TextureFormat format, TextureData& out)
+	{
+		if (source.format != TextureFormat::RGBA8)
+			return false;
+
+		out.format = format;
+		out.width = source.width;
+		out.height = source.height;
+		out.levels.clear();
+
+		size_t total = 0;
+
+		for (const TextureData::Level& level : source.levels)
+		{
+			size_t size = GetImageSize(format, level.width, level.height);
+			out.levels.push_back({ level.width, level.height, total, size });
+			total += size;
+		}
+
+		out.bytes.resize(total);
+
+		for (size_t i = 0; i < source.levels.size(); ++i)
+		{
+			EncodeImage(source.GetLevelData(i), source.levels[i].width, source.levels[i].height,
+						format, out.bytes.data() + out.levels[i].offset);
+		}
+
+		return true;
+	}
+}
@@ -12,6 +12,8 @@ that we intend the class for use as a component with the ENTT framework.
 
 #include "NOU/CMeshRenderer.h"
 #include "NOU/CCamera.h"
+#include "NOU/FrameUniforms.h"
+#include "NOU/ObjectBuffer.h"
 
 namespace nou
 {
@@ -19,7 +21,7 @@ namespace nou
 	{
 		m_owner = nullptr;
 		m_mat = nullptr;
-		m_vao = nullptr;
+		m_mesh = nullptr;
 	}
 
 	CMeshRenderer::CMeshRenderer(Entity& owner, 
@@ -28,26 +30,22 @@ namespace nou
 	{
 		m_owner = &owner;
 		m_mat = &mat;
-		m_vao = std::make_unique<VertexArray>();
 		SetMesh(mesh);	
 	}
 
-	//This will fetch and bind all of our data (vertices, normals, UVs)
-	//to the VAO used for this renderer.
+	//The mesh keeps a VAO with all of its data (vertices, normals, UVs)
+	//already bound, so all we need to do is hang on to it.
 	//Basically, this makes sure that OpenGL will be able to find all of
 	//the data needed to draw our 3D model.
+	//We also pass the mesh's bounds on to our transform, so the store can
+	//cull us if we're off screen. (If you change the mesh's vertices later,
+	//call this again to update them.)
 	void CMeshRenderer::SetMesh(const Mesh& mesh)
 	{
-		const VertexBuffer* vbo;
+		m_mesh = &mesh;
 
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::POSITION)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::POSITION);
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::NORMAL)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::NORMAL);
-
-		if ((vbo = mesh.GetVBO(Mesh::Attrib::UV)) != nullptr)
-			m_vao->BindAttrib(*vbo, (GLint)Mesh::Attrib::UV);
+		if (m_owner != nullptr)
+			m_owner->transform.SetBounds(mesh.GetBoundingSphere());
 	}
 
 	void CMeshRenderer::SetMaterial(Material& mat)
@@ -57,17 +55,70 @@ namespace nou
 
 	void CMeshRenderer::Draw()
 	{
+		VertexArray* vao = m_mesh->GetVAO();
+
+		if (vao == nullptr)
+			return;
+
 		m_mat->Use();
 
 		auto& transform = m_owner->transform;
+		auto& camera = CCamera::current->Get<CCamera>();
+		const ShaderProgram* program = ShaderProgram::Current();
+
+		//NOU's shaders find the camera in FrameUniforms (sent once per frame, no
+		//matter how many objects we draw), and our matrices in the ObjectBuffer.
+		if (program->UsesFrameUniforms())
+			FrameUniforms::Use(camera);
+		else
+			program->SetUniform("viewproj"_u, camera.GetVP());
 
-		//We are assuming the names used by uniform shader variables as a convention here.
-		//In a larger project, we would have a more elegant system for registering
-		//or even automatically detecting uniform names.
-		ShaderProgram::Current()->SetUniform("viewproj", CCamera::current->Get<CCamera>().GetVP());
-		ShaderProgram::Current()->SetUniform("model", transform.GetGlobal());
-		ShaderProgram::Current()->SetUniform("normal", transform.GetNormal());
+		if (program->UsesObjectBuffer())
+		{
+			GLuint index;
+			ObjectData* data;
+
+			//The program has no model/normal uniforms, so without room in the ring,
+			//we can't draw at all. (ObjectBuffer already said why.)
+			if (!ObjectBuffer::Allocate(1, index, data))
+				return;
+
+			data->Set(ModelMatrix(), transform.GetNormal());
+
+			//The shader finds our entry from the base instance.
+			vao->DrawInstanced(1, index);
+			return;
+		}
+
+		//Otherwise, we are assuming the names used by uniform shader variables as a convention here.
+		program->SetUniform("model"_u, ModelMatrix());
+		program->SetUniform("normal"_u, transform.GetNormal());
 		
-		m_vao->Draw();
+		vao->Draw();
+	}
+
+	void CMeshRenderer::Submit(RenderQueue& queue, RenderQueue::Pass pass)
+	{
+		VertexArray* vao = m_mesh->GetVAO();
+		auto& transform = m_owner->transform;
+
+		//Culling already happened for every object at once (in TransformStore::Cull),
+		//so all that's left here is to check the result.
+		if (vao == nullptr || !transform.IsVisible())
+			return;
+
+		queue.Submit(*m_mat, *vao, m_mesh->GetSortID(),
+					 ModelMatrix(), transform.GetNormal(), pass);
+	}
+
+	glm::mat4 CMeshRenderer::ModelMatrix() const
+	{
+		//Meshes with compressed positions need to be scaled back up to
+		//their real size before anything else happens. Normals are stored
+		//separately, so the normal matrix doesn't need to change.
+		if (m_mesh->HasPositionTransform())
+			return m_owner->transform.GetGlobal() * m_mesh->GetPositionTransform();
+
+		return m_owner->transform.GetGlobal();
 	}
 }
\ No newline at end of file
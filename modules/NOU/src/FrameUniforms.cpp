@@ -0,0 +1,106 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+FrameUniforms.cpp
+Everything shaders need that stays the same for a whole frame (the camera,
+the lights), sent to the GPU once per frame rather than once per draw.
+*/
+
+#include "NOU/FrameUniforms.h"
+#include "NOU/CCamera.h"
+
+namespace nou
+{
+	namespace
+	{
+		//Has to match FrameBlock in the shaders.
+		struct FrameData
+		{
+			glm::mat4 view;
+			glm::mat4 projection;
+			glm::mat4 viewproj;
+			glm::vec4 camPos;
+			glm::vec4 lightDir;
+			glm::vec4 lightColor;
+			glm::vec4 ambient;
+		};
+
+		static_assert(sizeof(FrameData) == 256, "FrameData has to match FrameBlock in the shaders.");
+
+		GLuint s_buffer = 0;
+
+		glm::vec4 s_lightDir = glm::vec4(glm::normalize(glm::vec3(-1.0f, -1.0f, -1.0f)), 0.0f);
+		glm::vec4 s_lightColor = glm::vec4(0.9f, 0.9f, 0.9f, 1.0f);
+		glm::vec4 s_ambient = glm::vec4(1.0f, 1.0f, 1.0f, 0.2f);
+
+		//Whether what's on the GPU is current, and which camera it's from.
+		bool s_current = false;
+		const CCamera* s_camera = nullptr;
+	}
+
+	void FrameUniforms::SetLight(const glm::vec3& direction, const glm::vec3& color)
+	{
+		s_lightDir = glm::vec4(glm::normalize(direction), 0.0f);
+		s_lightColor = glm::vec4(color, 1.0f);
+		s_current = false;
+	}
+
+	void FrameUniforms::SetAmbient(const glm::vec3& color, float power)
+	{
+		s_ambient = glm::vec4(color, power);
+		s_current = false;
+	}
+
+	void FrameUniforms::Update(CCamera& camera)
+	{
+		FrameData data;
+
+		data.view = camera.GetView();
+		data.projection = camera.GetProj();
+		data.viewproj = camera.GetVP();
+		//The view matrix moves the world in front of the camera, so
+		//undoing it moves the origin back to where the camera is.
+		data.camPos = glm::inverse(data.view)[3];
+		data.lightDir = s_lightDir;
+		data.lightColor = s_lightColor;
+		data.ambient = s_ambient;
+
+		if (s_buffer == 0)
+		{
+			glGenBuffers(1, &s_buffer);
+			glBindBuffer(GL_UNIFORM_BUFFER, s_buffer);
+			glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+
+			//Nothing else in NOU uses this binding point, so this only needs doing once.
+			glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, s_buffer);
+		}
+
+		glBindBuffer(GL_UNIFORM_BUFFER, s_buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+
+		s_current = true;
+		s_camera = &camera;
+	}
+
+	void FrameUniforms::Use(CCamera& camera)
+	{
+		if (!s_current || s_camera != &camera)
+			Update(camera);
+	}
+
+	void FrameUniforms::BeginFrame()
+	{
+		s_current = false;
+	}
+
+	void FrameUniforms::Shutdown()
+	{
+		if (s_buffer != 0)
+			glDeleteBuffers(1, &s_buffer);
+
+		s_buffer = 0;
+		s_current = false;
+		s_camera = nullptr;
+	}
+}
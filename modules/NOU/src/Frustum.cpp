@@ -0,0 +1,156 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Frustum.cpp
+The six planes bounding what a camera can see, for culling objects
+that are entirely off screen before we bother drawing them.
+*/
+
+#include "NOU/Frustum.h"
+
+//SSE2 is guaranteed on any 64-bit x86 CPU, so no need to check for it at runtime.
+#if defined(_M_X64) || defined(__x86_64__)
+#define NOU_FRUSTUM_SSE
+#include <emmintrin.h>
+#endif
+
+namespace nou
+{
+	Frustum::Frustum(const glm::mat4& viewProj)
+	{
+		//GLM matrices are stored by column, so pull out the rows we need.
+		glm::vec4 row[4];
+
+		for (int r = 0; r < 4; ++r)
+			row[r] = glm::vec4(viewProj[0][r], viewProj[1][r], viewProj[2][r], viewProj[3][r]);
+
+		//A point is inside the frustum if -w <= x, y, z <= w after projection.
+		//Each of those six comparisons is a plane in world space
+		//(this is the Gribb/Hartmann method, if you want to read up on it).
+		m_planes[0] = row[3] + row[0];
+		m_planes[1] = row[3] - row[0];
+		m_planes[2] = row[3] + row[1];
+		m_planes[3] = row[3] - row[1];
+		m_planes[4] = row[3] + row[2];
+		m_planes[5] = row[3] - row[2];
+
+		//Normalizing lets us compare plane distances against sphere radii directly.
+		for (auto& plane : m_planes)
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	bool Frustum::TestSphere(const glm::vec4& sphere) const
+	{
+		if (sphere.w < 0.0f)
+			return true;
+
+		glm::vec4 center = glm::vec4(glm::vec3(sphere), 1.0f);
+
+		//If the sphere is entirely behind any plane, it's out.
+		for (const auto& plane : m_planes)
+		{
+			if (glm::dot(plane, center) < -sphere.w)
+				return false;
+		}
+
+		return true;
+	}
+
+	Frustum::Result Frustum::TestAABB(const AABB& box) const
+	{
+		uint8_t planeMask = ALL_PLANES;
+		return TestAABB(box, planeMask);
+	}
+
+	Frustum::Result Frustum::TestAABB(const AABB& box, uint8_t& planeMask) const
+	{
+		glm::vec3 center = box.Center();
+		glm::vec3 extent = box.max - center;
+
+		for (int p = 0; p < 6; ++p)
+		{
+			if ((planeMask & (1 << p)) == 0)
+				continue;
+
+			const glm::vec4& plane = m_planes[p];
+			glm::vec3 normal = glm::vec3(plane);
+
+			//How far the box reaches along the plane's normal, either way from its center.
+			//If even its farthest corner is behind the plane, the whole box is -
+			//and if its nearest corner isn't, none of it is.
+			float dist = glm::dot(normal, center) + plane.w;
+			float reach = glm::dot(glm::abs(normal), extent);
+
+			if (dist < -reach)
+				return Result::OUTSIDE;
+
+			if (dist >= reach)
+				planeMask &= ~(1 << p);
+		}
+
+		return (planeMask == 0) ? Result::INSIDE : Result::INTERSECTS;
+	}
+
+	size_t Frustum::TestSpheres(const glm::vec4* spheres, size_t count, uint8_t* visible) const
+	{
+		size_t numVisible = 0;
+		size_t i = 0;
+
+#ifdef NOU_FRUSTUM_SSE
+		//Splat each plane component across a register once up front.
+		__m128 px[6], py[6], pz[6], pw[6];
+
+		for (int p = 0; p < 6; ++p)
+		{
+			px[p] = _mm_set1_ps(m_planes[p].x);
+			py[p] = _mm_set1_ps(m_planes[p].y);
+			pz[p] = _mm_set1_ps(m_planes[p].z);
+			pw[p] = _mm_set1_ps(m_planes[p].w);
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+
+		for (; i + 4 <= count; i += 4)
+		{
+			//Load four spheres and transpose them, so that x holds all four
+			//centers' x coordinates, and so on.
+			__m128 x = _mm_loadu_ps(&spheres[i].x);
+			__m128 y = _mm_loadu_ps(&spheres[i + 1].x);
+			__m128 z = _mm_loadu_ps(&spheres[i + 2].x);
+			__m128 r = _mm_loadu_ps(&spheres[i + 3].x);
+			_MM_TRANSPOSE4_PS(x, y, z, r);
+
+			//Spheres without bounds are always visible.
+			__m128 inside = _mm_cmplt_ps(r, zero);
+			__m128 negRadius = _mm_sub_ps(zero, r);
+			__m128 passAll = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+			for (int p = 0; p < 6; ++p)
+			{
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)),
+										 _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+
+				passAll = _mm_and_ps(passAll, _mm_cmpge_ps(dist, negRadius));
+			}
+
+			int mask = _mm_movemask_ps(_mm_or_ps(inside, passAll));
+
+			for (int k = 0; k < 4; ++k)
+			{
+				visible[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+				numVisible += visible[i + k];
+			}
+		}
+#endif
+
+		//Whatever's left over (or everything, without SSE).
+		for (; i < count; ++i)
+		{
+			visible[i] = TestSphere(spheres[i]) ? 1 : 0;
+			numVisible += visible[i];
+		}
+
+		return numVisible;
+	}
+}
@@ -8,37 +8,144 @@ Helpful reference: https://www.khronos.org/files/gltf20-reference-guide.pdf
 */
 
 #include "NOU/GLTFLoader.h"
+#include "NOU/MappedFile.h"
+#include "NOU/MeshCache.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <filesystem>
 #include <sstream>
 
 #include "tiny_gltf.h"
 
 namespace nou::GLTF
 {
-	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY)
+	//Each mesh in a file (and each option that changes the result) is cached separately.
+	static uint32_t CacheOptions(size_t meshIndex, bool flipUVY, bool optimize)
 	{
+		return ((flipUVY) ? 1 : 0) | ((optimize) ? 2 : 0) | static_cast<uint32_t>(meshIndex << 2);
+	}
+
+	//Extracts one mesh from a parsed file and caches it, reporting how it went.
+	static bool ExtractAndCache(const std::string& filename, const tinygltf::Model& gltf,
+								size_t meshIndex, Mesh& mesh, bool flipUVY, bool optimize,
+								bool keepCPUCopy, std::string& err, std::string& warn)
+	{
+		MeshOptimizer::Report report;
+
+		if (!ExtractGeometry(gltf, meshIndex, mesh, flipUVY, keepCPUCopy, err, warn,
+							 (optimize) ? &report : nullptr))
+			return false;
+
+		//(Without a CPU copy there's nothing to save, so this does nothing.)
+		MeshCache::Save(filename, CacheOptions(meshIndex, flipUVY, optimize), mesh);
+
+		if (optimize)
+			printf("Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f.\n", filename.c_str(),
+				   report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+
+		return true;
+	}
+
+	//Stands in for tinyGLTF's image decoding, keeping each image's file as it is
+	//(in Image::image). Most of the time we only want meshes, and when we do
+	//want textures, they may already be loaded (see GLTF::AssetCache).
+	static bool KeepEncoded(tinygltf::Image* image, const int, std::string*, std::string*,
+							int, int, const unsigned char* bytes, int size, void*)
+	{
+		image->image.assign(bytes, bytes + size);
+		image->width = image->height = image->component = -1;
+
+		return true;
+	}
+
+	//Reads an index of the given size (which may not be aligned).
+	static uint32_t ReadIndex(const unsigned char* index, int size)
+	{
+		if (size == sizeof(GLubyte))
+			return *index;
+
+		if (size == sizeof(GLushort))
+		{
+			GLushort shortIndex;
+			memcpy(&shortIndex, index, sizeof(GLushort));
+			return shortIndex;
+		}
+
+		GLuint intIndex;
+		memcpy(&intIndex, index, sizeof(GLuint));
+		return intIndex;
+	}
+
+	void LoadMesh(const std::string& filename, Mesh& mesh, bool flipUVY, bool optimize, bool keepCPUCopy)
+	{
+		if (MeshCache::Load(filename, CacheOptions(0, flipUVY, optimize), mesh, keepCPUCopy))
+		{
+			printf("Loaded mesh from %s (cached).\n", filename.c_str());
+			return;
+		}
+
 		auto gltf = std::make_unique<tinygltf::Model>();
 
 		std::string err, warn;
 
-		bool result = ParseGLTF(filename, *gltf, err, warn);
+		bool result = ParseGLTF(filename, *gltf, err, warn) &&
+					  ExtractAndCache(filename, *gltf, 0, mesh, flipUVY, optimize, keepCPUCopy, err, warn);
 
-		if (!result)
+		DumpErrorsAndWarnings(filename, err, warn);
+
+		if (result)
+			printf("Loaded mesh from %s.\n", filename.c_str());
+	}
+
+	void LoadMeshes(const std::string& filename, std::vector<std::unique_ptr<Mesh>>& meshes,
+					bool flipUVY, bool optimize, bool keepCPUCopy)
+	{
+		meshes.clear();
+
+		//We need to parse the file to know how many meshes it has,
+		//but can still skip extracting (and optimizing) the cached ones.
+		auto gltf = std::make_unique<tinygltf::Model>();
+
+		std::string err, warn;
+
+		if (!ParseGLTF(filename, *gltf, err, warn))
 		{
 			DumpErrorsAndWarnings(filename, err, warn);
 			return;
 		}
 
-		result = ExtractGeometry(*gltf, mesh, flipUVY, err, warn);
+		LoadMeshes(filename, *gltf, meshes, flipUVY, optimize, keepCPUCopy);
+	}
 
-		if (!result)
+	void LoadMeshes(const std::string& filename, const tinygltf::Model& gltf,
+					std::vector<std::unique_ptr<Mesh>>& meshes,
+					bool flipUVY, bool optimize, bool keepCPUCopy)
+	{
+		meshes.clear();
+
+		std::string err, warn;
+		size_t cached = 0;
+
+		for (size_t i = 0; i < gltf.meshes.size(); ++i)
 		{
-			DumpErrorsAndWarnings(filename, err, warn);
-			return;
+			meshes.push_back(std::make_unique<Mesh>());
+
+			if (MeshCache::Load(filename, CacheOptions(i, flipUVY, optimize), *meshes[i], keepCPUCopy))
+			{
+				++cached;
+				continue;
+			}
+
+			std::string meshErr;
+
+			if (!ExtractAndCache(filename, gltf, i, *meshes[i], flipUVY, optimize, keepCPUCopy, meshErr, warn))
+				err += "Mesh " + std::to_string(i) + ": " + meshErr + "\n";
 		}
 
 		DumpErrorsAndWarnings(filename, err, warn);
-		printf("Loaded mesh from %s.\n", filename.c_str());
+		printf("Loaded %zu meshes from %s (%zu cached).\n", meshes.size(), filename.c_str(), cached);
 	}
 
 	void DumpErrorsAndWarnings(const std::string& filename,
@@ -57,6 +164,7 @@ namespace nou::GLTF
 				   std::string& err, std::string& warn)
 	{
 		auto loader = std::make_unique<tinygltf::TinyGLTF>();
+		loader->SetImageLoader(KeepEncoded, nullptr);
 
 		std::string tinygltfErr, tinygltfWarn;
 
@@ -77,10 +185,28 @@ namespace nou::GLTF
 		}
 
 		bool binary = ext == "glb";
+		bool result;
 
-		bool result = (binary) ? 
-					  loader->LoadBinaryFromFile(&gltf, &tinygltfErr, &tinygltfWarn, filename.c_str())
-					: loader->LoadASCIIFromFile(&gltf, &tinygltfErr, &tinygltfWarn, filename.c_str());
+		if (binary)
+		{
+			//tinyGLTF would read the whole file into a buffer before parsing it
+			//(and then copy the binary chunk out into the model) - mapping the
+			//file instead saves us the first of those copies.
+			MappedFile file(filename);
+
+			if (!file.IsOpen() || file.Size() > UINT_MAX)
+			{
+				err = "Couldn't open " + filename + "\n";
+				return false;
+			}
+
+			result = loader->LoadBinaryFromMemory(&gltf, &tinygltfErr, &tinygltfWarn,
+												  reinterpret_cast<const unsigned char*>(file.Data()),
+												  static_cast<unsigned int>(file.Size()),
+												  std::filesystem::path(filename).parent_path().string());
+		}
+		else
+			result = loader->LoadASCIIFromFile(&gltf, &tinygltfErr, &tinygltfWarn, filename.c_str());
 
 		if (!tinygltfErr.empty())
 		{
@@ -102,16 +228,18 @@ namespace nou::GLTF
 		return result;
 	}
 
-	bool ExtractGeometry(const tinygltf::Model& gltf, Mesh& mesh, bool flipUVY,
-						 std::string& err, std::string& warn)
+	bool ExtractGeometry(const tinygltf::Model& gltf, size_t meshIndex, Mesh& mesh,
+						 bool flipUVY, bool keepCPUCopy,
+						 std::string& err, std::string& warn,
+						 MeshOptimizer::Report* report)
 	{
-		if (gltf.meshes.size() == 0)
+		if (meshIndex >= gltf.meshes.size())
 		{
-			err = "No meshes in file.";
+			err = "No mesh " + std::to_string(meshIndex) + " in file.";
 			return false;
 		}
 			
-		const tinygltf::Mesh& meshData = gltf.meshes[0];
+		const tinygltf::Mesh& meshData = gltf.meshes[meshIndex];
 
 		if (meshData.primitives.size() == 0)
 		{
@@ -119,37 +247,247 @@ namespace nou::GLTF
 			return false;
 		}
 
-		std::vector<glm::vec3> verts;
-		std::vector<glm::vec3> normals;
-		std::vector<glm::vec2> uvs;
+		//If we're not optimizing, there's no reason to copy a single primitive
+		//anywhere - OpenGL can take it straight from the glTF buffers.
+		//(Several primitives have to be stitched together first, though.)
+		if (report == nullptr && meshData.primitives.size() == 1)
+			return UploadPrimitive(gltf, meshIndex, mesh, flipUVY, keepCPUCopy, err, warn);
+
+		MeshCache::Staged staged;
+
+		if (!ExtractGeometry(gltf, meshIndex, flipUVY, staged.verts, staged.normals, staged.uvs,
+							 staged.indices, err, warn, report))
+			return false;
+
+		MeshCache::StageGeometry(staged);
+		staged.data.keepCPUCopy = keepCPUCopy;
+
+		mesh.SetData(staged.data);
+
+		return true;
+	}
+
+	bool ExtractGeometry(const tinygltf::Model& gltf, size_t meshIndex, bool flipUVY,
+						 std::vector<glm::vec3>& verts, std::vector<glm::vec3>& normals,
+						 std::vector<glm::vec2>& uvs, std::vector<uint32_t>& indices,
+						 std::string& err, std::string& warn,
+						 MeshOptimizer::Report* report)
+	{
+		if (meshIndex >= gltf.meshes.size())
+		{
+			err = "No mesh " + std::to_string(meshIndex) + " in file.";
+			return false;
+		}
+
+		const tinygltf::Mesh& meshData = gltf.meshes[meshIndex];
+
+		if (meshData.primitives.size() == 0)
+		{
+			err = "No geometry data associated with mesh.";
+			return false;
+		}
+
+		verts.clear();
+		normals.clear();
+		uvs.clear();
+		indices.clear();
 
 		bool hasNormals = true, hasUVs = true;
 
 		for (size_t i = 0; i < meshData.primitives.size(); ++i)
 		{
-			if(!ProcessPrimitive(gltf, i, verts, uvs, normals, 
+			if(!ProcessPrimitive(gltf, meshIndex, i, verts, uvs, normals, indices,
 						         flipUVY, hasNormals, hasUVs, err, warn))
 				return false;
 		}
 
-		mesh.SetVerts(verts);
+		//Attributes that didn't make it for every primitive aren't used, so don't bother with them.
+		if (!hasNormals)
+			normals.clear();
+
+		if (!hasUVs)
+			uvs.clear();
+
+		if (report != nullptr)
+			*report = MeshOptimizer::OptimizeMesh(verts, normals, uvs, indices);
+
+		return true;
+	}
+
+	bool ReadMesh(const std::string& filename, MeshCache::Staged& staged, bool flipUVY, bool optimize,
+				  std::string& err, std::string& warn)
+	{
+		uint32_t cacheOptions = CacheOptions(0, flipUVY, optimize);
+
+		if (MeshCache::Read(filename, cacheOptions, staged))
+			return true;
+
+		auto gltf = std::make_unique<tinygltf::Model>();
 
-		if(hasNormals)
-			mesh.SetNormals(normals);
+		MeshOptimizer::Report report;
 
-		if(hasUVs)
-			mesh.SetUVs(uvs);
+		if (!ParseGLTF(filename, *gltf, err, warn) ||
+			!ExtractGeometry(*gltf, 0, flipUVY, staged.verts, staged.normals, staged.uvs, staged.indices,
+							 err, warn, (optimize) ? &report : nullptr))
+			return false;
+
+		MeshCache::StageGeometry(staged);
+		MeshCache::Save(filename, cacheOptions, staged.data);
 
 		return true;
 	}
 
-	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t geomIndex,
+	bool ProcessPrimitive(const tinygltf::Model& gltf, size_t meshIndex, size_t geomIndex,
 		                  std::vector<glm::vec3>& verts, std::vector<glm::vec2>& uvs,
-		                  std::vector<glm::vec3>& normals, bool flipUVY,
-						  bool& hasNormals, bool& hasUVs,
+		                  std::vector<glm::vec3>& normals, std::vector<uint32_t>& indices,
+						  bool flipUVY, bool& hasNormals, bool& hasUVs,
 		                  std::string& err, std::string& warn)
 	{
-		const tinygltf::Primitive geom = gltf.meshes[0].primitives[geomIndex];
+		PrimitiveGetters getters;
+
+		if (!BuildPrimitiveGetters(gltf, meshIndex, geomIndex, getters, err, warn))
+			return false;
+
+		const DataGetter& vGetter = getters.verts;
+		const DataGetter& nGetter = getters.normals;
+		const DataGetter& uvGetter = getters.uvs;
+		const DataGetter& faceIndexer = getters.indices;
+
+		hasNormals = hasNormals && getters.hasNormals;
+		hasUVs = hasUVs && getters.hasUVs;
+
+		size_t startIndex = verts.size();
+		size_t vertCount = vGetter.len;
+
+		verts.resize(verts.size() + vertCount);
+
+		if (hasNormals)
+			normals.resize(normals.size() + vertCount);
+
+		if (hasUVs)
+			uvs.resize(uvs.size() + vertCount);
+
+		//This is the bit where we actually get to extracting our data.
+		for (size_t i = startIndex, v = 0; v < vertCount; ++i, ++v)
+		{
+			//Grab our vertex position.
+			memcpy(&verts[i], &vGetter.data[v * vGetter.stride], sizeof(glm::vec3));
+
+			//Grab our vertex normal.
+			if (hasNormals)
+				memcpy(&normals[i], &nGetter.data[v * nGetter.stride], sizeof(glm::vec3));
+
+			//Grab our texture coordinates.
+			if (hasUVs)
+			{
+				memcpy(&uvs[i], &uvGetter.data[v * uvGetter.stride], sizeof(glm::vec2));
+
+				//We may need to flip our vertical UV-coordinate.
+				//You will probably need to do this, depending on your export settings/texture.
+				if (flipUVY)
+					uvs[i].y = 1.0f - uvs[i].y;
+			}
+		}
+
+		size_t firstIndex = indices.size();
+		indices.resize(indices.size() + faceIndexer.len);
+
+		//Now for the faces. Our vertices come after those of any
+		//earlier primitives, so we need to offset the indices to match.
+		for (size_t i = firstIndex, f = 0; f < faceIndexer.len; ++i, ++f)
+		{
+			uint32_t vert = ReadIndex(&faceIndexer.data[f * faceIndexer.stride], faceIndexer.elementSize);
+
+			if (vert >= vertCount)
+			{
+				err = "Primitive " + std::to_string(geomIndex) + " has an index out of range.";
+				return false;
+			}
+
+			indices[i] = static_cast<uint32_t>(startIndex + vert);
+		}
+
+		return true;
+	}
+
+	bool UploadPrimitive(const tinygltf::Model& gltf, size_t meshIndex, Mesh& mesh,
+						 bool flipUVY, bool keepCPUCopy,
+						 std::string& err, std::string& warn)
+	{
+		PrimitiveGetters getters;
+
+		if (!BuildPrimitiveGetters(gltf, meshIndex, 0, getters, err, warn))
+			return false;
+
+		const DataGetter& faceIndexer = getters.indices;
+		size_t vertCount = getters.verts.len;
+
+		//glTF doesn't allow a stride for indices, so they can go up as they are -
+		//once we've made sure none of them point past the end of our vertices.
+		if (faceIndexer.stride != faceIndexer.elementSize)
+		{
+			err = "Primitive indices are interleaved with other data, which glTF doesn't allow.";
+			return false;
+		}
+
+		for (size_t f = 0; f < faceIndexer.len; ++f)
+		{
+			if (ReadIndex(&faceIndexer.data[f * faceIndexer.stride], faceIndexer.elementSize) >= vertCount)
+			{
+				err = "Primitive 0 has an index out of range.";
+				return false;
+			}
+		}
+
+		Mesh::RawData data;
+		data.verts = reinterpret_cast<const glm::vec3*>(getters.verts.data);
+		data.vertStride = getters.verts.stride;
+		data.vertCount = vertCount;
+
+		if (getters.hasNormals)
+		{
+			data.normals = reinterpret_cast<const glm::vec3*>(getters.normals.data);
+			data.normalStride = getters.normals.stride;
+		}
+
+		//Flipped UVs are the one thing we can't just point OpenGL at.
+		std::vector<glm::vec2> flippedUVs;
+
+		if (getters.hasUVs && flipUVY)
+		{
+			flippedUVs.resize(vertCount);
+
+			for (size_t v = 0; v < vertCount; ++v)
+			{
+				memcpy(&flippedUVs[v], &getters.uvs.data[v * getters.uvs.stride], sizeof(glm::vec2));
+				flippedUVs[v].y = 1.0f - flippedUVs[v].y;
+			}
+
+			data.uvs = flippedUVs.data();
+		}
+		else if (getters.hasUVs)
+		{
+			data.uvs = reinterpret_cast<const glm::vec2*>(getters.uvs.data);
+			data.uvStride = getters.uvs.stride;
+		}
+
+		data.indices = faceIndexer.data;
+		data.indexCount = faceIndexer.len;
+		data.indexSize = faceIndexer.elementSize;
+
+		//We haven't been through the vertices yet, so the mesh finds its own bounds.
+		data.computeBounds = true;
+		data.keepCPUCopy = keepCPUCopy;
+
+		mesh.SetData(data);
+
+		return true;
+	}
+
+	bool BuildPrimitiveGetters(const tinygltf::Model& gltf, size_t meshIndex, size_t geomIndex,
+							   PrimitiveGetters& getters, std::string& err, std::string& warn)
+	{
+		const tinygltf::Primitive& geom = gltf.meshes[meshIndex].primitives[geomIndex];
 
 		if (geom.indices == -1)
 		{
@@ -163,12 +501,20 @@ namespace nou::GLTF
 		//glTF stores data per-vertex.
 		//This indexer will allow us to access the data that tells
 		//us which vertices make up the faces of the object.
-		//This allows us to specify our data in the order we need it
-		//for OpenGL vertex buffers - in other words, spelling out the vertex
-		//data as a set of triangles.
-		DataGetter faceIndexer = BuildGetter(gltf, geom.indices);
+		//OpenGL can use these indices directly, so we keep them as they are,
+		//rather than spelling out every triangle's vertices in full.
+		getters.indices = BuildGetter(gltf, geom.indices);
+
+		const DataGetter& faceIndexer = getters.indices;
 
-		if (faceIndexer.elementSize != sizeof(GLshort))
+		if (faceIndexer.data == nullptr)
+		{
+			err = "Primitive " + std::to_string(geomIndex) + " has no index data.";
+			return false;
+		}
+
+		if (faceIndexer.elementSize != sizeof(GLubyte) && faceIndexer.elementSize != sizeof(GLushort) &&
+			faceIndexer.elementSize != sizeof(GLuint))
 		{
 			err = "Primitive indices are in a currently unsupported format. " \
 				"Consider changing your GLTF export settings, or else this loader " \
@@ -186,22 +532,20 @@ namespace nou::GLTF
 		}
 
 		int nID = FindAccessor(geom, "NORMAL");
-		hasNormals = hasNormals && nID != -1;
+		getters.hasNormals = nID != -1;
 
-		if (!hasNormals)
+		if (!getters.hasNormals)
 			warn += "\nNo normals found in mesh primitive " + std::to_string(geomIndex);
 
 		int uvID = FindAccessor(geom, "TEXCOORD_0");
-		hasUVs = hasUVs && uvID != -1;
+		getters.hasUVs = uvID != -1;
 
 		if (uvID == -1)
 			warn += "\nNo UVs found in mesh primitive " + std::to_string(geomIndex);
 
-		DataGetter vGetter, nGetter, uvGetter;
+		const DataGetter& vGetter = getters.verts = BuildGetter(gltf, vID);
 
-		vGetter = BuildGetter(gltf, vID);
-
-		if (vGetter.elementSize != sizeof(glm::vec3))
+		if (vGetter.data == nullptr || vGetter.elementSize != sizeof(glm::vec3))
 		{
 			err = "Vertex position data is in a currently unsupported format. " \
 				"Consider changing your GLTF export settings, or else this loader " \
@@ -210,69 +554,45 @@ namespace nou::GLTF
 			return false;
 		}
 
-		if (hasNormals)
+		if (getters.hasNormals)
 		{
-			nGetter = BuildGetter(gltf, nID);
+			getters.normals = BuildGetter(gltf, nID);
 
-			if (nGetter.elementSize != sizeof(glm::vec3))
+			if (getters.normals.data == nullptr || getters.normals.elementSize != sizeof(glm::vec3))
 			{
-				hasNormals = false;
+				getters.hasNormals = false;
 				warn += "\nNormal data is in a currently unsupported format. " \
 					"Consider changing your GLTF export settings, or else this loader " \
 					"must be augmented to support the provided format.";
 			}
 		}
 
-
-		if (hasUVs)
+		if (getters.hasUVs)
 		{
-			uvGetter = BuildGetter(gltf, uvID);
+			getters.uvs = BuildGetter(gltf, uvID);
 
-			if (uvGetter.elementSize != sizeof(glm::vec2))
+			if (getters.uvs.data == nullptr || getters.uvs.elementSize != sizeof(glm::vec2))
 			{
-				hasUVs = false;
+				getters.hasUVs = false;
 				warn += "\nUV data is in a currently unsupported format. " \
 					"Consider changing your GLTF export settings, or else this loader " \
 					"must be augmented to support the provided format.";
 			}
 		}
 
-		size_t startIndex = verts.size();
+		size_t vertCount = vGetter.len;
 
-		verts.resize(verts.size() + faceIndexer.len);
-
-		if (hasNormals)
-			normals.resize(normals.size() + faceIndexer.len);
-
-		if (hasUVs)
-			uvs.resize(uvs.size() + faceIndexer.len);
-
-		//This is the bit where we actually get to extracting our data.
-		for (size_t i = startIndex, f = 0; i < startIndex + faceIndexer.len && f < faceIndexer.len; ++i, ++f)
+		//Every attribute should have one entry per vertex - if not, the file's broken.
+		if (getters.hasNormals && getters.normals.len != vertCount)
 		{
-			//What vertex do we need to look at?
-			GLshort vertIndex;
-			memcpy(&vertIndex, &faceIndexer.data[f * faceIndexer.stride], sizeof(GLshort));
-
-			size_t vert = vertIndex;
-
-			//Grab our vertex position.
-			memcpy(&verts[i], &vGetter.data[vert * vGetter.stride], sizeof(glm::vec3));
-
-			//Grab our vertex normal.
-			if (hasNormals)
-				memcpy(&normals[i], &nGetter.data[vert * nGetter.stride], sizeof(glm::vec3));
-
-			//Grab our texture coordinates.
-			if (hasUVs)
-			{
-				memcpy(&uvs[i], &uvGetter.data[vert * uvGetter.stride], sizeof(glm::vec2));
+			getters.hasNormals = false;
+			warn += "\nNormal count doesn't match vertex count in mesh primitive " + std::to_string(geomIndex);
+		}
 
-				//We may need to flip our vertical UV-coordinate.
-				//You will probably need to do this, depending on your export settings/texture.
-				if (flipUVY)
-					uvs[i].y = 1.0f - uvs[i].y;
-			}
+		if (getters.hasUVs && getters.uvs.len != vertCount)
+		{
+			getters.hasUVs = false;
+			warn += "\nUV count doesn't match vertex count in mesh primitive " + std::to_string(geomIndex);
 		}
 
 		return true;
@@ -291,15 +611,31 @@ namespace nou::GLTF
 	DataGetter BuildGetter(const tinygltf::Model& gltf, int accIndex)
 	{
 		const tinygltf::Accessor& acc = gltf.accessors[accIndex];
+		int size = tinygltf::GetComponentSizeInBytes(acc.componentType) *
+				   tinygltf::GetNumComponentsInType(acc.type);
+
+		//(Accessors without a buffer view are all zeroes, or sparse - neither of which we handle.)
+		if (acc.bufferView < 0 || acc.bufferView >= (int)gltf.bufferViews.size())
+			return { nullptr, 0, 0, size };
+
 		const tinygltf::BufferView& bv = gltf.bufferViews[acc.bufferView];
+
+		if (bv.buffer < 0 || bv.buffer >= (int)gltf.buffers.size())
+			return { nullptr, 0, 0, size };
+
 		const tinygltf::Buffer& buf = gltf.buffers[bv.buffer];
 
-		const unsigned char* data = &(buf.data[bv.byteOffset + acc.byteOffset]);
 		size_t len = acc.count;
 		int stride = acc.ByteStride(bv);
-		int size = tinygltf::GetComponentSizeInBytes(acc.componentType) *
-				   tinygltf::GetNumComponentsInType(acc.type);
+		size_t offset = bv.byteOffset + acc.byteOffset;
+
+		//Since we hand these straight to OpenGL, make sure it won't read past the end.
+		//(The last element only takes up its own size, not a whole stride.)
+		if (stride <= 0 || (len > 0 && offset + (len - 1) * stride + size > buf.data.size()))
+			return { nullptr, 0, 0, size };
+
+		const unsigned char* data = buf.data.data() + offset;
 
 		return { data, len, stride, size };
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,300 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+GLTFScene.cpp
+Imports a whole glTF scene - node hierarchy, meshes, and materials - as entities.
+*/
+
+#include "NOU/GLTFScene.h"
+#include "NOU/GLTFLoader.h"
+#include "NOU/CMeshRenderer.h"
+
+#include "GLM/gtc/type_ptr.hpp"
+#include "GLM/gtx/matrix_decompose.hpp"
+
+#include <filesystem>
+#include <utility>
+
+#include "tiny_gltf.h"
+
+namespace fs = std::filesystem;
+
+namespace nou::GLTF
+{
+	AssetCache::AssetCache(const ShaderProgram& program, const ShaderProgram& texturedProgram)
+	{
+		m_program = &program;
+		m_texturedProgram = &texturedProgram;
+
+		m_hits = 0;
+		m_misses = 0;
+	}
+
+	TextureHandle AssetCache::GetTexture(const std::string& key, bool useNearest,
+										 const std::function<std::unique_ptr<Texture2D>()>& load)
+	{
+		//The same image filtered differently is a different texture.
+		std::string fullKey = key + ((useNearest) ? "|nearest" : "|linear");
+		auto it = m_textures.find(fullKey);
+
+		if (it != m_textures.end())
+		{
+			++m_hits;
+			return it->second;
+		}
+
+		++m_misses;
+		return m_textures.emplace(std::move(fullKey), TextureCache::Get(key, useNearest, true, load)).first->second;
+	}
+
+	Material& AssetCache::GetMaterial(const std::string& key,
+									  const std::function<std::unique_ptr<Material>()>& create)
+	{
+		auto it = m_materials.find(key);
+
+		if (it != m_materials.end())
+		{
+			++m_hits;
+			return *it->second;
+		}
+
+		++m_misses;
+		return *m_materials.emplace(key, create()).first->second;
+	}
+
+	Material& AssetCache::GetDefaultMaterial()
+	{
+		if (m_defaultMaterial == nullptr)
+			m_defaultMaterial = std::make_unique<Material>(*m_program);
+
+		return *m_defaultMaterial;
+	}
+
+	const ShaderProgram& AssetCache::GetProgram(bool textured) const
+	{
+		return (textured) ? *m_texturedProgram : *m_program;
+	}
+
+	size_t AssetCache::GetTextureCount() const
+	{
+		return m_textures.size();
+	}
+
+	size_t AssetCache::GetMaterialCount() const
+	{
+		return m_materials.size();
+	}
+
+	size_t AssetCache::GetHits() const
+	{
+		return m_hits;
+	}
+
+	size_t AssetCache::GetMisses() const
+	{
+		return m_misses;
+	}
+
+	void AssetCache::Clear()
+	{
+		//Materials point at textures, so they go first.
+		m_materials.clear();
+		m_defaultMaterial.reset();
+		m_textures.clear();
+	}
+
+	//The same file can be reached by different relative paths,
+	//so cache keys go by absolute paths instead.
+	static std::string AbsolutePath(const fs::path& path)
+	{
+		std::error_code ec;
+		fs::path absolute = fs::absolute(path, ec);
+
+		return (ec) ? path.generic_string() : absolute.lexically_normal().generic_string();
+	}
+
+	static TextureHandle ImportTexture(const std::string& filename, const tinygltf::Model& gltf,
+									   int texIndex, AssetCache& cache)
+	{
+		if (texIndex < 0 || texIndex >= (int)gltf.textures.size())
+			return TextureHandle();
+
+		const tinygltf::Texture& tex = gltf.textures[texIndex];
+
+		if (tex.source < 0 || tex.source >= (int)gltf.images.size())
+			return TextureHandle();
+
+		const tinygltf::Image& image = gltf.images[tex.source];
+
+		//(Empty if the image's file couldn't be found.)
+		if (image.image.empty())
+			return TextureHandle();
+
+		bool useNearest = tex.sampler >= 0 && tex.sampler < (int)gltf.samplers.size() &&
+						  gltf.samplers[tex.sampler].magFilter == TINYGLTF_TEXTURE_FILTER_NEAREST;
+
+		//Images in files of their own go by their path, so that models sharing
+		//an image share the texture too. Embedded images go by where they're embedded.
+		std::string key = (!image.uri.empty())
+						? AbsolutePath(fs::path(filename).parent_path() / image.uri)
+						: AbsolutePath(filename) + "#image" + std::to_string(tex.source);
+
+		//ParseGLTF leaves images encoded, so they're only decoded if they weren't already cached.
+		return cache.GetTexture(key, useNearest, [&]()
+		{
+			return std::make_unique<Texture2D>(image.image.data(), image.image.size(), useNearest);
+		});
+	}
+
+	static Material& ImportMaterial(const std::string& filename, const tinygltf::Model& gltf,
+									int matIndex, AssetCache& cache)
+	{
+		if (matIndex < 0 || matIndex >= (int)gltf.materials.size())
+			return cache.GetDefaultMaterial();
+
+		std::string key = AbsolutePath(filename) + "#material" + std::to_string(matIndex);
+
+		return cache.GetMaterial(key, [&]()
+		{
+			const tinygltf::PbrMetallicRoughness& pbr = gltf.materials[matIndex].pbrMetallicRoughness;
+
+			//We only have colour and a single texture to work with,
+			//so the base colour is all we take from glTF's PBR materials.
+			TextureHandle albedo = ImportTexture(filename, gltf, pbr.baseColorTexture.index, cache);
+			bool textured = static_cast<bool>(albedo);
+
+			auto mat = std::make_unique<Material>(cache.GetProgram(textured));
+
+			if (pbr.baseColorFactor.size() >= 3)
+				mat->m_color = glm::vec3(pbr.baseColorFactor[0], pbr.baseColorFactor[1], pbr.baseColorFactor[2]);
+
+			if (textured)
+				mat->AddTexture("albedo", albedo);
+
+			return mat;
+		});
+	}
+
+	//glTF nodes give either a whole matrix, or translation/rotation/scale.
+	static void ImportTransform(const tinygltf::Node& node, Transform& transform)
+	{
+		glm::vec3 pos = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		glm::vec3 scale = glm::vec3(1.0f);
+
+		if (node.matrix.size() == 16)
+		{
+			//Both glTF and GLM store matrices column by column.
+			glm::mat4 matrix = glm::mat4(glm::make_mat4(node.matrix.data()));
+			glm::vec3 skew;
+			glm::vec4 perspective;
+
+			glm::decompose(matrix, scale, rotation, pos, skew, perspective);
+		}
+		else
+		{
+			if (node.translation.size() == 3)
+				pos = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+
+			//glTF quaternions are (x, y, z, w), whereas GLM's constructor takes w first.
+			if (node.rotation.size() == 4)
+				rotation = glm::quat((float)node.rotation[3], (float)node.rotation[0],
+									 (float)node.rotation[1], (float)node.rotation[2]);
+
+			if (node.scale.size() == 3)
+				scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+		}
+
+		transform.SetPosition(pos);
+		transform.SetRotation(rotation);
+		transform.SetScale(scale);
+	}
+
+	bool LoadScene(const std::string& filename, Scene& scene, AssetCache& cache,
+				   bool flipUVY, bool optimize, bool keepCPUCopy)
+	{
+		scene.roots.clear();
+		scene.entities.clear();
+		scene.meshes.clear();
+
+		auto gltf = std::make_unique<tinygltf::Model>();
+
+		std::string err, warn;
+
+		if (!ParseGLTF(filename, *gltf, err, warn))
+		{
+			DumpErrorsAndWarnings(filename, err, warn);
+			return false;
+		}
+
+		if (gltf->scenes.empty())
+		{
+			DumpErrorsAndWarnings(filename, "No scenes in file.", warn);
+			return false;
+		}
+
+		//Every glTF mesh is loaded exactly once, however many nodes use it.
+		LoadMeshes(filename, *gltf, scene.meshes, flipUVY, optimize, keepCPUCopy);
+
+		//Which material each mesh is drawn with.
+		std::vector<Material*> meshMaterials(gltf->meshes.size());
+
+		for (size_t i = 0; i < gltf->meshes.size(); ++i)
+		{
+			const auto& primitives = gltf->meshes[i].primitives;
+			int matIndex = (primitives.empty()) ? -1 : primitives[0].material;
+
+			meshMaterials[i] = &ImportMaterial(filename, *gltf, matIndex, cache);
+		}
+
+		size_t sceneIndex = (gltf->defaultScene >= 0 && gltf->defaultScene < (int)gltf->scenes.size())
+						  ? gltf->defaultScene : 0;
+
+		//Walk the hierarchy depth first, so parents are always created before their children.
+		//(glTF doesn't allow a node to appear twice, but we check so a broken file can't loop forever.)
+		std::vector<bool> visited(gltf->nodes.size(), false);
+		std::vector<std::pair<int, Entity*>> stack;
+
+		const auto& rootNodes = gltf->scenes[sceneIndex].nodes;
+
+		for (auto it = rootNodes.rbegin(); it != rootNodes.rend(); ++it)
+			stack.push_back({ *it, nullptr });
+
+		while (!stack.empty())
+		{
+			auto [nodeIndex, parent] = stack.back();
+			stack.pop_back();
+
+			if (nodeIndex < 0 || nodeIndex >= (int)gltf->nodes.size() || visited[nodeIndex])
+				continue;
+
+			visited[nodeIndex] = true;
+
+			const tinygltf::Node& node = gltf->nodes[nodeIndex];
+
+			scene.entities.push_back(Entity::Allocate());
+			Entity& entity = *scene.entities.back();
+
+			ImportTransform(node, entity.transform);
+
+			if (parent != nullptr)
+				entity.transform.SetParent(&parent->transform);
+			else
+				scene.roots.push_back(&entity);
+
+			if (node.mesh >= 0 && node.mesh < (int)scene.meshes.size())
+				entity.Add<CMeshRenderer>(entity, *scene.meshes[node.mesh], *meshMaterials[node.mesh]);
+
+			for (auto child = node.children.rbegin(); child != node.children.rend(); ++child)
+				stack.push_back({ *child, &entity });
+		}
+
+		DumpErrorsAndWarnings(filename, err, warn);
+		printf("Loaded scene from %s: %zu entities, %zu meshes, %zu materials and %zu textures cached.\n",
+			   filename.c_str(), scene.entities.size(), scene.meshes.size(),
+			   cache.GetMaterialCount(), cache.GetTextureCount());
+
+		return true;
+	}
+}
@@ -0,0 +1,305 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+JobSystem.cpp
+A small work-stealing thread pool.
+*/
+
+#include "NOU/JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nou
+{
+	namespace
+	{
+		struct Task
+		{
+			JobSystem::Job job;
+			JobSystem::Counter* counter;
+		};
+
+		//One per thread. A lock per queue is plenty here - the owner and a thief
+		//only ever contend when the queue is nearly empty, and our jobs are
+		//big enough (whole chunks of a ParallelFor) that the lock is noise.
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		//Queue 0 belongs to the main thread (and any other thread outside the pool).
+		//Queues 1..N belong to the workers.
+		std::vector<std::unique_ptr<WorkQueue>> s_queues;
+		std::vector<std::thread> s_workers;
+
+		std::atomic<bool> s_running = false;
+		//Number of tasks sitting in queues (not counting ones being run).
+		std::atomic<size_t> s_pending = 0;
+
+		//Idle workers sleep here rather than spinning.
+		std::mutex s_sleepMutex;
+		std::condition_variable s_wake;
+
+		std::mutex s_mainMutex;
+		std::vector<JobSystem::Job> s_mainJobs;
+		std::thread::id s_mainThread;
+
+		thread_local size_t t_index = 0;
+		//Counter of the job this thread is currently running (if any),
+		//which becomes the parent of anything it spawns.
+		thread_local JobSystem::Counter* t_counter = nullptr;
+
+		//If the program exits without calling Shutdown(), our workers would still
+		//be asleep on s_wake when it gets destroyed. Since this is declared last,
+		//it gets destroyed first, and makes sure they've been joined.
+		struct ShutdownAtExit
+		{
+			~ShutdownAtExit() { JobSystem::Shutdown(); }
+		} s_shutdownAtExit;
+	}
+
+	//Runs a task, making its counter the "current" one while it runs.
+	void JobSystem::Execute(Job& job, Counter* counter)
+	{
+		Counter* prev = t_counter;
+		t_counter = counter;
+
+		job();
+
+		t_counter = prev;
+
+		//Children were added to the counter before this job returned,
+		//so it can't hit zero until they're done too.
+		if (counter != nullptr)
+			counter->m_count.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	//Tries to grab a task - from the back of our own queue first, then from the
+	//front of everybody else's. Returns false if there was nothing to do.
+	bool JobSystem::TryRunOne(size_t self)
+	{
+		Task task;
+		bool found = false;
+
+		{
+			WorkQueue& own = *s_queues[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				found = true;
+			}
+		}
+
+		for (size_t i = 1; !found && i < s_queues.size(); ++i)
+		{
+			WorkQueue& victim = *s_queues[(self + i) % s_queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				found = true;
+			}
+		}
+
+		if (!found)
+			return false;
+
+		s_pending.fetch_sub(1, std::memory_order_relaxed);
+
+		Execute(task.job, task.counter);
+
+		return true;
+	}
+
+	void JobSystem::WorkerLoop(size_t index)
+	{
+		t_index = index;
+
+		while (true)
+		{
+			if (TryRunOne(index))
+				continue;
+
+			std::unique_lock<std::mutex> lock(s_sleepMutex);
+			s_wake.wait(lock, []() { return s_pending.load() > 0 || !s_running.load(); });
+
+			if (!s_running.load() && s_pending.load() == 0)
+				break;
+		}
+	}
+
+	void JobSystem::Init(size_t numWorkers)
+	{
+		if (s_running)
+			return;
+
+		if (numWorkers == 0)
+		{
+			unsigned int hardware = std::thread::hardware_concurrency();
+			numWorkers = (hardware > 1) ? hardware - 1 : 0;
+		}
+
+		s_mainThread = std::this_thread::get_id();
+		t_index = 0;
+
+		s_queues.clear();
+
+		for (size_t i = 0; i <= numWorkers; ++i)
+			s_queues.push_back(std::make_unique<WorkQueue>());
+
+		s_running = true;
+
+		for (size_t i = 1; i <= numWorkers; ++i)
+			s_workers.emplace_back(WorkerLoop, i);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		if (!s_running)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(s_sleepMutex);
+			s_running = false;
+		}
+
+		//Workers keep going until the queues are empty, then exit.
+		s_wake.notify_all();
+
+		for (auto& worker : s_workers)
+			worker.join();
+
+		s_workers.clear();
+
+		//Anything that was queued by the last job to finish.
+		while (!s_queues.empty() && TryRunOne(0));
+
+		s_queues.clear();
+	}
+
+	size_t JobSystem::GetWorkerCount()
+	{
+		return s_workers.size();
+	}
+
+	size_t JobSystem::GetThreadIndex()
+	{
+		return t_index;
+	}
+
+	bool JobSystem::IsMainThread()
+	{
+		//Before Init, whoever's asking is as "main" as anyone.
+		return s_mainThread == std::thread::id() || s_mainThread == std::this_thread::get_id();
+	}
+
+	void JobSystem::Run(Job job, Counter* counter)
+	{
+		if (counter == nullptr)
+			counter = t_counter;
+
+		if (counter != nullptr)
+			counter->m_count.fetch_add(1, std::memory_order_relaxed);
+
+		//No pool to hand this to, so just do it now.
+		if (s_workers.empty())
+		{
+			Execute(job, counter);
+			return;
+		}
+
+		{
+			WorkQueue& queue = *s_queues[t_index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back({ std::move(job), counter });
+		}
+
+		s_pending.fetch_add(1, std::memory_order_relaxed);
+
+		//Taking the lock (even briefly) makes sure a worker that's about to sleep
+		//either sees the new task or gets our notification.
+		{
+			std::lock_guard<std::mutex> lock(s_sleepMutex);
+		}
+
+		s_wake.notify_one();
+	}
+
+	void JobSystem::Wait(Counter& counter)
+	{
+		while (!counter.IsDone())
+		{
+			if (s_queues.empty() || !TryRunOne(t_index))
+				std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::ParallelFor(size_t begin, size_t end, const RangeJob& job, size_t grainSize)
+	{
+		if (end <= begin)
+			return;
+
+		size_t count = end - begin;
+		size_t threads = GetWorkerCount() + 1;
+
+		//A few chunks per thread gives stealing something to balance with,
+		//without drowning in tiny jobs.
+		if (grainSize == 0)
+			grainSize = std::max<size_t>(1, count / (threads * 4));
+
+		if (threads == 1 || count <= grainSize)
+		{
+			job(begin, end);
+			return;
+		}
+
+		Counter counter;
+
+		//Hand out every chunk but the first, then do the first one ourselves.
+		for (size_t chunk = begin + grainSize; chunk < end; chunk += grainSize)
+		{
+			size_t chunkEnd = std::min(end, chunk + grainSize);
+			Run([&job, chunk, chunkEnd]() { job(chunk, chunkEnd); }, &counter);
+		}
+
+		job(begin, begin + grainSize);
+
+		Wait(counter);
+	}
+
+	void JobSystem::RunOnMainThread(Job job)
+	{
+		std::lock_guard<std::mutex> lock(s_mainMutex);
+		s_mainJobs.push_back(std::move(job));
+	}
+
+	size_t JobSystem::PumpMainThread()
+	{
+		std::vector<Job> jobs;
+
+		{
+			std::lock_guard<std::mutex> lock(s_mainMutex);
+			jobs.swap(s_mainJobs);
+		}
+
+		//Anything these queue up will wait until next time,
+		//so a job can't keep us here forever by re-queueing itself.
+		for (auto& job : jobs)
+			job();
+
+		return jobs.size();
+	}
+}
@@ -0,0 +1,190 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+MappedFile.cpp
+Read-only access to a whole file through memory mapping.
+*/
+
+#include "NOU/MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nou
+{
+	MappedFile::MappedFile(const std::string& filename)
+	{
+		Open(filename);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+
+			std::swap(m_data, other.m_data);
+			std::swap(m_size, other.m_size);
+			std::swap(m_open, other.m_open);
+			std::swap(m_file, other.m_file);
+			std::swap(m_mapping, other.m_mapping);
+		}
+
+		return *this;
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const std::string& filename)
+	{
+		Close();
+
+		//FILE_FLAG_SEQUENTIAL_SCAN hints that we'll read front to back,
+		//so Windows can read ahead more aggressively.
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+								  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_file = file;
+		m_size = static_cast<size_t>(size.QuadPart);
+		m_open = true;
+
+		//Windows refuses to map an empty file, but there's nothing to read anyway.
+		if (m_size == 0)
+			return true;
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		m_mapping = mapping;
+		m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (m_data == nullptr)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+
+		if (m_mapping != nullptr)
+			CloseHandle(static_cast<HANDLE>(m_mapping));
+
+		if (m_file != nullptr)
+			CloseHandle(static_cast<HANDLE>(m_file));
+
+		m_data = nullptr;
+		m_size = 0;
+		m_open = false;
+		m_file = nullptr;
+		m_mapping = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::string& filename)
+	{
+		Close();
+
+		int fd = open(filename.c_str(), O_RDONLY);
+
+		if (fd < 0)
+			return false;
+
+		struct stat info;
+
+		if (fstat(fd, &info) != 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		//We only need the descriptor until the file is mapped.
+		m_size = static_cast<size_t>(info.st_size);
+		m_open = true;
+
+		if (m_size > 0)
+		{
+			void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (data == MAP_FAILED)
+			{
+				close(fd);
+				Close();
+				return false;
+			}
+
+			madvise(data, m_size, MADV_SEQUENTIAL);
+			m_data = static_cast<const char*>(data);
+		}
+
+		close(fd);
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data != nullptr)
+			munmap(const_cast<char*>(m_data), m_size);
+
+		m_data = nullptr;
+		m_size = 0;
+		m_open = false;
+	}
+#endif
+
+	bool MappedFile::IsOpen() const
+	{
+		return m_open;
+	}
+
+	const char* MappedFile::Data() const
+	{
+		return m_data;
+	}
+
+	size_t MappedFile::Size() const
+	{
+		return m_size;
+	}
+}
@@ -8,47 +8,165 @@ used by a model.
 */
 
 #include "NOU/Material.h"
+#include "NOU/MaterialTable.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
 
 namespace nou
 {
+	uint32_t Material::m_nextSortID = 0;
+	std::vector<uint16_t> Material::m_freeSortIDs;
+
 	Material::Material(const ShaderProgram& program)
 	{
 		m_program = &program;
 		m_curSlot = GL_TEXTURE0;
 
+		if (!m_freeSortIDs.empty())
+		{
+			m_sortID = m_freeSortIDs.back();
+			m_freeSortIDs.pop_back();
+		}
+		else if (m_nextSortID <= UINT16_MAX)
+			m_sortID = static_cast<uint16_t>(m_nextSortID++);
+		else
+			throw std::runtime_error("Too many materials at once (the most is 65536)!");
+
 		//Default to white.
 		m_color = glm::vec3(1.0f, 1.0f, 1.0f);
+
+		//Programs that read materials from the MaterialTable find ours by its index.
+		m_tableLoc = program.GetUniformLoc("materialIndex"_u);
+
+		m_tableColor = m_color;
+		MaterialTable::SetColor(m_sortID, m_color);
+	}
+
+	Material::~Material()
+	{
+		MaterialTable::Remove(m_sortID);
+		m_freeSortIDs.push_back(m_sortID);
+	}
+
+	bool Material::HasRoomFor(const std::string& name) const
+	{
+		if (m_curSlot > MAX_SLOT)
+			return false;
+
+		//Programs using the table only ever see the textures in it.
+		if (m_tableLoc >= 0 && m_tex.size() >= MaterialTable::MAX_TEXTURES)
+		{
+			printf("Material: no room for texture %s in the material table (the most is %d).\n",
+				   name.c_str(), MaterialTable::MAX_TEXTURES);
+			return false;
+		}
+
+		return true;
 	}
 
 	bool Material::AddTexture(const std::string& name, const Texture2D& tex)
 	{
-		if(m_curSlot > MAX_SLOT)
+		if (!HasRoomFor(name))
 			return false;
 
 		GLenum slot = m_curSlot;
 		GLint loc = m_program->GetUniformLoc(name);
+		GLuint id = tex.GetID();
+		bool added = true;
 
-		m_tex.push_back({ slot, loc, tex.GetID() });
+		//Only worth putting in the table if the shader is going to look there.
+		//If the texture can't be stored, the slot keeps the plain white
+		//texture every empty slot has.
+		int tableSlot = static_cast<int>(m_tex.size());
+
+		if (m_tableLoc >= 0 && !MaterialTable::SetTexture(m_sortID, tableSlot, tex))
+		{
+			printf("Material: couldn't use texture %s in the material table, using plain white instead.\n",
+				   name.c_str());
+
+			id = MaterialTable::GetDefaultTexture().GetID();
+			added = false;
+		}
+
+		m_tex.push_back({ slot, loc, id });
 
 		//Keep track of which GL texture slots we've already used for this material.
 		++m_curSlot;
 
+		return added;
+	}
+
+	bool Material::AddTexture(const std::string& name, const TextureHandle& tex)
+	{
+		if (!tex || !AddTexture(name, *tex))
+			return false;
+
+		m_handles.push_back(tex);
+
 		return true;
 	}
 
+	bool Material::AddTexture(const std::string& name, const std::string& filename, bool useNearest)
+	{
+		//No point loading a texture we won't have room for.
+		if (!HasRoomFor(name))
+			return false;
+
+		return AddTexture(name, TextureCache::Load(filename, useNearest));
+	}
+
 	void Material::Use()
+	{
+		Bind();
+		Apply();
+	}
+
+	void Material::Bind() const
 	{
 		m_program->Bind();
+	}
+
+	void Material::Apply() const
+	{
+		//Everything the shader needs is already on the GPU, in our table entry,
+		//so all it needs from us is where that is.
+		if (m_tableLoc >= 0)
+		{
+			//(Our colour is public, so we can't know it changed until now.)
+			if (m_color != m_tableColor)
+			{
+				MaterialTable::SetColor(m_sortID, m_color);
+				m_tableColor = m_color;
+			}
+
+			MaterialTable::Bind();
+			glUniform1ui(m_tableLoc, m_sortID);
+
+			return;
+		}
 
-		m_program->SetUniform("matColor", m_color);
+		m_program->SetUniform("matColor"_u, m_color);
 
 		//Bind the textures used by this material.
+		//(The sampler uniform wants the index of the texture unit, while
+		//glActiveTexture wants the GL_TEXTUREn enum itself.)
 		for (auto& t : m_tex)
 		{
-			glUniform1i(t.loc, t.slot);
-			glActiveTexture(t.slot - GL_TEXTURE0);
-			glEnable(GL_TEXTURE_2D);
+			glUniform1i(t.loc, t.slot - GL_TEXTURE0);
+			glActiveTexture(t.slot);
 			glBindTexture(GL_TEXTURE_2D, t.id);
 		}
 	}
+
+	const ShaderProgram& Material::GetProgram() const
+	{
+		return *m_program;
+	}
+
+	uint16_t Material::GetSortID() const
+	{
+		return m_sortID;
+	}
 }
\ No newline at end of file
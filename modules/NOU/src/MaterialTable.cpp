@@ -0,0 +1,484 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+MaterialTable.cpp
+Keeps every material's colour and textures in one big GPU buffer, so that
+switching materials doesn't mean binding any textures.
+*/
+
+#include "NOU/MaterialTable.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace nou
+{
+	namespace
+	{
+		//One material's entry, laid out as std430 wants it:
+		//struct MaterialData { vec4 color; uvec2 textures[4]; };
+		struct Entry
+		{
+			glm::vec4 color;
+			glm::uvec2 textures[MaterialTable::MAX_TEXTURES];
+		};
+
+		static_assert(sizeof(Entry) == 48, "Entry has to match MaterialData in the shaders.");
+
+		//A texture array holding copies of every texture with the same size, format,
+		//and filtering (only used without bindless textures).
+		struct Page
+		{
+			GLuint id;
+			int width, height, mipCount;
+			TextureFormat format;
+			bool nearest;
+
+			GLsizei layers;
+			//Layers in use (or freed - see freeLayers) so far.
+			GLsizei used;
+			std::vector<GLsizei> freeLayers;
+		};
+
+		//Where a texture was copied to, and how many material slots are using the copy.
+		struct PageCopy
+		{
+			size_t page;
+			GLsizei layer;
+			size_t refs;
+		};
+
+		std::vector<Entry> s_entries;
+		//The textures in each entry's slots (0 for none), so we can let go of their copies.
+		std::vector<std::array<GLuint, MaterialTable::MAX_TEXTURES>> s_textures;
+
+		GLuint s_buffer = 0;
+		size_t s_capacity = 0;
+		size_t s_dirtyBegin = 0, s_dirtyEnd = 0;
+		bool s_bound = false;
+
+		std::vector<Page> s_pages;
+		std::unordered_map<GLuint, PageCopy> s_copies;
+
+		//Bindless handles we've made resident, and how many material slots use each.
+		//A resident handle has to be made non-resident before its texture is deleted.
+		struct Resident
+		{
+			GLuint64 handle;
+			size_t refs;
+		};
+
+		std::unordered_map<GLuint, Resident> s_resident;
+
+		std::unique_ptr<Texture2D> s_defaultTexture;
+		//Where the default texture is (its handle, or page and layer). Empty slots
+		//point here, so the shader never sees a handle of 0 (which isn't a texture),
+		//or page 0, layer 0 (which is some other material's texture).
+		glm::uvec2 s_defaultLocation = glm::uvec2(0);
+		bool s_hasDefaultLocation = false;
+
+		//A blank entry, with every slot pointing at the given (default) texture.
+		Entry MakeEntry(const glm::uvec2& empty)
+		{
+			Entry entry;
+			entry.color = glm::vec4(1.0f);
+
+			for (auto& tex : entry.textures)
+				tex = empty;
+
+			return entry;
+		}
+
+		void Grow(uint16_t material, const glm::uvec2& empty)
+		{
+			if (material < s_entries.size())
+				return;
+
+			s_entries.resize(material + 1, MakeEntry(empty));
+			s_textures.resize(material + 1, { 0 });
+		}
+
+		void MarkDirty(size_t material)
+		{
+			if (s_dirtyBegin == s_dirtyEnd)
+			{
+				s_dirtyBegin = material;
+				s_dirtyEnd = material + 1;
+				return;
+			}
+
+			s_dirtyBegin = std::min(s_dirtyBegin, material);
+			s_dirtyEnd = std::max(s_dirtyEnd, material + 1);
+		}
+
+		GLuint CreatePageTexture(const Page& page, GLsizei layers)
+		{
+			GLuint id;
+			glGenTextures(1, &id);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, page.mipCount, GetGLFormat(page.format),
+						   page.width, page.height, layers);
+
+			//The same sampling Texture2D would've set up for each of the originals.
+			GLint minFilter = (page.nearest) ? ((page.mipCount > 1) ? GL_NEAREST_MIPMAP_LINEAR : GL_NEAREST)
+											 : ((page.mipCount > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, minFilter);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (page.nearest) ? GL_NEAREST : GL_LINEAR);
+
+			return id;
+		}
+
+		//Copies layers [0, count) of every mip level from one texture (array) to another.
+		void CopyLayers(const Page& page, GLuint src, GLenum srcTarget, GLsizei srcLayer,
+						GLuint dst, GLsizei dstLayer, GLsizei count)
+		{
+			for (int level = 0; level < page.mipCount; ++level)
+			{
+				glCopyImageSubData(src, srcTarget, level, 0, 0, srcLayer,
+								   dst, GL_TEXTURE_2D_ARRAY, level, 0, 0, dstLayer,
+								   std::max(page.width >> level, 1), std::max(page.height >> level, 1), count);
+			}
+		}
+	}
+
+	glm::uvec2 MaterialTable::GetDefaultLocation()
+	{
+		//The table holds on to the default texture itself (for as long as it exists),
+		//so empty slots don't need a reference of their own.
+		if (!s_hasDefaultLocation)
+		{
+			const Texture2D& tex = GetDefaultTexture();
+
+			s_hasDefaultLocation = (IsBindless()) ? AddResident(tex.GetID(), s_defaultLocation)
+												  : AddToPage(tex, s_defaultLocation);
+
+			if (!s_hasDefaultLocation)
+				s_defaultLocation = glm::uvec2(0);
+		}
+
+		return s_defaultLocation;
+	}
+
+	bool MaterialTable::IsBindless()
+	{
+		return GLAD_GL_ARB_bindless_texture != 0;
+	}
+
+	void MaterialTable::SetColor(uint16_t material, const glm::vec3& color)
+	{
+		Grow(material, GetDefaultLocation());
+
+		s_entries[material].color = glm::vec4(color, 1.0f);
+		MarkDirty(material);
+	}
+
+	bool MaterialTable::SetTexture(uint16_t material, int slot, const Texture2D& tex)
+	{
+		if (slot < 0 || slot >= MAX_TEXTURES || tex.GetMipCount() == 0)
+			return false;
+
+		Grow(material, GetDefaultLocation());
+
+		glm::uvec2 location;
+
+		if (IsBindless())
+		{
+			if (!AddResident(tex.GetID(), location))
+				return false;
+		}
+		else if (!AddToPage(tex, location))
+			return false;
+
+		//Whatever was in the slot before, we're done with.
+		//(Only now, in case it's the same texture going back in.)
+		ReleaseTexture(s_textures[material][slot]);
+
+		s_textures[material][slot] = tex.GetID();
+		s_entries[material].textures[slot] = location;
+		MarkDirty(material);
+
+		return true;
+	}
+
+	const Texture2D& MaterialTable::GetDefaultTexture()
+	{
+		if (s_defaultTexture == nullptr)
+		{
+			const unsigned char white[] = { 255, 255, 255, 255 };
+			s_defaultTexture = std::make_unique<Texture2D>(1, 1, white, false, false);
+		}
+
+		return *s_defaultTexture;
+	}
+
+	void MaterialTable::Remove(uint16_t material)
+	{
+		if (material >= s_entries.size())
+			return;
+
+		for (GLuint tex : s_textures[material])
+			ReleaseTexture(tex);
+
+		s_entries[material] = MakeEntry(GetDefaultLocation());
+		s_textures[material] = { 0 };
+		MarkDirty(material);
+	}
+
+	void MaterialTable::Bind()
+	{
+		if (s_entries.empty())
+			return;
+
+		if (s_buffer == 0)
+			glGenBuffers(1, &s_buffer);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_buffer);
+
+		//Out of room, so everything goes into a new, bigger buffer.
+		if (s_entries.size() > s_capacity)
+		{
+			s_capacity = std::max(s_entries.size(), std::max(s_capacity * 2, size_t(64)));
+
+			glBufferData(GL_SHADER_STORAGE_BUFFER, s_capacity * sizeof(Entry), nullptr, GL_DYNAMIC_DRAW);
+			s_dirtyBegin = 0;
+			s_dirtyEnd = s_entries.size();
+
+			s_bound = false;
+		}
+
+		if (s_dirtyBegin != s_dirtyEnd)
+		{
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, s_dirtyBegin * sizeof(Entry),
+							(s_dirtyEnd - s_dirtyBegin) * sizeof(Entry), s_entries.data() + s_dirtyBegin);
+
+			s_dirtyBegin = s_dirtyEnd = 0;
+		}
+
+		//Nothing else in NOU uses our binding point or texture units, so once
+		//they're bound, they stay that way until something changes.
+		if (s_bound)
+			return;
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, s_buffer);
+
+		for (size_t i = 0; i < s_pages.size(); ++i)
+		{
+			glActiveTexture(GL_TEXTURE0 + FIRST_PAGE_UNIT + static_cast<GLuint>(i));
+			glBindTexture(GL_TEXTURE_2D_ARRAY, s_pages[i].id);
+		}
+
+		glActiveTexture(GL_TEXTURE0);
+
+		s_bound = true;
+	}
+
+	void MaterialTable::ForgetTexture(GLuint texture)
+	{
+		if (s_resident.count(texture) == 0 && s_copies.count(texture) == 0)
+			return;
+
+		//Any material still using the texture gets an empty slot (i.e., the default
+		//texture) instead, which lets go of the texture's handle (or page copy).
+		if (s_defaultTexture == nullptr || texture != s_defaultTexture->GetID())
+		{
+			for (size_t material = 0; material < s_textures.size(); ++material)
+			{
+				for (int slot = 0; slot < MAX_TEXTURES; ++slot)
+				{
+					if (s_textures[material][slot] != texture)
+						continue;
+
+					ReleaseTexture(texture);
+					s_textures[material][slot] = 0;
+					s_entries[material].textures[slot] = GetDefaultLocation();
+					MarkDirty(material);
+				}
+			}
+		}
+
+		//(Only the default texture itself can still be in use here.)
+		auto resident = s_resident.find(texture);
+
+		if (resident != s_resident.end())
+		{
+			glMakeTextureHandleNonResidentARB(resident->second.handle);
+			s_resident.erase(resident);
+		}
+	}
+
+	void MaterialTable::Shutdown()
+	{
+		for (auto& [texture, resident] : s_resident)
+			glMakeTextureHandleNonResidentARB(resident.handle);
+
+		s_resident.clear();
+
+		if (s_buffer != 0)
+			glDeleteBuffers(1, &s_buffer);
+
+		for (Page& page : s_pages)
+			glDeleteTextures(1, &page.id);
+
+		s_entries.clear();
+		s_textures.clear();
+		s_pages.clear();
+		s_copies.clear();
+		s_defaultTexture.reset();
+		s_defaultLocation = glm::uvec2(0);
+		s_hasDefaultLocation = false;
+
+		s_buffer = 0;
+		s_capacity = 0;
+		s_dirtyBegin = s_dirtyEnd = 0;
+		s_bound = false;
+	}
+
+	bool MaterialTable::AddResident(GLuint texture, glm::uvec2& location)
+	{
+		auto resident = s_resident.find(texture);
+
+		//A handle stays the same for the texture's whole life, so if
+		//another material already made it resident, there's nothing to do.
+		if (resident == s_resident.end())
+		{
+			GLuint64 handle = glGetTextureHandleARB(texture);
+
+			if (handle == 0)
+				return false;
+
+			if (!glIsTextureHandleResidentARB(handle))
+				glMakeTextureHandleResidentARB(handle);
+
+			resident = s_resident.emplace(texture, Resident{ handle, 0 }).first;
+		}
+
+		++resident->second.refs;
+
+		//GLSL rebuilds the handle from a uvec2 with the low bits first.
+		GLuint64 handle = resident->second.handle;
+		location = glm::uvec2(static_cast<uint32_t>(handle), static_cast<uint32_t>(handle >> 32));
+
+		return true;
+	}
+
+	void MaterialTable::ReleaseTexture(GLuint texture)
+	{
+		if (texture == 0)
+			return;
+
+		if (!IsBindless())
+		{
+			RemoveFromPage(texture);
+			return;
+		}
+
+		auto resident = s_resident.find(texture);
+
+		if (resident == s_resident.end() || --resident->second.refs > 0)
+			return;
+
+		glMakeTextureHandleNonResidentARB(resident->second.handle);
+		s_resident.erase(resident);
+	}
+
+	bool MaterialTable::AddToPage(const Texture2D& tex, glm::uvec2& location)
+	{
+		//Another material already has a copy of this texture - share it.
+		auto copy = s_copies.find(tex.GetID());
+
+		if (copy != s_copies.end())
+		{
+			++copy->second.refs;
+			location = glm::uvec2(copy->second.page, copy->second.layer);
+			return true;
+		}
+
+		int width, height;
+		tex.GetDimensions(width, height);
+
+		auto matches = [&](const Page& page)
+		{
+			return page.width == width && page.height == height && page.mipCount == tex.GetMipCount() &&
+				   page.format == tex.GetFormat() && page.nearest == tex.IsNearest();
+		};
+
+		size_t index = std::find_if(s_pages.begin(), s_pages.end(), matches) - s_pages.begin();
+
+		if (index == s_pages.size())
+		{
+			if (s_pages.size() >= MAX_PAGES)
+			{
+				printf("MaterialTable: out of texture pages for a %dx%d texture - "
+					   "try using fewer different texture sizes.\n", width, height);
+				return false;
+			}
+
+			Page page;
+			page.width = width;
+			page.height = height;
+			page.mipCount = tex.GetMipCount();
+			page.format = tex.GetFormat();
+			page.nearest = tex.IsNearest();
+			page.layers = 4;
+			page.used = 0;
+			page.id = CreatePageTexture(page, page.layers);
+
+			s_pages.push_back(std::move(page));
+			s_bound = false;
+		}
+
+		Page& page = s_pages[index];
+		GLsizei layer;
+
+		if (!page.freeLayers.empty())
+		{
+			layer = page.freeLayers.back();
+			page.freeLayers.pop_back();
+		}
+		else
+		{
+			//Texture arrays can't be resized, so a full page moves into a new
+			//one twice the size.
+			if (page.used == page.layers)
+			{
+				GLuint grown = CreatePageTexture(page, page.layers * 2);
+
+				CopyLayers(page, page.id, GL_TEXTURE_2D_ARRAY, 0, grown, 0, page.used);
+				glDeleteTextures(1, &page.id);
+
+				page.id = grown;
+				page.layers *= 2;
+				s_bound = false;
+			}
+
+			layer = page.used++;
+		}
+
+		CopyLayers(page, tex.GetID(), GL_TEXTURE_2D, 0, page.id, layer, 1);
+
+		s_copies[tex.GetID()] = { index, layer, 1 };
+		location = glm::uvec2(index, layer);
+
+		return true;
+	}
+
+	void MaterialTable::RemoveFromPage(GLuint texture)
+	{
+		auto copy = s_copies.find(texture);
+
+		if (copy == s_copies.end() || --copy->second.refs > 0)
+			return;
+
+		s_pages[copy->second.page].freeLayers.push_back(copy->second.layer);
+		s_copies.erase(copy);
+	}
+}
@@ -8,28 +8,435 @@ Very basic class for managing the data associated with a 3D model.
 
 #include "NOU/Mesh.h"
 
+#include "GLM/gtc/matrix_transform.hpp"
+#include "GLM/gtc/packing.hpp"
+#include "GLM/gtc/type_precision.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
 namespace nou
 {
+	uint16_t Mesh::m_nextSortID = 0;
+
+	//Octahedral encoding: project the normal onto an octahedron (|x| + |y| + |z| = 1),
+	//then unfold the bottom half of the octahedron over the top half's corners,
+	//giving us a square we can store as 2 numbers instead of 3 - with the error
+	//spread much more evenly over the sphere than, e.g., just dropping z.
+	//This has to match DecodeOct in the *_compressed.vert shaders.
+	static glm::i16vec2 EncodeOct(const glm::vec3& normal)
+	{
+		float length = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+
+		//Degenerate meshes can have zero-length (or NaN) normals, which we can't
+		//divide by - and NaN doesn't survive the conversion to shorts. (0, 0) is +Z.
+		if (!(length > 0.0f) || !std::isfinite(length))
+			return glm::i16vec2(0, 0);
+
+		glm::vec3 n = normal / length;
+		glm::vec2 e = glm::vec2(n);
+
+		if (n.z < 0.0f)
+		{
+			glm::vec2 sign = glm::vec2(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+			e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * sign;
+		}
+
+		//OpenGL maps normalized signed shorts to [-1, 1] as value / 32767.
+		e = glm::round(glm::clamp(e, -1.0f, 1.0f) * 32767.0f);
+
+		return glm::i16vec2(e);
+	}
+
+	//Copies count elements, stride bytes apart (0 for tightly packed), into an array.
+	//The source may not be aligned (e.g., in the middle of a glTF buffer), hence memcpy.
+	template<typename T>
+	static void Gather(std::vector<T>& dest, const T* data, size_t count, size_t stride)
+	{
+		if (data == nullptr)
+		{
+			dest.clear();
+			return;
+		}
+
+		dest.resize(count);
+
+		if (stride == 0 || stride == sizeof(T))
+		{
+			memcpy(dest.data(), data, count * sizeof(T));
+			return;
+		}
+
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+		for (size_t i = 0; i < count; ++i)
+			memcpy(&dest[i], bytes + i * stride, sizeof(T));
+	}
+
+	//Frees an array's memory, not just its contents.
+	template<typename T>
+	static void Release(std::vector<T>& data)
+	{
+		std::vector<T>().swap(data);
+	}
+
+	Mesh::Mesh()
+	{
+		m_sortID = m_nextSortID++;
+		m_format = VertexFormat::FLOAT;
+		m_positionTransform = glm::mat4(1.0f);
+		m_hasCPUCopy = true;
+
+		m_boundsMin = glm::vec3(0.0f);
+		m_boundsMax = glm::vec3(0.0f);
+		m_boundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+	}
+
 	void Mesh::SetVerts(const std::vector<glm::vec3>& verts)
 	{
 		m_verts = verts;
-		SetVBO(Attrib::POSITION, 3, m_verts);
+		ComputeBounds();
+
+		if (m_format == VertexFormat::FLOAT)
+			SetVBO(Attrib::POSITION, 3, m_verts);
+		else
+			UploadInterleaved();
 	}
 
 	void Mesh::SetNormals(const std::vector<glm::vec3>& normals)
 	{
 		m_normals = normals;
-		SetVBO(Attrib::NORMAL, 3, m_normals);			
+
+		if (m_format == VertexFormat::FLOAT)
+			SetVBO(Attrib::NORMAL, 3, m_normals);
+		else
+			UploadInterleaved();
 	}
 
 	void Mesh::SetUVs(const std::vector<glm::vec2>& uvs)
 	{
 		m_uvs = uvs;
-		SetVBO(Attrib::UV, 2, m_uvs);
+
+		if (m_format == VertexFormat::FLOAT)
+			SetVBO(Attrib::UV, 2, m_uvs);
+		else
+			UploadInterleaved();
+	}
+
+	void Mesh::SetVertexFormat(VertexFormat format)
+	{
+		if (format == m_format)
+			return;
+
+		//We'd have nothing to re-upload from.
+		if (!m_hasCPUCopy)
+		{
+			printf("Can't change the vertex format of a mesh with no CPU copy.\n");
+			return;
+		}
+
+		m_format = format;
+		ClearVBOs();
+
+		if (m_format == VertexFormat::FLOAT)
+		{
+			m_positionTransform = glm::mat4(1.0f);
+
+			SetVBO(Attrib::POSITION, 3, m_verts);
+			SetVBO(Attrib::NORMAL, 3, m_normals);
+			SetVBO(Attrib::UV, 2, m_uvs);
+		}
+		else
+			UploadInterleaved();
+	}
+
+	Mesh::VertexFormat Mesh::GetVertexFormat() const
+	{
+		return m_format;
+	}
+
+	size_t Mesh::GetVertexSize() const
+	{
+		if (m_format != VertexFormat::FLOAT)
+			return (m_interleaved != nullptr) ? m_interleaved->ElementSize() : 0;
+
+		size_t size = 0;
+
+		for (const auto& [attrib, vbo] : m_vbo)
+			size += vbo->ElementSize();
+
+		return size;
+	}
+
+	const glm::mat4& Mesh::GetPositionTransform() const
+	{
+		return m_positionTransform;
+	}
+
+	bool Mesh::HasPositionTransform() const
+	{
+		return m_format == VertexFormat::COMPRESSED_HALF_POSITIONS;
+	}
+
+	void Mesh::ClearVBOs()
+	{
+		if (m_vao != nullptr)
+		{
+			for (Attrib attrib : { Attrib::POSITION, Attrib::NORMAL, Attrib::UV })
+				m_vao->UnbindAttrib((GLuint)attrib);
+		}
+
+		m_vbo.clear();
+		m_interleaved.reset();
+	}
+
+	void Mesh::UploadInterleaved()
+	{
+		size_t count = m_verts.size();
+
+		if (count == 0)
+		{
+			ClearVBOs();
+			return;
+		}
+
+		bool halfPositions = (m_format == VertexFormat::COMPRESSED_HALF_POSITIONS);
+		//As with separate buffers, attributes only count if there's one for every vertex.
+		bool hasNormals = (m_normals.size() == count);
+		bool hasUVs = (m_uvs.size() == count);
+
+		//Unsigned shorts cover [0, 1] more precisely than half floats do,
+		//but can't handle UVs that wrap around (e.g., a tiling texture).
+		bool uvsInRange = true;
+
+		for (const auto& uv : m_uvs)
+		{
+			if (glm::any(glm::lessThan(uv, glm::vec2(0.0f))) || glm::any(glm::greaterThan(uv, glm::vec2(1.0f))))
+			{
+				uvsInRange = false;
+				break;
+			}
+		}
+
+		//Every attribute is a multiple of 4 bytes, so everything stays aligned.
+		//(That's why half positions take 8 bytes rather than 6.)
+		size_t posSize = (halfPositions) ? 4 * sizeof(uint16_t) : sizeof(glm::vec3);
+		size_t normalOffset = posSize;
+		size_t uvOffset = normalOffset + ((hasNormals) ? 2 * sizeof(int16_t) : 0);
+		size_t stride = uvOffset + ((hasUVs) ? 2 * sizeof(uint16_t) : 0);
+
+		//Half float positions go from [-1, 1] across the mesh's bounds.
+		glm::vec3 center = (m_boundsMin + m_boundsMax) * 0.5f;
+		glm::vec3 extent = glm::max((m_boundsMax - m_boundsMin) * 0.5f, glm::vec3(1e-6f));
+
+		if (halfPositions)
+			m_positionTransform = glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), extent);
+		else
+			m_positionTransform = glm::mat4(1.0f);
+
+		std::vector<uint8_t> data(count * stride);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint8_t* vert = &data[i * stride];
+
+			if (halfPositions)
+			{
+				glm::vec3 p = (m_verts[i] - center) / extent;
+				//(The 4th component is just padding.)
+				uint32_t packed[2] = { glm::packHalf2x16(glm::vec2(p.x, p.y)),
+									   glm::packHalf2x16(glm::vec2(p.z, 1.0f)) };
+				memcpy(vert, packed, sizeof(packed));
+			}
+			else
+				memcpy(vert, &m_verts[i], sizeof(glm::vec3));
+
+			if (hasNormals)
+			{
+				glm::i16vec2 normal = EncodeOct(m_normals[i]);
+				memcpy(vert + normalOffset, &normal, sizeof(normal));
+			}
+
+			if (hasUVs)
+			{
+				uint32_t uv = (uvsInRange) ? glm::packUnorm2x16(m_uvs[i]) : glm::packHalf2x16(m_uvs[i]);
+				memcpy(vert + uvOffset, &uv, sizeof(uv));
+			}
+		}
+
+		if (m_interleaved == nullptr)
+			m_interleaved = std::make_unique<VertexBuffer>(data.data(), (GLsizei)count, (GLsizei)stride);
+		else
+			m_interleaved->UpdateData(data.data(), (GLsizei)count, (GLsizei)stride);
+
+		if (m_vao == nullptr)
+			m_vao = std::make_unique<VertexArray>();
+
+		m_vao->BindAttrib(*m_interleaved, (GLuint)Attrib::POSITION, 3,
+						  (halfPositions) ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, 0);
+
+		if (hasNormals)
+			m_vao->BindAttrib(*m_interleaved, (GLuint)Attrib::NORMAL, 2, GL_SHORT, GL_TRUE, normalOffset);
+		else
+			m_vao->UnbindAttrib((GLuint)Attrib::NORMAL);
+
+		if (hasUVs)
+		{
+			if (uvsInRange)
+				m_vao->BindAttrib(*m_interleaved, (GLuint)Attrib::UV, 2, GL_UNSIGNED_SHORT, GL_TRUE, uvOffset);
+			else
+				m_vao->BindAttrib(*m_interleaved, (GLuint)Attrib::UV, 2, GL_HALF_FLOAT, GL_FALSE, uvOffset);
+		}
+		else
+			m_vao->UnbindAttrib((GLuint)Attrib::UV);
+	}
+
+	void Mesh::SetIndices(const std::vector<uint32_t>& indices)
+	{
+		m_indices = indices;
+
+		if (m_indices.empty())
+		{
+			if (m_vao != nullptr)
+				m_vao->SetIndexBuffer(nullptr);
+
+			m_ibo.reset();
+			return;
+		}
+
+		uint32_t maxIndex = *std::max_element(m_indices.begin(), m_indices.end());
+
+		//Most models have fewer than 65536 vertices, in which case
+		//we can get away with half the memory for our indices.
+		if (maxIndex <= UINT16_MAX)
+			SetIBO(std::vector<GLushort>(m_indices.begin(), m_indices.end()));
+		else
+			SetIBO(m_indices);
+	}
+
+	const std::vector<uint32_t>& Mesh::GetIndices() const
+	{
+		return m_indices;
+	}
+
+	const std::vector<glm::vec3>& Mesh::GetVerts() const
+	{
+		return m_verts;
+	}
+
+	const std::vector<glm::vec3>& Mesh::GetNormals() const
+	{
+		return m_normals;
+	}
+
+	const std::vector<glm::vec2>& Mesh::GetUVs() const
+	{
+		return m_uvs;
+	}
+
+	void Mesh::SetData(const RawData& data)
+	{
+		size_t count = (data.verts != nullptr) ? data.vertCount : 0;
+		size_t normalCount = (data.normals != nullptr) ? count : 0;
+		size_t uvCount = (data.uvs != nullptr) ? count : 0;
+
+		//Compressed formats are packed from the CPU copy, so we need one
+		//either way - we just don't hang on to it afterwards.
+		if (data.keepCPUCopy || m_format != VertexFormat::FLOAT)
+		{
+			Gather(m_verts, data.verts, count, data.vertStride);
+			Gather(m_normals, data.normals, normalCount, data.normalStride);
+			Gather(m_uvs, data.uvs, uvCount, data.uvStride);
+		}
+		else
+		{
+			Release(m_verts);
+			Release(m_normals);
+			Release(m_uvs);
+		}
+
+		if (data.computeBounds)
+			ComputeBounds(data.verts, count, data.vertStride, m_boundsMin, m_boundsMax, m_boundingSphere);
+		else
+		{
+			m_boundsMin = data.boundsMin;
+			m_boundsMax = data.boundsMax;
+			m_boundingSphere = data.boundingSphere;
+		}
+
+		if (m_format == VertexFormat::FLOAT)
+		{
+			SetVBO(Attrib::POSITION, 3, data.verts, count, data.vertStride);
+			SetVBO(Attrib::NORMAL, 3, data.normals, normalCount, data.normalStride);
+			SetVBO(Attrib::UV, 2, data.uvs, uvCount, data.uvStride);
+		}
+		else
+			UploadInterleaved();
+
+		size_t indexCount = (data.indices != nullptr) ? data.indexCount : 0;
+
+		m_indices.clear();
+
+		//Indices are uploaded in whatever size they were handed to us in.
+		if (indexCount > 0)
+		{
+			if (data.indexSize == sizeof(uint8_t))
+			{
+				const uint8_t* indices = static_cast<const uint8_t*>(data.indices);
+				SetIBO(indices, indexCount);
+
+				if (data.keepCPUCopy)
+					m_indices.assign(indices, indices + indexCount);
+			}
+			else if (data.indexSize == sizeof(uint16_t))
+			{
+				const uint16_t* indices = static_cast<const uint16_t*>(data.indices);
+				SetIBO(indices, indexCount);
+
+				if (data.keepCPUCopy)
+					m_indices.assign(indices, indices + indexCount);
+			}
+			else
+			{
+				const uint32_t* indices = static_cast<const uint32_t*>(data.indices);
+				SetIBO(indices, indexCount);
+
+				if (data.keepCPUCopy)
+					m_indices.assign(indices, indices + indexCount);
+			}
+		}
+
+		if (!data.keepCPUCopy)
+		{
+			Release(m_verts);
+			Release(m_normals);
+			Release(m_uvs);
+			Release(m_indices);
+		}
+
+		m_hasCPUCopy = data.keepCPUCopy;
+
+		if (indexCount == 0)
+		{
+			if (m_vao != nullptr)
+				m_vao->SetIndexBuffer(nullptr);
+
+			m_ibo.reset();
+		}
+	}
+
+	bool Mesh::HasCPUCopy() const
+	{
+		return m_hasCPUCopy;
 	}
 
 	const VertexBuffer* Mesh::GetVBO(Mesh::Attrib attrib) const
 	{
+		if (m_interleaved != nullptr)
+			return m_interleaved.get();
+
 		auto it = m_vbo.find(attrib);
 
 		if (it == m_vbo.end())
@@ -37,4 +444,76 @@ namespace nou
 
 		return it->second.get();
 	}
+
+	const glm::vec3& Mesh::GetBoundsMin() const
+	{
+		return m_boundsMin;
+	}
+
+	const glm::vec3& Mesh::GetBoundsMax() const
+	{
+		return m_boundsMax;
+	}
+
+	const glm::vec4& Mesh::GetBoundingSphere() const
+	{
+		return m_boundingSphere;
+	}
+
+	void Mesh::ComputeBounds()
+	{
+		ComputeBounds(m_verts.data(), m_verts.size(), sizeof(glm::vec3), m_boundsMin, m_boundsMax, m_boundingSphere);
+	}
+
+	void Mesh::ComputeBounds(const glm::vec3* verts, size_t count, size_t stride,
+							 glm::vec3& boundsMin, glm::vec3& boundsMax, glm::vec4& boundingSphere)
+	{
+		if (verts == nullptr || count == 0)
+		{
+			boundsMin = glm::vec3(0.0f);
+			boundsMax = glm::vec3(0.0f);
+			boundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+			return;
+		}
+
+		if (stride == 0)
+			stride = sizeof(glm::vec3);
+
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(verts);
+		glm::vec3 v;
+
+		memcpy(&boundsMin, bytes, sizeof(glm::vec3));
+		boundsMax = boundsMin;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			memcpy(&v, bytes + i * stride, sizeof(glm::vec3));
+			boundsMin = glm::min(boundsMin, v);
+			boundsMax = glm::max(boundsMax, v);
+		}
+
+		//Centering the sphere on the box and then finding the farthest vertex
+		//gives a tighter fit than just using half of the box's diagonal.
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		float radius2 = 0.0f;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			memcpy(&v, bytes + i * stride, sizeof(glm::vec3));
+			glm::vec3 d = v - center;
+			radius2 = glm::max(radius2, glm::dot(d, d));
+		}
+
+		boundingSphere = glm::vec4(center, glm::sqrt(radius2));
+	}
+
+	VertexArray* Mesh::GetVAO() const
+	{
+		return m_vao.get();
+	}
+
+	uint16_t Mesh::GetSortID() const
+	{
+		return m_sortID;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,538 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+MeshCache.cpp
+Saves loaded meshes in a compact binary format, so that the next run can
+skip parsing (and optimizing) them all over again.
+*/
+
+#include "NOU/MeshCache.h"
+#include "NOU/MappedFile.h"
+
+#include "gzip/compress.hpp"
+#include "gzip/decompress.hpp"
+#include "json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace nou::MeshCache
+{
+	namespace
+	{
+		std::string s_directory = "cache";
+		bool s_enabled = true;
+		bool s_compress = false;
+
+		constexpr char MAGIC[4] = { 'N', 'O', 'U', 'M' };
+		constexpr uint32_t MAX_STREAMS = 8;
+
+		//FNV-1a - not much of a hash, but quick and plenty for telling file names apart.
+		uint64_t Hash(const std::string& str, uint64_t hash = 14695981039346656037ull)
+		{
+			for (char c : str)
+			{
+				hash ^= static_cast<uint8_t>(c);
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+
+		uint64_t MakeKey(const std::string& source, uint32_t options)
+		{
+			//The same file can be reached by different relative paths,
+			//so we go by its absolute path instead.
+			std::error_code ec;
+			fs::path path = fs::absolute(source, ec);
+			std::string name = (ec) ? source : path.lexically_normal().generic_string();
+
+			return Hash(std::to_string(options), Hash(name));
+		}
+
+		//Size and modification time of the source file, or false if it's not there.
+		bool StatSource(const std::string& source, uint64_t& size, int64_t& time)
+		{
+			std::error_code ec;
+
+			size = static_cast<uint64_t>(fs::file_size(source, ec));
+
+			if (ec)
+				return false;
+
+			time = static_cast<int64_t>(fs::last_write_time(source, ec).time_since_epoch().count());
+
+			return !ec;
+		}
+
+		//Turns "%20" and friends in a URI back into the characters they stand for.
+		std::string DecodeURI(const std::string& uri)
+		{
+			std::string decoded;
+			decoded.reserve(uri.size());
+
+			for (size_t i = 0; i < uri.size(); ++i)
+			{
+				if (uri[i] == '%' && i + 2 < uri.size() && isxdigit((uint8_t)uri[i + 1]) && isxdigit((uint8_t)uri[i + 2]))
+				{
+					decoded += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+					i += 2;
+				}
+				else
+					decoded += uri[i];
+			}
+
+			return decoded;
+		}
+
+		//The JSON part of a glTF file - the whole thing for a .gltf, or the
+		//first chunk of a .glb. Empty if there isn't one.
+		std::string ReadGLTFJSON(const std::string& source)
+		{
+			MappedFile file;
+
+			if (!file.Open(source) || file.Size() < 4)
+				return std::string();
+
+			const char* data = file.Data();
+
+			if (memcmp(data, "glTF", 4) != 0)
+				return std::string(data, file.Size());
+
+			//12 byte header, then the chunk's length and type ("JSON").
+			uint32_t length;
+
+			if (file.Size() < 20 || memcmp(data + 16, "JSON", 4) != 0)
+				return std::string();
+
+			memcpy(&length, data + 12, sizeof(length));
+
+			if (length > file.Size() - 20)
+				return std::string();
+
+			return std::string(data + 20, length);
+		}
+
+		//glTF files can keep their geometry in other files (usually a .bin next
+		//to a .gltf), which can change without the source itself changing.
+		//This hashes the size and modification time of each of those together,
+		//so that the key changes along with them - or returns 0 if there aren't any.
+		uint64_t DependencyKey(const std::string& source)
+		{
+			std::string ext = fs::path(source).extension().string();
+			std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return (char)tolower((uint8_t)c); });
+
+			if (ext != ".gltf" && ext != ".glb")
+				return 0;
+
+			nlohmann::json json = nlohmann::json::parse(ReadGLTFJSON(source), nullptr, false);
+
+			if (json.is_discarded() || !json.is_object())
+				return 0;
+
+			auto buffers = json.find("buffers");
+
+			if (buffers == json.end() || !buffers->is_array())
+				return 0;
+
+			fs::path directory = fs::path(source).parent_path();
+			uint64_t key = 0;
+
+			for (const auto& buffer : *buffers)
+			{
+				auto uri = buffer.find("uri");
+
+				//Buffers without a URI live in the .glb itself,
+				//and data: URIs are inside the .gltf - both are covered already.
+				if (uri == buffer.end() || !uri->is_string())
+					continue;
+
+				std::string name = uri->get<std::string>();
+
+				if (name.compare(0, 5, "data:") == 0)
+					continue;
+
+				//A missing file still counts, so that it showing up changes the key too.
+				uint64_t size = UINT64_MAX;
+				int64_t time = 0;
+				StatSource((directory / fs::u8path(DecodeURI(name))).string(), size, time);
+
+				key = Hash(name + ":" + std::to_string(size) + ":" + std::to_string(time),
+						   (key == 0) ? 14695981039346656037ull : key);
+			}
+
+			return key;
+		}
+
+		//What goes in a cache file's header - like MakeKey, but also covering
+		//any files the source depends on. (The file name only uses MakeKey, so
+		//that a cache file for an out of date source is replaced, not orphaned.)
+		uint64_t MakeHeaderKey(const std::string& source, uint32_t options)
+		{
+			uint64_t key = MakeKey(source, options);
+			uint64_t dependencies = DependencyKey(source);
+
+			return (dependencies == 0) ? key : Hash(std::to_string(dependencies), key);
+		}
+
+		//A name for Save's temporary file that nobody else is using - another
+		//thread or process might be caching the same source at the same time.
+		//The random part tells processes apart, the counter threads.
+		std::string MakeTempPath(const std::string& path)
+		{
+			static const uint32_t process = std::random_device()();
+			static std::atomic<uint32_t> counter = 0;
+
+			char suffix[32];
+			snprintf(suffix, sizeof(suffix), ".%08x%08x.tmp", process, counter.fetch_add(1));
+
+			return path + suffix;
+		}
+
+		//Rounds up so that every blob in the payload starts 4-byte aligned.
+		size_t Align4(size_t size)
+		{
+			return (size + 3) & ~size_t(3);
+		}
+
+		//Adds a blob to the payload, returning the offset it was written at.
+		uint64_t Append(std::vector<char>& payload, const void* data, size_t size)
+		{
+			size_t offset = payload.size();
+
+			payload.resize(Align4(offset + size));
+
+			if (size > 0)
+				memcpy(payload.data() + offset, data, size);
+
+			return offset;
+		}
+	}
+
+	void SetDirectory(const std::string& directory)
+	{
+		s_directory = directory;
+	}
+
+	const std::string& GetDirectory()
+	{
+		return s_directory;
+	}
+
+	void SetEnabled(bool enabled)
+	{
+		s_enabled = enabled;
+	}
+
+	bool IsEnabled()
+	{
+		return s_enabled;
+	}
+
+	void SetCompression(bool compress)
+	{
+		s_compress = compress;
+	}
+
+	std::string GetCachePath(const std::string& source, uint32_t options)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.nmesh", static_cast<unsigned long long>(MakeKey(source, options)));
+
+		return (fs::path(s_directory) / name).string();
+	}
+
+	bool Load(const std::string& source, uint32_t options, Mesh& mesh, bool keepCPUCopy)
+	{
+		Staged staged;
+
+		if (!Read(source, options, staged))
+			return false;
+
+		staged.data.keepCPUCopy = keepCPUCopy;
+		mesh.SetData(staged.data);
+
+		return true;
+	}
+
+	bool Read(const std::string& source, uint32_t options, Staged& staged)
+	{
+		if (!s_enabled)
+			return false;
+
+		uint64_t sourceSize;
+		int64_t sourceTime;
+
+		if (!StatSource(source, sourceSize, sourceTime))
+			return false;
+
+		MappedFile& file = staged.file;
+
+		if (!file.Open(GetCachePath(source, options)) || file.Size() < sizeof(Header))
+			return false;
+
+		Header header;
+		memcpy(&header, file.Data(), sizeof(Header));
+
+		//Is this actually a cache file, and for the same version of the same source?
+		if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+			header.key != MakeHeaderKey(source, options) ||
+			header.sourceSize != sourceSize || header.sourceTime != sourceTime)
+			return false;
+
+		//Make sure it isn't truncated (e.g., if we crashed while writing it).
+		if (header.streamCount > MAX_STREAMS ||
+			file.Size() != sizeof(Header) + header.streamCount * sizeof(Stream) + header.storedSize)
+			return false;
+
+		const Stream* streams = reinterpret_cast<const Stream*>(file.Data() + sizeof(Header));
+		const char* stored = file.Data() + sizeof(Header) + header.streamCount * sizeof(Stream);
+
+		//Uncompressed payloads are used right where they sit in the file.
+		const char* payload = stored;
+
+		if (header.flags & FLAG_GZIP)
+		{
+			try
+			{
+				gzip::Decompressor decompressor(header.payloadSize + header.storedSize * 2 + 1);
+				decompressor.decompress(staged.payload, stored, header.storedSize);
+			}
+			catch (const std::exception&)
+			{
+				return false;
+			}
+
+			payload = staged.payload.data();
+		}
+
+		if ((header.flags & FLAG_GZIP) ? staged.payload.size() != header.payloadSize
+									   : header.storedSize != header.payloadSize)
+			return false;
+
+		Mesh::RawData& data = staged.data;
+		data = Mesh::RawData();
+		data.vertCount = header.vertCount;
+
+		for (uint32_t i = 0; i < header.streamCount; ++i)
+		{
+			const Stream& stream = streams[i];
+
+			//We only write tightly packed floats for now - anything else
+			//must be from a newer version that forgot to bump VERSION.
+			if (stream.type != GL_FLOAT || stream.stride != stream.components * sizeof(float) ||
+				stream.offset + static_cast<uint64_t>(stream.stride) * header.vertCount > header.payloadSize)
+				return false;
+
+			const void* blob = payload + stream.offset;
+
+			if (stream.attrib == (uint32_t)Mesh::Attrib::POSITION && stream.components == 3)
+				data.verts = static_cast<const glm::vec3*>(blob);
+			else if (stream.attrib == (uint32_t)Mesh::Attrib::NORMAL && stream.components == 3)
+				data.normals = static_cast<const glm::vec3*>(blob);
+			else if (stream.attrib == (uint32_t)Mesh::Attrib::UV && stream.components == 2)
+				data.uvs = static_cast<const glm::vec2*>(blob);
+			else
+				return false;
+		}
+
+		if (data.verts == nullptr || (header.indexSize != 2 && header.indexSize != 4) ||
+			header.indexOffset + static_cast<uint64_t>(header.indexSize) * header.indexCount > header.payloadSize)
+			return false;
+
+		data.indices = payload + header.indexOffset;
+		data.indexCount = header.indexCount;
+		data.indexSize = header.indexSize;
+
+		data.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		data.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+		data.boundingSphere = glm::vec4(header.boundingSphere[0], header.boundingSphere[1],
+										header.boundingSphere[2], header.boundingSphere[3]);
+
+		return true;
+	}
+
+	void StageGeometry(Staged& staged)
+	{
+		Mesh::RawData& data = staged.data;
+		data = Mesh::RawData();
+
+		size_t count = staged.verts.size();
+
+		//As with Mesh itself, attributes only count if there's one for every vertex.
+		data.verts = staged.verts.data();
+		data.normals = (staged.normals.size() == count) ? staged.normals.data() : nullptr;
+		data.uvs = (staged.uvs.size() == count) ? staged.uvs.data() : nullptr;
+		data.vertCount = count;
+
+		Mesh::ComputeBounds(data.verts, count, 0, data.boundsMin, data.boundsMax, data.boundingSphere);
+
+		uint32_t maxIndex = staged.indices.empty() ? 0 : *std::max_element(staged.indices.begin(), staged.indices.end());
+
+		if (maxIndex <= UINT16_MAX)
+		{
+			staged.shortIndices.assign(staged.indices.begin(), staged.indices.end());
+			data.indices = staged.shortIndices.data();
+			data.indexSize = sizeof(uint16_t);
+		}
+		else
+		{
+			data.indices = staged.indices.data();
+			data.indexSize = sizeof(uint32_t);
+		}
+
+		data.indexCount = staged.indices.size();
+	}
+
+	bool Save(const std::string& source, uint32_t options, const Mesh& mesh)
+	{
+		const auto& verts = mesh.GetVerts();
+		const auto& normals = mesh.GetNormals();
+		const auto& uvs = mesh.GetUVs();
+		const auto& indices = mesh.GetIndices();
+
+		Mesh::RawData data;
+		data.verts = verts.data();
+		data.normals = (normals.size() == verts.size()) ? normals.data() : nullptr;
+		data.uvs = (uvs.size() == verts.size()) ? uvs.data() : nullptr;
+		data.vertCount = verts.size();
+
+		data.boundsMin = mesh.GetBoundsMin();
+		data.boundsMax = mesh.GetBoundsMax();
+		data.boundingSphere = mesh.GetBoundingSphere();
+
+		//Indices are stored the same way Mesh::SetIndices would upload them.
+		uint32_t maxIndex = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+		std::vector<uint16_t> shortIndices;
+
+		if (maxIndex <= UINT16_MAX)
+		{
+			shortIndices.assign(indices.begin(), indices.end());
+			data.indices = shortIndices.data();
+			data.indexSize = sizeof(uint16_t);
+		}
+		else
+		{
+			data.indices = indices.data();
+			data.indexSize = sizeof(uint32_t);
+		}
+
+		data.indexCount = indices.size();
+
+		return Save(source, options, data);
+	}
+
+	bool Save(const std::string& source, uint32_t options, const Mesh::RawData& data)
+	{
+		if (!s_enabled)
+			return false;
+
+		uint64_t sourceSize;
+		int64_t sourceTime;
+
+		//Strided data would have to be packed first - loaders don't produce any, so we don't bother.
+		if (data.verts == nullptr || data.vertCount == 0 ||
+			data.vertStride > sizeof(glm::vec3) || data.normalStride > sizeof(glm::vec3) || data.uvStride > sizeof(glm::vec2) ||
+			(data.indexSize != sizeof(uint16_t) && data.indexSize != sizeof(uint32_t)) ||
+			!StatSource(source, sourceSize, sourceTime))
+			return false;
+
+		Header header = {};
+		memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.key = MakeHeaderKey(source, options);
+		header.sourceSize = sourceSize;
+		header.sourceTime = sourceTime;
+		header.vertCount = static_cast<uint32_t>(data.vertCount);
+
+		//The payload holds each attribute one after the other (rather than
+		//interleaved), since that's how Mesh keeps them on the GPU.
+		std::vector<char> payload;
+		std::vector<Stream> streams;
+
+		streams.push_back({ (uint32_t)Mesh::Attrib::POSITION, 3, GL_FLOAT, sizeof(glm::vec3),
+							Append(payload, data.verts, data.vertCount * sizeof(glm::vec3)) });
+
+		if (data.normals != nullptr)
+			streams.push_back({ (uint32_t)Mesh::Attrib::NORMAL, 3, GL_FLOAT, sizeof(glm::vec3),
+								Append(payload, data.normals, data.vertCount * sizeof(glm::vec3)) });
+
+		if (data.uvs != nullptr)
+			streams.push_back({ (uint32_t)Mesh::Attrib::UV, 2, GL_FLOAT, sizeof(glm::vec2),
+								Append(payload, data.uvs, data.vertCount * sizeof(glm::vec2)) });
+
+		header.streamCount = static_cast<uint32_t>(streams.size());
+
+		size_t indexCount = (data.indices != nullptr) ? data.indexCount : 0;
+
+		header.indexCount = static_cast<uint32_t>(indexCount);
+		header.indexSize = static_cast<uint32_t>(data.indexSize);
+		header.indexOffset = Append(payload, data.indices, indexCount * data.indexSize);
+
+		memcpy(header.boundsMin, &data.boundsMin, sizeof(header.boundsMin));
+		memcpy(header.boundsMax, &data.boundsMax, sizeof(header.boundsMax));
+		memcpy(header.boundingSphere, &data.boundingSphere, sizeof(header.boundingSphere));
+		header.payloadSize = payload.size();
+
+		std::string compressed;
+
+		if (s_compress)
+		{
+			compressed = gzip::compress(payload.data(), payload.size());
+			header.flags |= FLAG_GZIP;
+			header.storedSize = compressed.size();
+		}
+		else
+			header.storedSize = payload.size();
+
+		std::string path = GetCachePath(source, options);
+		std::string tempPath = MakeTempPath(path);
+
+		std::error_code ec;
+		fs::create_directories(s_directory, ec);
+
+		//Write to a temporary file first, then swap it in - that way, nobody
+		//(including a later run, if we crash halfway) ever sees half a file.
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+
+			if (!out)
+				return false;
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(streams.data()), streams.size() * sizeof(Stream));
+
+			if (s_compress)
+				out.write(compressed.data(), compressed.size());
+			else
+				out.write(payload.data(), payload.size());
+
+			if (!out)
+			{
+				out.close();
+				fs::remove(tempPath, ec);
+				return false;
+			}
+		}
+
+		fs::rename(tempPath, path, ec);
+
+		if (ec)
+		{
+			fs::remove(tempPath, ec);
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,407 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+MeshOptimizer.cpp
+Reorders mesh data so that the GPU can draw it faster - without changing
+what gets drawn.
+*/
+
+#include "NOU/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace nou::MeshOptimizer
+{
+	//A FIFO cache, tracked with timestamps rather than an actual queue:
+	//a vertex is still in the cache if fewer than cacheSize vertices have
+	//been added since it was.
+	class CacheSim
+	{
+		public:
+
+		CacheSim(size_t vertexCount, size_t cacheSize)
+			: m_added(vertexCount, 0), m_time(static_cast<uint32_t>(cacheSize) + 1), m_size(static_cast<uint32_t>(cacheSize))
+		{
+		}
+
+		//Returns true on a miss (i.e., the vertex shader has to run).
+		bool Access(uint32_t vertex)
+		{
+			if (m_time - m_added[vertex] <= m_size)
+				return false;
+
+			m_added[vertex] = m_time++;
+			return true;
+		}
+
+		void Reset()
+		{
+			//Jumping ahead is the same as flushing everything out.
+			m_time += m_size + 1;
+		}
+
+		protected:
+
+		std::vector<uint32_t> m_added;
+		uint32_t m_time;
+		uint32_t m_size;
+	};
+
+	//For each vertex, the list of triangles using it - stored as one big array,
+	//with vertex v's triangles at [offsets[v], offsets[v + 1]).
+	struct Adjacency
+	{
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+	};
+
+	static void BuildAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount, Adjacency& adj)
+	{
+		adj.offsets.assign(vertexCount + 1, 0);
+
+		for (uint32_t index : indices)
+			++adj.offsets[index + 1];
+
+		for (size_t v = 0; v < vertexCount; ++v)
+			adj.offsets[v + 1] += adj.offsets[v];
+
+		adj.triangles.resize(indices.size());
+		std::vector<uint32_t> fill(adj.offsets.begin(), adj.offsets.end() - 1);
+
+		for (size_t i = 0; i < indices.size(); ++i)
+			adj.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	CacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize)
+	{
+		CacheStats stats;
+
+		if (indices.size() < 3)
+			return stats;
+
+		CacheSim cache(vertexCount, cacheSize);
+		std::vector<uint8_t> used(vertexCount, 0);
+
+		size_t misses = 0;
+		size_t unique = 0;
+
+		for (uint32_t index : indices)
+		{
+			if (cache.Access(index))
+				++misses;
+
+			if (!used[index])
+			{
+				used[index] = 1;
+				++unique;
+			}
+		}
+
+		stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+		stats.atvr = static_cast<float>(misses) / unique;
+
+		return stats;
+	}
+
+	//Tipsify walks the mesh by "fanning" around one vertex at a time - drawing
+	//every remaining triangle that uses it - and then picks the next vertex to
+	//fan around from the ones it just drew, preferring whichever will still be
+	//in the cache after its own triangles have been drawn.
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount,
+							 size_t cacheSize, std::vector<uint32_t>* clusters)
+	{
+		if (clusters != nullptr)
+			clusters->clear();
+
+		size_t triCount = indices.size() / 3;
+
+		if (triCount == 0 || vertexCount == 0)
+			return;
+
+		Adjacency adj;
+		BuildAdjacency(indices, vertexCount, adj);
+
+		//How many not-yet-drawn triangles each vertex is still part of.
+		std::vector<uint32_t> live(vertexCount);
+
+		for (size_t v = 0; v < vertexCount; ++v)
+			live[v] = adj.offsets[v + 1] - adj.offsets[v];
+
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<uint8_t> emitted(triCount, 0);
+
+		//Recently used vertices, to fall back on when we run out of good candidates.
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		uint32_t k = static_cast<uint32_t>(cacheSize);
+		uint32_t time = k + 1;
+		uint32_t cursor = 0;
+
+		//Finds some vertex with triangles left, when our candidates are no good.
+		//Either way, we're jumping somewhere new, so that's the end of a cluster.
+		auto skipDeadEnd = [&]() -> int64_t
+		{
+			if (clusters != nullptr)
+				clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+
+			while (!deadEnd.empty())
+			{
+				uint32_t v = deadEnd.back();
+				deadEnd.pop_back();
+
+				if (live[v] > 0)
+					return v;
+			}
+
+			while (cursor < vertexCount)
+			{
+				if (live[cursor] > 0)
+					return cursor;
+
+				++cursor;
+			}
+
+			return -1;
+		};
+
+		int64_t fan = skipDeadEnd();
+
+		while (fan >= 0)
+		{
+			candidates.clear();
+
+			for (uint32_t a = adj.offsets[fan]; a < adj.offsets[fan + 1]; ++a)
+			{
+				uint32_t tri = adj.triangles[a];
+
+				if (emitted[tri])
+					continue;
+
+				emitted[tri] = 1;
+
+				for (int c = 0; c < 3; ++c)
+				{
+					uint32_t v = indices[tri * 3 + c];
+
+					result.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+
+					--live[v];
+
+					if (time - cacheTime[v] > k)
+						cacheTime[v] = time++;
+				}
+			}
+
+			//Pick the candidate that's been in the cache the longest, as long as
+			//it'll still be there once its remaining triangles have been drawn
+			//(each of which adds up to 2 new vertices).
+			int64_t best = -1;
+			int64_t bestPriority = -1;
+
+			for (uint32_t v : candidates)
+			{
+				if (live[v] == 0)
+					continue;
+
+				int64_t priority = 0;
+
+				if (time - cacheTime[v] + 2 * live[v] <= k)
+					priority = time - cacheTime[v];
+
+				if (priority > bestPriority)
+				{
+					best = v;
+					bestPriority = priority;
+				}
+			}
+
+			fan = (best >= 0) ? best : skipDeadEnd();
+		}
+
+		//(The last skipDeadEnd found nothing, so it doesn't start a cluster.)
+		if (clusters != nullptr)
+			clusters->pop_back();
+
+		indices.swap(result);
+	}
+
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const void* positions, size_t stride,
+						  size_t vertexCount, size_t cacheSize, float threshold)
+	{
+		size_t triCount = indices.size() / 3;
+
+		if (triCount == 0 || vertexCount == 0)
+			return;
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(positions);
+
+		auto position = [&](uint32_t v)
+		{
+			glm::vec3 p;
+			memcpy(&p, bytes + v * stride, sizeof(glm::vec3));
+			return p;
+		};
+
+		//The cache optimization's clusters are where it already had to jump
+		//somewhere new - so we can move them around for free.
+		std::vector<uint32_t> hard;
+		OptimizeVertexCache(indices, vertexCount, cacheSize, &hard);
+		hard.push_back(static_cast<uint32_t>(triCount));
+
+		//Splitting clusters further gives us more freedom to reorder, but every
+		//split costs some cache misses, since we start the new cluster "cold".
+		//We split wherever the new, smaller cluster would still be within our
+		//threshold of the original cluster's ACMR.
+		std::vector<uint32_t> soft;
+		CacheSim cache(vertexCount, cacheSize);
+
+		for (size_t c = 0; c + 1 < hard.size(); ++c)
+		{
+			uint32_t begin = hard[c];
+			uint32_t end = hard[c + 1];
+
+			cache.Reset();
+			size_t misses = 0;
+
+			for (uint32_t t = begin; t < end; ++t)
+			{
+				for (int i = 0; i < 3; ++i)
+					misses += cache.Access(indices[t * 3 + i]) ? 1 : 0;
+			}
+
+			float clusterThreshold = threshold * static_cast<float>(misses) / (end - begin);
+
+			soft.push_back(begin);
+			cache.Reset();
+			misses = 0;
+			size_t size = 0;
+
+			for (uint32_t t = begin; t < end; ++t)
+			{
+				for (int i = 0; i < 3; ++i)
+					misses += cache.Access(indices[t * 3 + i]) ? 1 : 0;
+
+				++size;
+
+				if (t + 1 < end && static_cast<float>(misses) / size <= clusterThreshold)
+				{
+					soft.push_back(t + 1);
+					cache.Reset();
+					misses = 0;
+					size = 0;
+				}
+			}
+		}
+
+		soft.push_back(static_cast<uint32_t>(triCount));
+		size_t clusterCount = soft.size() - 1;
+
+		//Clusters facing away from the middle of the mesh are more likely to be in
+		//front of (and hide) the rest, so they go first. Each cluster's direction
+		//is its area-weighted average normal, and its position its area-weighted centroid.
+		std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+		std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+		std::vector<float> areas(clusterCount, 0.0f);
+
+		glm::vec3 meshCentroid = glm::vec3(0.0f);
+		float meshArea = 0.0f;
+
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			for (uint32_t t = soft[c]; t < soft[c + 1]; ++t)
+			{
+				glm::vec3 a = position(indices[t * 3]);
+				glm::vec3 b = position(indices[t * 3 + 1]);
+				glm::vec3 d = position(indices[t * 3 + 2]);
+
+				//The cross product's length is twice the triangle's area.
+				glm::vec3 normal = glm::cross(b - a, d - a);
+				float area = glm::length(normal);
+
+				centroids[c] += (a + b + d) * (area / 3.0f);
+				normals[c] += normal;
+				areas[c] += area;
+			}
+
+			meshCentroid += centroids[c];
+			meshArea += areas[c];
+
+			if (areas[c] > 0.0f)
+				centroids[c] /= areas[c];
+		}
+
+		if (meshArea > 0.0f)
+			meshCentroid /= meshArea;
+
+		std::vector<float> score(clusterCount);
+
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			float length = glm::length(normals[c]);
+			score[c] = (length > 0.0f) ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return score[a] > score[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+
+		for (uint32_t c : order)
+			result.insert(result.end(), indices.begin() + soft[c] * 3, indices.begin() + soft[c + 1] * 3);
+
+		indices.swap(result);
+	}
+
+	std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, UNUSED);
+		uint32_t next = 0;
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == UNUSED)
+				remap[index] = next++;
+
+			index = remap[index];
+		}
+
+		return remap;
+	}
+
+	Report OptimizeMesh(std::vector<glm::vec3>& verts, std::vector<glm::vec3>& normals,
+						std::vector<glm::vec2>& uvs, std::vector<uint32_t>& indices,
+						size_t cacheSize)
+	{
+		Report report;
+		report.vertsBefore = verts.size();
+		report.before = AnalyzeVertexCache(indices, verts.size(), cacheSize);
+
+		OptimizeOverdraw(indices, verts.data(), sizeof(glm::vec3), verts.size(), cacheSize);
+
+		std::vector<uint32_t> remap = OptimizeVertexFetch(indices, verts.size());
+
+		if (normals.size() == verts.size())
+			RemapVertices(normals, remap);
+
+		if (uvs.size() == verts.size())
+			RemapVertices(uvs, remap);
+
+		RemapVertices(verts, remap);
+
+		report.vertsAfter = verts.size();
+		report.after = AnalyzeVertexCache(indices, verts.size(), cacheSize);
+
+		return report;
+	}
+}
@@ -0,0 +1,516 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+OBJLoader.cpp
+Utility functions for loading models in the Wavefront OBJ format.
+*/
+
+#include "NOU/OBJLoader.h"
+#include "NOU/JobSystem.h"
+#include "NOU/MappedFile.h"
+#include "NOU/MeshCache.h"
+#include "NOU/MeshOptimizer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace nou::OBJ
+{
+	namespace
+	{
+		//Position, UV, and normal - the order they're written in a face corner.
+		enum Component
+		{
+			POS = 0,
+			UV = 1,
+			NORMAL = 2
+		};
+
+		constexpr uint32_t UNUSED = 0xFFFFFFFF;
+
+		//Everything parsed from one piece of the file.
+		//Corner indices are stored three at a time (position, UV, normal),
+		//already made 0-based, with -1 for an attribute that wasn't given.
+		struct Chunk
+		{
+			const char* begin;
+			const char* end;
+
+			std::vector<glm::vec3> verts;
+			std::vector<glm::vec3> normals;
+			std::vector<glm::vec2> uvs;
+			std::vector<int32_t> corners;
+
+			//Negative indices count back from the last attribute read, so we can't
+			//tell what they point at until we know how many attributes came before
+			//this chunk. These are the spots in corners that need fixing up.
+			std::vector<uint32_t> relative;
+
+			//Where parsing failed, if it did.
+			const char* error = nullptr;
+			const char* errorMsg = nullptr;
+		};
+
+		inline bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		inline const char* SkipSpace(const char* p, const char* end)
+		{
+			while (p < end && IsSpace(*p))
+				++p;
+
+			return p;
+		}
+
+		//Reads a float, returning a pointer just past it (or nullptr on failure).
+		inline const char* ParseFloat(const char* p, const char* end, float& value)
+		{
+			p = SkipSpace(p, end);
+
+			//from_chars doesn't accept a leading plus sign, but some exporters write one.
+			if (p < end && *p == '+')
+				++p;
+
+			auto result = std::from_chars(p, end, value);
+
+			return (result.ec == std::errc()) ? result.ptr : nullptr;
+		}
+
+		//Reads one face corner (v, v/vt, v//vn, or v/vt/vn) into raw.
+		//Anything missing is left as 0 (which OBJ never uses as an index).
+		inline const char* ParseCorner(const char* p, const char* end, int32_t raw[3])
+		{
+			raw[POS] = raw[UV] = raw[NORMAL] = 0;
+
+			for (int c = 0; c < 3; ++c)
+			{
+				if (c > 0)
+				{
+					if (p < end && *p == '/')
+						++p;
+					else
+						break;
+				}
+
+				if (p < end && *p != '/' && !IsSpace(*p))
+				{
+					auto result = std::from_chars(p, end, raw[c]);
+
+					if (result.ec != std::errc())
+						return nullptr;
+
+					p = result.ptr;
+				}
+			}
+
+			//Whatever's next had better be the start of the next corner.
+			return (p == end || IsSpace(*p)) ? p : nullptr;
+		}
+
+		void ParseFace(const char* p, const char* end, Chunk& chunk,
+					   std::vector<int32_t>& face, std::vector<uint8_t>& faceRelative)
+		{
+			face.clear();
+			faceRelative.clear();
+
+			const size_t counts[3] = { chunk.verts.size(), chunk.uvs.size(), chunk.normals.size() };
+
+			while (true)
+			{
+				p = SkipSpace(p, end);
+
+				if (p == end)
+					break;
+
+				int32_t raw[3];
+				const char* next = ParseCorner(p, end, raw);
+
+				if (next == nullptr || raw[POS] == 0)
+				{
+					chunk.error = p;
+					chunk.errorMsg = "Malformed face";
+					return;
+				}
+
+				for (int c = 0; c < 3; ++c)
+				{
+					//OBJ counts from 1 - and from -1 backwards, relative to the last attribute read.
+					if (raw[c] > 0)
+						face.push_back(raw[c] - 1);
+					else if (raw[c] < 0)
+						face.push_back(static_cast<int32_t>(counts[c]) + raw[c]);
+					else
+						face.push_back(-1);
+
+					faceRelative.push_back(raw[c] < 0);
+				}
+
+				p = next;
+			}
+
+			//Anything bigger than a triangle gets split into a fan around the first corner.
+			//(This only works for convex polygons - triangulate in Blender if you can.)
+			size_t numCorners = face.size() / 3;
+
+			for (size_t k = 2; k < numCorners; ++k)
+			{
+				size_t tri[3] = { 0, k - 1, k };
+
+				for (size_t corner : tri)
+				{
+					for (size_t c = 0; c < 3; ++c)
+					{
+						if (faceRelative[corner * 3 + c])
+							chunk.relative.push_back(static_cast<uint32_t>(chunk.corners.size()));
+
+						chunk.corners.push_back(face[corner * 3 + c]);
+					}
+				}
+			}
+		}
+
+		void ParseChunk(Chunk& chunk)
+		{
+			const char* p = chunk.begin;
+			const char* end = chunk.end;
+
+			//Scratch space for the face we're working on, reused for every face.
+			std::vector<int32_t> face;
+			std::vector<uint8_t> faceRelative;
+
+			while (p < end)
+			{
+				p = SkipSpace(p, end);
+
+				const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+
+				if (lineEnd == nullptr)
+					lineEnd = end;
+
+				size_t len = lineEnd - p;
+
+				if (len >= 2 && p[0] == 'v' && IsSpace(p[1]))
+				{
+					glm::vec3 v;
+					const char* q = p + 1;
+
+					if ((q = ParseFloat(q, lineEnd, v.x)) == nullptr ||
+						(q = ParseFloat(q, lineEnd, v.y)) == nullptr ||
+						(q = ParseFloat(q, lineEnd, v.z)) == nullptr)
+					{
+						chunk.error = p;
+						chunk.errorMsg = "Malformed vertex position";
+						return;
+					}
+
+					chunk.verts.push_back(v);
+				}
+				else if (len >= 3 && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+				{
+					glm::vec3 n;
+					const char* q = p + 2;
+
+					if ((q = ParseFloat(q, lineEnd, n.x)) == nullptr ||
+						(q = ParseFloat(q, lineEnd, n.y)) == nullptr ||
+						(q = ParseFloat(q, lineEnd, n.z)) == nullptr)
+					{
+						chunk.error = p;
+						chunk.errorMsg = "Malformed vertex normal";
+						return;
+					}
+
+					chunk.normals.push_back(n);
+				}
+				else if (len >= 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+				{
+					//The second coordinate is optional (as is a third, which we ignore).
+					glm::vec2 uv = glm::vec2(0.0f);
+					const char* q = ParseFloat(p + 2, lineEnd, uv.x);
+
+					if (q == nullptr)
+					{
+						chunk.error = p;
+						chunk.errorMsg = "Malformed texture coordinate";
+						return;
+					}
+
+					q = SkipSpace(q, lineEnd);
+
+					if (q < lineEnd && ParseFloat(q, lineEnd, uv.y) == nullptr)
+					{
+						chunk.error = p;
+						chunk.errorMsg = "Malformed texture coordinate";
+						return;
+					}
+
+					chunk.uvs.push_back(uv);
+				}
+				else if (len >= 2 && p[0] == 'f' && IsSpace(p[1]))
+				{
+					ParseFace(p + 1, lineEnd, chunk, face, faceRelative);
+
+					if (chunk.error != nullptr)
+						return;
+				}
+
+				//Anything else (comments, groups, materials...) is skipped.
+				p = (lineEnd < end) ? lineEnd + 1 : end;
+			}
+		}
+
+		//Formats an error message for a chunk, with the line it happened on.
+		//Counting lines as we go would slow down every file for the sake of
+		//the broken ones, so we only work it out now.
+		std::string DescribeError(const char* text, const Chunk& chunk)
+		{
+			size_t line = std::count(text, chunk.error, '\n') + 1;
+			return std::string(chunk.errorMsg) + " on line " + std::to_string(line) + ".";
+		}
+	}
+
+	void LoadMesh(const std::string& filename, Mesh& mesh, bool optimize)
+	{
+		uint32_t cacheOptions = (optimize) ? 1 : 0;
+
+		if (MeshCache::Load(filename, cacheOptions, mesh))
+		{
+			printf("Loaded mesh from %s (cached).\n", filename.c_str());
+			return;
+		}
+
+		Geometry geom;
+		std::string err;
+
+		if (!ParseFile(filename, geom, err))
+		{
+			printf("Error loading mesh from %s: %s\n", filename.c_str(), err.c_str());
+			return;
+		}
+
+		MeshOptimizer::Report report;
+
+		if (optimize)
+			report = MeshOptimizer::OptimizeMesh(geom.verts, geom.normals, geom.uvs, geom.indices);
+
+		mesh.SetVerts(geom.verts);
+		mesh.SetNormals(geom.normals);
+		mesh.SetUVs(geom.uvs);
+		mesh.SetIndices(geom.indices);
+
+		printf("Loaded mesh from %s.\n", filename.c_str());
+
+		MeshCache::Save(filename, cacheOptions, mesh);
+
+		if (optimize)
+			printf("Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f.\n", filename.c_str(),
+				   report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+	}
+
+	bool ReadMesh(const std::string& filename, MeshCache::Staged& staged, bool optimize, std::string& err)
+	{
+		uint32_t cacheOptions = (optimize) ? 1 : 0;
+
+		if (MeshCache::Read(filename, cacheOptions, staged))
+			return true;
+
+		Geometry geom;
+
+		if (!ParseFile(filename, geom, err))
+			return false;
+
+		if (optimize)
+			MeshOptimizer::OptimizeMesh(geom.verts, geom.normals, geom.uvs, geom.indices);
+
+		staged.verts = std::move(geom.verts);
+		staged.normals = std::move(geom.normals);
+		staged.uvs = std::move(geom.uvs);
+		staged.indices = std::move(geom.indices);
+
+		MeshCache::StageGeometry(staged);
+		MeshCache::Save(filename, cacheOptions, staged.data);
+
+		return true;
+	}
+
+	bool ParseFile(const std::string& filename, Geometry& geom, std::string& err)
+	{
+		MappedFile file(filename);
+
+		if (!file.IsOpen())
+		{
+			err = "Could not open file!";
+			return false;
+		}
+
+		return Parse(file.Data(), file.Size(), geom, err);
+	}
+
+	bool Parse(const char* text, size_t len, Geometry& geom, std::string& err)
+	{
+		geom = Geometry();
+
+		if (len == 0)
+			return true;
+
+		const char* end = text + len;
+
+		//A few chunks per thread lets the JobSystem even things out if some
+		//chunks turn out to be slower (e.g., more faces and fewer vertices).
+		size_t threads = JobSystem::GetWorkerCount() + 1;
+		size_t numChunks = std::min(threads * 4, std::max<size_t>(1, len / MIN_CHUNK_SIZE));
+
+		if (threads == 1)
+			numChunks = 1;
+
+		//Split at the end of whichever line each even split point lands in,
+		//so that no line is cut in two.
+		std::vector<Chunk> chunks(numChunks);
+		const char* chunkBegin = text;
+
+		for (size_t i = 0; i < numChunks; ++i)
+		{
+			const char* chunkEnd = end;
+
+			if (i + 1 < numChunks)
+			{
+				chunkEnd = std::max(chunkBegin, text + len / numChunks * (i + 1));
+				chunkEnd = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+				chunkEnd = (chunkEnd == nullptr) ? end : chunkEnd + 1;
+			}
+
+			chunks[i].begin = chunkBegin;
+			chunks[i].end = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+
+		JobSystem::ParallelFor(0, numChunks, [&chunks](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; ++i)
+				ParseChunk(chunks[i]);
+		}, 1);
+
+		//Stitch the chunks' attributes together, and point relative
+		//indices at the right place now that we know what came before.
+		std::vector<glm::vec3> verts, normals;
+		std::vector<glm::vec2> uvs;
+		size_t numCorners = 0;
+
+		for (Chunk& chunk : chunks)
+		{
+			if (chunk.error != nullptr)
+			{
+				err = DescribeError(text, chunk);
+				return false;
+			}
+
+			const int32_t offsets[3] = { static_cast<int32_t>(verts.size()),
+										 static_cast<int32_t>(uvs.size()),
+										 static_cast<int32_t>(normals.size()) };
+
+			for (uint32_t i : chunk.relative)
+			{
+				chunk.corners[i] += offsets[i % 3];
+
+				if (chunk.corners[i] < 0)
+				{
+					err = "Face refers to an attribute before the start of the file.";
+					return false;
+				}
+			}
+
+			verts.insert(verts.end(), chunk.verts.begin(), chunk.verts.end());
+			normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+			uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+			numCorners += chunk.corners.size() / 3;
+
+			//We've got our own copies now.
+			chunk.verts = std::vector<glm::vec3>();
+			chunk.normals = std::vector<glm::vec3>();
+			chunk.uvs = std::vector<glm::vec2>();
+		}
+
+		//Weld corners into vertices. Rather than hashing every corner, we keep a
+		//short list of the vertices created for each position - a position is
+		//usually shared by only a handful of (UV, normal) combinations, so
+		//finding a match is a couple of comparisons, and the table is sized
+		//exactly up front.
+		std::vector<uint32_t> firstVertex(verts.size(), UNUSED);
+		std::vector<uint32_t> nextVertex;
+		std::vector<int32_t> vertAttribs;
+
+		nextVertex.reserve(verts.size());
+		vertAttribs.reserve(verts.size() * 3);
+		geom.indices.reserve(numCorners);
+
+		bool anyUVs = false, anyNormals = false;
+
+		for (const Chunk& chunk : chunks)
+		{
+			for (size_t i = 0; i < chunk.corners.size(); i += 3)
+			{
+				int32_t pos = chunk.corners[i + POS];
+				int32_t uv = chunk.corners[i + UV];
+				int32_t normal = chunk.corners[i + NORMAL];
+
+				if (pos < 0 || pos >= static_cast<int32_t>(verts.size()) ||
+					uv >= static_cast<int32_t>(uvs.size()) ||
+					normal >= static_cast<int32_t>(normals.size()))
+				{
+					err = "Face refers to an attribute that doesn't exist.";
+					geom = Geometry();
+					return false;
+				}
+
+				uint32_t vertex = firstVertex[pos];
+
+				while (vertex != UNUSED && (vertAttribs[vertex * 3 + UV] != uv ||
+											vertAttribs[vertex * 3 + NORMAL] != normal))
+					vertex = nextVertex[vertex];
+
+				if (vertex == UNUSED)
+				{
+					vertex = static_cast<uint32_t>(nextVertex.size());
+
+					nextVertex.push_back(firstVertex[pos]);
+					firstVertex[pos] = vertex;
+					vertAttribs.insert(vertAttribs.end(), { pos, uv, normal });
+
+					anyUVs |= (uv >= 0);
+					anyNormals |= (normal >= 0);
+				}
+
+				geom.indices.push_back(vertex);
+			}
+		}
+
+		size_t numVerts = nextVertex.size();
+
+		geom.verts.resize(numVerts);
+
+		if (anyNormals)
+			geom.normals.resize(numVerts);
+
+		if (anyUVs)
+			geom.uvs.resize(numVerts);
+
+		for (size_t v = 0; v < numVerts; ++v)
+		{
+			const int32_t* attribs = &vertAttribs[v * 3];
+
+			geom.verts[v] = verts[attribs[POS]];
+
+			if (anyNormals)
+				geom.normals[v] = (attribs[NORMAL] >= 0) ? normals[attribs[NORMAL]] : glm::vec3(0.0f, 0.0f, 1.0f);
+
+			if (anyUVs)
+				geom.uvs[v] = (attribs[UV] >= 0) ? uvs[attribs[UV]] : glm::vec2(0.0f);
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,199 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+ObjectBuffer.cpp
+A ring of per-object data (model and normal matrices) that shaders read
+from a storage buffer, instead of having the matrices set as uniforms
+before every draw.
+*/
+
+#include "NOU/ObjectBuffer.h"
+
+#include <cstdio>
+#include <deque>
+
+namespace nou
+{
+	static_assert(sizeof(ObjectData) == 112, "ObjectData has to match ObjectBlock in the shaders.");
+
+	namespace
+	{
+		//A stretch of the ring (in entries) that draws are (or were) reading from.
+		struct Region
+		{
+			size_t begin, end;
+			GLsync fence;
+		};
+
+		size_t s_capacity = 65536;
+		size_t s_stalls = 0;
+
+		GLuint s_ssbo = 0;
+		ObjectData* s_mapped = nullptr;
+		size_t s_size = 0;
+		size_t s_head = 0;
+		//Where the entries written since the last fence start.
+		size_t s_open = 0;
+		bool s_failed = false;
+		//Oldest first - which is also the order their fences will signal in.
+		std::deque<Region> s_regions;
+
+		void Retire(size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				glDeleteSync(s_regions[i].fence);
+
+			s_regions.erase(s_regions.begin(), s_regions.begin() + count);
+		}
+	}
+
+	void ObjectBuffer::SetCapacity(size_t objects)
+	{
+		s_capacity = objects;
+	}
+
+	size_t ObjectBuffer::GetCapacity()
+	{
+		//The ring keeps its size until it's recreated.
+		return (s_mapped != nullptr) ? s_size : s_capacity;
+	}
+
+	size_t ObjectBuffer::GetStallCount()
+	{
+		return s_stalls;
+	}
+
+	bool ObjectBuffer::Allocate(size_t count, GLuint& first, ObjectData*& data)
+	{
+		if (count == 0 || !CreateRing() || count > s_size)
+			return false;
+
+		//Skip to the start if there isn't room left before the end - which means
+		//what we've written since the last fence needs a fence of its own,
+		//since we could come back around to it before the frame's over.
+		if (s_head + count > s_size)
+		{
+			Close();
+			s_head = s_open = 0;
+		}
+
+		size_t begin = s_head;
+		size_t end = begin + count;
+
+		//Let go of anything the GPU is already done with, without waiting.
+		size_t done = 0;
+
+		while (done < s_regions.size() &&
+			   glClientWaitSync(s_regions[done].fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+			++done;
+
+		Retire(done);
+
+		//Find the newest region we'd be writing over. Fences signal in order,
+		//so once that one's done, so is everything before it.
+		size_t overlap = s_regions.size();
+
+		for (size_t i = 0; i < s_regions.size(); ++i)
+		{
+			if (s_regions[i].begin < end && begin < s_regions[i].end)
+				overlap = i;
+		}
+
+		if (overlap < s_regions.size())
+		{
+			++s_stalls;
+
+			//The flush makes sure the fence is actually on its way to the GPU,
+			//otherwise we could be waiting on something that was never sent.
+			while (glClientWaitSync(s_regions[overlap].fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+									1000000) == GL_TIMEOUT_EXPIRED)
+			{
+			}
+
+			Retire(overlap + 1);
+		}
+
+		s_head = end;
+
+		first = static_cast<GLuint>(begin);
+		data = s_mapped + begin;
+
+		return true;
+	}
+
+	void ObjectBuffer::BeginFrame()
+	{
+		Close();
+	}
+
+	void ObjectBuffer::Close()
+	{
+		if (s_head == s_open)
+			return;
+
+		s_regions.push_back({ s_open, s_head, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+		s_open = s_head;
+	}
+
+	bool ObjectBuffer::CreateRing()
+	{
+		if (s_mapped != nullptr)
+			return true;
+
+		//No point trying again every draw.
+		if (s_failed)
+			return false;
+
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLsizeiptr bytes = static_cast<GLsizeiptr>(s_capacity * sizeof(ObjectData));
+
+		if (glBufferStorage != nullptr && s_capacity > 0)
+		{
+			glGenBuffers(1, &s_ssbo);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_ssbo);
+			glBufferStorage(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, flags);
+			s_mapped = static_cast<ObjectData*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bytes, flags));
+		}
+
+		if (s_mapped == nullptr)
+		{
+			printf("ObjectBuffer: couldn't create a persistently mapped buffer (needs OpenGL 4.4). "
+				   "Objects whose shaders read from the ObjectBuffer won't be drawn.\n");
+
+			if (s_ssbo != 0)
+				glDeleteBuffers(1, &s_ssbo);
+
+			s_ssbo = 0;
+			s_failed = true;
+			return false;
+		}
+
+		//Nothing else in NOU uses this binding point, so this only needs doing once.
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING, s_ssbo);
+
+		s_size = s_capacity;
+		s_head = s_open = 0;
+
+		return true;
+	}
+
+	void ObjectBuffer::Shutdown()
+	{
+		Retire(s_regions.size());
+
+		if (s_ssbo != 0)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_ssbo);
+			glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			glDeleteBuffers(1, &s_ssbo);
+		}
+
+		s_ssbo = 0;
+		s_mapped = nullptr;
+		s_size = 0;
+		s_head = s_open = 0;
+		s_failed = false;
+	}
+}
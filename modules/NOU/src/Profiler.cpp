@@ -0,0 +1,76 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Profiler.cpp
+A small ImGui overlay showing how the frame (and the framework's
+caches and streaming) is doing.
+*/
+
+#include "NOU/Profiler.h"
+#include "NOU/App.h"
+#include "NOU/AssetManager.h"
+#include "NOU/ObjectBuffer.h"
+#include "NOU/TextureCache.h"
+#include "NOU/TextureUploader.h"
+
+#include "imgui.h"
+
+namespace nou
+{
+	namespace
+	{
+		//Smoothed, so the numbers are actually readable.
+		float s_frameTime = 0.0f;
+
+		float ToMB(size_t bytes)
+		{
+			return static_cast<float>(bytes) / (1024.0f * 1024.0f);
+		}
+	}
+
+	void Profiler::DrawOverlay()
+	{
+		s_frameTime = (s_frameTime == 0.0f) ? App::GetDeltaTime()
+											: s_frameTime * 0.95f + App::GetDeltaTime() * 0.05f;
+
+		ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+								 ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing |
+								 ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove;
+
+		//(With viewports enabled, positions are on the desktop rather than in our window.)
+		const ImGuiViewport* viewport = ImGui::GetMainViewport();
+		ImGui::SetNextWindowPos(ImVec2(viewport->Pos.x + 10.0f, viewport->Pos.y + 10.0f), ImGuiCond_Always);
+		ImGui::SetNextWindowViewport(viewport->ID);
+		ImGui::SetNextWindowBgAlpha(0.35f);
+
+		if (ImGui::Begin("Profiler", nullptr, flags))
+		{
+			ImGui::Text("%.2f ms (%.0f FPS)", s_frameTime * 1000.0f,
+						(s_frameTime > 0.0f) ? 1.0f / s_frameTime : 0.0f);
+
+			ImGui::Separator();
+
+			TextureCache::Stats cache = TextureCache::GetStats();
+			size_t lookups = cache.hits + cache.misses;
+
+			ImGui::Text("Texture cache");
+			ImGui::Text("  %zu hits, %zu misses (%.0f%% hit rate)", cache.hits, cache.misses,
+						(lookups > 0) ? 100.0f * cache.hits / lookups : 0.0f);
+			ImGui::Text("  %zu textures, %zu unreferenced, %zu evicted",
+						cache.textureCount, cache.unreferencedCount, cache.evictions);
+			ImGui::Text("  %.1f / %.1f MB resident", ToMB(cache.residentBytes), ToMB(cache.budgetBytes));
+
+			ImGui::Separator();
+
+			ImGui::Text("Streaming");
+			ImGui::Text("  %zu assets loading", AssetManager::GetPendingCount());
+			ImGui::Text("  %.1f / %.1f MB uploaded this frame",
+						ToMB(TextureUploader::GetBytesThisFrame()), ToMB(TextureUploader::GetFrameBudget()));
+			ImGui::Text("  %zu upload stalls", TextureUploader::GetStallCount());
+			ImGui::Text("  %zu object buffer stalls", ObjectBuffer::GetStallCount());
+		}
+
+		ImGui::End();
+	}
+}
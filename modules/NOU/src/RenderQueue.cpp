@@ -0,0 +1,319 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+RenderQueue.cpp
+Collects draw calls for a frame, sorts them, and submits them with as
+few OpenGL state changes as possible.
+*/
+
+#include "NOU/RenderQueue.h"
+#include "NOU/CCamera.h"
+#include "NOU/FrameUniforms.h"
+#include "NOU/ObjectBuffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+namespace nou
+{
+	//Turns a (non-negative) view depth into 16 bits that sort the same way.
+	//For positive floats, the raw bits already sort in the same order as the
+	//values themselves - so we just keep the top half (sign, exponent, and the
+	//first 7 bits of the mantissa), which is plenty for ordering draws.
+	static uint16_t QuantizeDepth(float depth)
+	{
+		if (!(depth > 0.0f))
+			depth = 0.0f;
+
+		uint32_t bits;
+		std::memcpy(&bits, &depth, sizeof(bits));
+
+		return static_cast<uint16_t>(bits >> 16);
+	}
+
+	RenderQueue::RenderQueue()
+	{
+		m_minInstances = 2;
+	}
+
+	void RenderQueue::SetMinInstances(size_t minInstances)
+	{
+		m_minInstances = minInstances;
+	}
+
+	void RenderQueue::Begin(CCamera& camera)
+	{
+		m_view = camera.GetView();
+		m_viewProj = camera.GetVP();
+
+		FrameUniforms::Update(camera);
+
+		m_items.clear();
+		m_keys.clear();
+	}
+
+	void RenderQueue::Submit(Material& mat, VertexArray& vao, uint16_t meshID,
+							 const glm::mat4& model, const glm::mat3& normal,
+							 Pass pass)
+	{
+		//Our camera looks down -Z, so depth is the negated view-space Z
+		//of the object's origin.
+		float depth = -(m_view * model[3]).z;
+		uint64_t depthBits = QuantizeDepth(depth);
+
+		uint64_t passBits = static_cast<uint64_t>(pass) & 0xF;
+		uint64_t programBits = mat.GetProgram().GetSortID() & 0xFFF;
+		uint64_t materialBits = mat.GetSortID();
+		uint64_t meshBits = meshID;
+
+		uint64_t key;
+
+		if (pass == Pass::BLENDED)
+		{
+			//Back-to-front matters more than state here, or things behind
+			//a transparent object won't show through it.
+			key = (passBits << 60) | ((~depthBits & 0xFFFF) << 44) |
+				  (programBits << 32) | (materialBits << 16) | meshBits;
+		}
+		else
+		{
+			//Within the same state, front-to-back lets the depth test
+			//throw away hidden fragments early.
+			key = (passBits << 60) | (programBits << 48) |
+				  (materialBits << 32) | (meshBits << 16) | depthBits;
+		}
+
+		m_keys.push_back({ key, static_cast<uint32_t>(m_items.size()) });
+		m_items.push_back({ &mat, &vao, model, normal });
+	}
+
+	void RenderQueue::Flush()
+	{
+		Sort();
+		BuildBatches();
+
+		m_stats = Stats();
+		m_stats.objects = m_keys.size();
+
+		const ShaderProgram* program = nullptr;
+		const Material* mat = nullptr;
+		const VertexArray* vao = nullptr;
+
+		for (const Batch& batch : m_batches)
+		{
+			DrawItem& first = m_items[m_keys[batch.first].item];
+
+			const ShaderProgram* batchProgram = &first.mat->GetProgram();
+
+			if (batchProgram != program)
+			{
+				first.mat->Bind();
+
+				if (!batchProgram->UsesFrameUniforms())
+					batchProgram->SetUniform("viewproj"_u, m_viewProj);
+
+				program = batchProgram;
+				++m_stats.programBinds;
+
+				//Uniforms belong to a program, so the new program
+				//hasn't seen any material's values yet.
+				mat = nullptr;
+			}
+
+			if (first.mat != mat)
+			{
+				first.mat->Apply();
+
+				mat = first.mat;
+				++m_stats.materialBinds;
+			}
+
+			if (first.vao != vao)
+			{
+				first.vao->Bind();
+
+				vao = first.vao;
+				++m_stats.meshBinds;
+			}
+
+			if (batch.mode == BatchMode::OBJECT_BUFFER)
+				DrawObjects(batch);
+			else
+				DrawSingles(batch.first, batch.first + batch.count);
+		}
+
+		//The naive approach binds everything once per object.
+		m_stats.programBindsAvoided = m_stats.objects - m_stats.programBinds;
+		m_stats.materialBindsAvoided = m_stats.objects - m_stats.materialBinds;
+		m_stats.meshBindsAvoided = m_stats.objects - m_stats.meshBinds;
+
+		m_items.clear();
+		m_keys.clear();
+	}
+
+	void RenderQueue::BuildBatches()
+	{
+		m_batches.clear();
+
+		size_t count = m_keys.size();
+		size_t first = 0;
+
+		while (first < count)
+		{
+			const DrawItem& item = m_items[m_keys[first].item];
+
+			//Find the end of the run of draws sharing this mesh and material.
+			//(Draws in different passes never share a run, since the key puts
+			//the pass first - and blended draws of the same thing that happen
+			//to be next to each other in depth order can safely be merged.)
+			size_t end = first + 1;
+
+			while (end < count && m_items[m_keys[end].item].mat == item.mat &&
+				   m_items[m_keys[end].item].vao == item.vao)
+				++end;
+
+			size_t runLength = end - first;
+			bool instancing = m_minInstances > 0 && runLength >= m_minInstances;
+
+			if (item.mat->GetProgram().UsesObjectBuffer())
+				m_batches.push_back({ first, runLength, BatchMode::OBJECT_BUFFER, instancing });
+			else
+				m_batches.push_back({ first, runLength, BatchMode::SINGLE, false });
+
+			first = end;
+		}
+	}
+
+	void RenderQueue::DrawObjects(const Batch& batch)
+	{
+		VertexArray* vao = m_items[m_keys[batch.first].item].vao;
+
+		size_t first = batch.first;
+		size_t end = batch.first + batch.count;
+
+		while (first < end)
+		{
+			//Entries are written just before the draws that read them, rather than
+			//all at once up front. If the ring wraps, what we're about to write over is
+			//only fenced off properly once the draws using it have actually been issued.
+			//(A run longer than the whole ring gets split up.)
+			size_t count = std::min(end - first, ObjectBuffer::GetCapacity());
+
+			GLuint base;
+			ObjectData* data;
+
+			//The program has no uniforms to fall back on, so if there's nowhere to put
+			//the matrices, the objects can't be drawn. (ObjectBuffer already said why.)
+			if (!ObjectBuffer::Allocate(count, base, data))
+				return;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const DrawItem& object = m_items[m_keys[first + i].item];
+				data[i].Set(object.model, object.normal);
+			}
+
+			//The shader finds each object's matrices from the base instance.
+			if (batch.instanced)
+			{
+				vao->DrawInstanced(static_cast<GLsizei>(count), base, false);
+				++m_stats.draws;
+
+				if (count > 1)
+				{
+					++m_stats.instancedDraws;
+					m_stats.instances += count;
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					vao->DrawInstanced(1, base + static_cast<GLuint>(i), false);
+					++m_stats.draws;
+				}
+			}
+
+			first += count;
+		}
+	}
+
+	void RenderQueue::DrawSingles(size_t first, size_t end)
+	{
+		const ShaderProgram& program = m_items[m_keys[first].item].mat->GetProgram();
+
+		for (size_t i = first; i < end; ++i)
+		{
+			DrawItem& item = m_items[m_keys[i].item];
+
+			//We are assuming the names used by uniform shader variables as a convention here.
+			program.SetUniform("model"_u, item.model);
+			program.SetUniform("normal"_u, item.normal);
+
+			item.vao->Draw(false);
+			++m_stats.draws;
+		}
+	}
+
+	const RenderQueue::Stats& RenderQueue::GetStats() const
+	{
+		return m_stats;
+	}
+
+	size_t RenderQueue::Size() const
+	{
+		return m_items.size();
+	}
+
+	//Least-significant-digit radix sort, one byte at a time.
+	//Unlike a comparison sort, this is linear in the number of draws - and
+	//since most of our keys share their upper bytes (there are only so many
+	//programs and materials), we can skip any pass where every key has the
+	//same byte, which is usually most of them.
+	void RenderQueue::Sort()
+	{
+		size_t count = m_keys.size();
+
+		if (count < 2)
+			return;
+
+		m_sortBuffer.resize(count);
+
+		SortEntry* src = m_keys.data();
+		SortEntry* dst = m_sortBuffer.data();
+
+		for (int shift = 0; shift < 64; shift += 8)
+		{
+			size_t histogram[256] = {};
+
+			for (size_t i = 0; i < count; ++i)
+				++histogram[(src[i].key >> shift) & 0xFF];
+
+			//Everything landed in one bucket, so this pass wouldn't change anything.
+			if (histogram[(src[0].key >> shift) & 0xFF] == count)
+				continue;
+
+			//Turn the counts into starting offsets for each bucket.
+			size_t offset = 0;
+
+			for (size_t& bucket : histogram)
+			{
+				size_t bucketCount = bucket;
+				bucket = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+			std::swap(src, dst);
+		}
+
+		//If we finished on an odd number of passes, the result is in our scratch buffer.
+		if (src != m_keys.data())
+			m_keys.swap(m_sortBuffer);
+	}
+}
@@ -10,12 +10,36 @@ Utility classes for managing OpenGL shaders and shader programs.
 
 #include "GLM/glm.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
 namespace nou
 {
+	namespace
+	{
+		bool IsSamplerType(GLenum type)
+		{
+			switch (type)
+			{
+			case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+			case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_CUBE_MAP_ARRAY:
+			case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW: case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+			case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+			case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_RECT: case GL_SAMPLER_2D_RECT_SHADOW:
+			case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE: case GL_INT_SAMPLER_2D_ARRAY:
+			case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D:
+			case GL_UNSIGNED_INT_SAMPLER_CUBE: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+				return true;
+			default:
+				return false;
+			}
+		}
+	}
+
 	const ShaderProgram* ShaderProgram::m_current = nullptr;
+	uint16_t ShaderProgram::m_nextSortID = 0;
 
 	//This loads in the file specifed as an array of GL characters.
 	//This function allocates memory - it is the responsibility of the caller
@@ -132,6 +156,7 @@ namespace nou
 	{
 		//Create a new shader program object.
 		m_id = glCreateProgram();
+		m_sortID = m_nextSortID++;
 
 		//Attach our shadders to the new program.
 		for (auto* shader : shaders)
@@ -157,6 +182,13 @@ namespace nou
 			PrintGLInfoLog("Shader program linking failed", GLInfoLogType::PROGRAM, m_id, buflen);
 		}
 
+		//Find out what uniforms the program has, and which of our shared blocks it wants.
+		if (result)
+			Reflect();
+
+		m_usesFrameUniforms = FindBlock("FrameBlock"_u) != nullptr;
+		m_usesObjectBuffer = FindBlock("ObjectBlock"_u) != nullptr;
+
 		//Detach shaders from the program (once it is linked, the shaders
 		//no longer need to be attached - this will let OpenGL clean up the 
 		//memory properly when those shaders are later deleted).
@@ -182,50 +214,219 @@ namespace nou
 		return m_current;
 	}
 
+	uint16_t ShaderProgram::GetSortID() const
+	{
+		return m_sortID;
+	}
+
+	bool ShaderProgram::UsesFrameUniforms() const
+	{
+		return m_usesFrameUniforms;
+	}
+
+	bool ShaderProgram::UsesObjectBuffer() const
+	{
+		return m_usesObjectBuffer;
+	}
+
+	const std::vector<ShaderProgram::UniformInfo>& ShaderProgram::GetUniforms() const
+	{
+		return m_uniforms;
+	}
+
+	const std::vector<ShaderProgram::BlockInfo>& ShaderProgram::GetBlocks() const
+	{
+		return m_blocks;
+	}
+
+	const ShaderProgram::UniformInfo* ShaderProgram::FindUniform(UniformID id) const
+	{
+		auto it = m_uniformLookup.find(id.hash);
+		return (it != m_uniformLookup.end()) ? &m_uniforms[it->second] : nullptr;
+	}
+
+	const ShaderProgram::BlockInfo* ShaderProgram::FindBlock(UniformID id) const
+	{
+		auto it = m_blockLookup.find(id.hash);
+		return (it != m_blockLookup.end()) ? &m_blocks[it->second] : nullptr;
+	}
+
+	GLint ShaderProgram::GetUniformLoc(UniformID id) const
+	{
+		const UniformInfo* uniform = FindUniform(id);
+
+		if (uniform != nullptr)
+			return uniform->location;
+
+		auto it = m_extraLocs.find(id.hash);
+		return (it != m_extraLocs.end()) ? it->second : -1;
+	}
+
 	GLint ShaderProgram::GetUniformLoc(const std::string& name) const
 	{
-		return glGetUniformLocation(m_id, name.c_str());
+		UniformID id(name);
+		const UniformInfo* uniform = FindUniform(id);
+
+		if (uniform != nullptr)
+			return uniform->location;
+
+		auto it = m_extraLocs.find(id.hash);
+
+		if (it != m_extraLocs.end())
+			return it->second;
+
+		//Not everything that has a location is in our table under the name you'd
+		//expect (e.g., array elements past the first, like "lights[2].color", and
+		//drivers differ in how they name struct members) - so anything we don't
+		//recognize, we ask GL about, and remember the answer.
+		GLint loc = glGetUniformLocation(m_id, name.c_str());
+		m_extraLocs.emplace(id.hash, loc);
+
+		return loc;
+	}
+
+	void ShaderProgram::Reflect()
+	{
+		GLint maxNameLength = 0;
+		glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+		std::vector<GLchar> name;
+
+		auto getName = [&](GLenum programInterface, GLuint index)
+		{
+			GLsizei length = 0;
+			glGetProgramResourceName(m_id, programInterface, index, static_cast<GLsizei>(name.size()), &length, name.data());
+
+			return std::string(name.data(), length);
+		};
+
+		//Uniforms.
+		GLint count = 0;
+		glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+		name.resize(std::max(maxNameLength, 1));
+
+		const GLenum uniformProps[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX };
+
+		for (GLint i = 0; i < count; ++i)
+		{
+			GLint values[4];
+			glGetProgramResourceiv(m_id, GL_UNIFORM, i, 4, uniformProps, 4, nullptr, values);
+
+			//Block members (and atomic counters) don't have locations of their own.
+			if (values[3] != -1 || values[2] < 0)
+				continue;
+
+			UniformInfo uniform;
+			uniform.name = getName(GL_UNIFORM, i);
+			uniform.type = static_cast<GLenum>(values[0]);
+			uniform.arraySize = values[1];
+			uniform.location = values[2];
+			uniform.unit = -1;
+
+			//GL calls arrays "name[0]", but we'd rather just say "name".
+			const std::string suffix = "[0]";
+
+			if (uniform.name.size() > suffix.size() &&
+				uniform.name.compare(uniform.name.size() - suffix.size(), suffix.size(), suffix) == 0)
+				uniform.name.resize(uniform.name.size() - suffix.size());
+
+			if (IsSamplerType(uniform.type))
+				glGetUniformiv(m_id, uniform.location, &uniform.unit);
+
+			m_uniforms.push_back(std::move(uniform));
+		}
+
+		//Uniform and shader storage blocks.
+		const GLenum blockTypes[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+		const GLenum blockProps[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+
+		for (GLenum blockType : blockTypes)
+		{
+			glGetProgramInterfaceiv(m_id, blockType, GL_MAX_NAME_LENGTH, &maxNameLength);
+			glGetProgramInterfaceiv(m_id, blockType, GL_ACTIVE_RESOURCES, &count);
+			name.resize(std::max(maxNameLength, 1));
+
+			for (GLint i = 0; i < count; ++i)
+			{
+				GLint values[2];
+				glGetProgramResourceiv(m_id, blockType, i, 2, blockProps, 2, nullptr, values);
+
+				BlockInfo block;
+				block.name = getName(blockType, i);
+				block.blockType = blockType;
+				block.binding = values[0];
+				block.size = values[1];
+
+				m_blocks.push_back(std::move(block));
+			}
+		}
+
+		//Now we can build the lookup tables. Two names hashing to the same number
+		//is very unlikely, but if it happens, we want to know about it.
+		auto addToLookup = [](auto& lookup, const auto& items)
+		{
+			for (size_t i = 0; i < items.size(); ++i)
+			{
+				auto inserted = lookup.emplace(UniformID(items[i].name).hash, i);
+
+				if (!inserted.second)
+				{
+					printf("Shader program: \"%s\" and \"%s\" have the same hash - rename one of them.\n",
+						   items[inserted.first->second].name.c_str(), items[i].name.c_str());
+				}
+			}
+		};
+
+		m_extraLocs.clear();
+		addToLookup(m_uniformLookup, m_uniforms);
+		addToLookup(m_blockLookup, m_blocks);
+	}
+
+	template<>
+	void ShaderProgram::SetUniform<int>(GLint loc, const int& value) const
+	{
+		glUniform1i(loc, value);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<int>(const std::string& name, const int& value) const
+	void ShaderProgram::SetUniform<unsigned int>(GLint loc, const unsigned int& value) const
 	{
-		glUniform1i(GetUniformLoc(name), value);
+		glUniform1ui(loc, value);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<float>(const std::string& name, const float& value) const
+	void ShaderProgram::SetUniform<float>(GLint loc, const float& value) const
 	{
-		glUniform1f(GetUniformLoc(name), value);
+		glUniform1f(loc, value);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<glm::mat4>(const std::string& name, const glm::mat4& value) const
+	void ShaderProgram::SetUniform<glm::mat4>(GLint loc, const glm::mat4& value) const
 	{
-		glUniformMatrix4fv(GetUniformLoc(name), 1, GL_FALSE, &value[0][0]);
+		glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<glm::mat3>(const std::string& name, const glm::mat3& value) const
+	void ShaderProgram::SetUniform<glm::mat3>(GLint loc, const glm::mat3& value) const
 	{
-		glUniformMatrix3fv(GetUniformLoc(name), 1, GL_FALSE, &value[0][0]);
+		glUniformMatrix3fv(loc, 1, GL_FALSE, &value[0][0]);
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<glm::vec4>(const std::string& name, const glm::vec4& value) const
+	void ShaderProgram::SetUniform<glm::vec4>(GLint loc, const glm::vec4& value) const
 	{
-		glUniform4fv(GetUniformLoc(name), 1, &(value.x));
+		glUniform4fv(loc, 1, &(value.x));
 	}
 
 	template<>
-	void ShaderProgram::SetUniform<glm::vec3>(const std::string& name, const glm::vec3& value) const
+	void ShaderProgram::SetUniform<glm::vec3>(GLint loc, const glm::vec3& value) const
 	{
-		glUniform3fv(GetUniformLoc(name), 1, &(value.x));
+		glUniform3fv(loc, 1, &(value.x));
 	}
 
 	template<>
-	void ShaderProgram::SetUniformArray<glm::mat4>(const std::string& name, glm::mat4* data, int len) const
+	void ShaderProgram::SetUniformArray<glm::mat4>(GLint loc, glm::mat4* data, int len) const
 	{
-		glUniformMatrix4fv(GetUniformLoc(name), len, GL_FALSE, (GLfloat*)data);
+		glUniformMatrix4fv(loc, len, GL_FALSE, (GLfloat*)data);
 	}
 }
@@ -7,16 +7,31 @@ Simple wrapper for STB image loading into 2D textures.
 */
 
 #include "NOU/Texture.h"
+#include "NOU/MaterialTable.h"
+#include "NOU/TextureUploader.h"
 
 #include "stb_image.h"
 
+#include <cstdio>
+
 namespace nou
 {
-	Texture2D::Texture2D(const std::string& filename, bool useNearest)
+	Texture2D::Texture2D(const std::string& filename, bool useNearest, bool mipmaps)
 	{
-		int channels;
-		m_width = 0;
-		m_height = 0;
+		//KTX files are already laid out the way the GPU wants them.
+		if (KTX::IsKTXFile(filename))
+		{
+			TextureData data;
+			std::string err;
+
+			if (!KTX::Load(filename, data, err))
+				printf("Error loading texture from %s: %s\n", filename.c_str(), err.c_str());
+
+			Create(data, useNearest);
+			return;
+		}
+
+		int width = 0, height = 0, channels;
 
 		//If your textures are all upside down, you'd want to switch this to false.
 		//The TLDR here is that many image file formats specify textures from the top
@@ -27,7 +42,59 @@ namespace nou
 		stbi_set_flip_vertically_on_load(true);
 
 		unsigned char* data = stbi_load(filename.c_str(),
-										&m_width, &m_height, &channels, STBI_rgb_alpha);
+										&width, &height, &channels, STBI_rgb_alpha);
+
+		Create(data, width, height, useNearest, mipmaps);
+
+		//Very important - after we send our data to OpenGL, make sure to free the memory
+		//used by STBI!
+		stbi_image_free(data);
+	}
+
+	Texture2D::Texture2D(const unsigned char* encoded, size_t size, bool useNearest, bool mipmaps)
+	{
+		int width = 0, height = 0, channels;
+
+		//(See above for why we flip.)
+		stbi_set_flip_vertically_on_load(true);
+
+		unsigned char* data = stbi_load_from_memory(encoded, static_cast<int>(size),
+													&width, &height, &channels, STBI_rgb_alpha);
+
+		Create(data, width, height, useNearest, mipmaps);
+
+		stbi_image_free(data);
+	}
+
+	Texture2D::Texture2D(int width, int height, const unsigned char* pixels, bool useNearest, bool mipmaps)
+	{
+		Create(pixels, width, height, useNearest, mipmaps);
+	}
+
+	Texture2D::Texture2D(const TextureData& data, bool useNearest)
+	{
+		Create(data, useNearest);
+	}
+
+	void Texture2D::Create(const unsigned char* pixels, int width, int height, bool useNearest, bool mipmaps)
+	{
+		TextureData data;
+
+		//(If the image didn't load, we still make a texture - just an empty one.)
+		if (pixels != nullptr)
+			Mipmap::Build(pixels, width, height, data, mipmaps);
+
+		Create(data, useNearest);
+	}
+
+	void Texture2D::Create(const TextureData& data, bool useNearest)
+	{
+		m_width = data.width;
+		m_height = data.height;
+		m_format = data.format;
+		m_mipCount = static_cast<int>(data.levels.size());
+		m_size = data.GetSize();
+		m_nearest = useNearest;
 
 		//Generate a new OpenGL texture.
 		glGenTextures(1, &m_id);
@@ -41,27 +108,53 @@ namespace nou
 
 		//Sets up a linear (smooth) filter for interpolating our texture
 		//when displaying it smaller or larger (e.g., on a faraway or close-up object).
+		//With mipmaps, shrunken textures also blend between the two closest mip levels
+		//(which is what "trilinear" filtering means).
 		if (useNearest)
 		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+							(m_mipCount > 1) ? GL_NEAREST_MIPMAP_LINEAR : GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		}
 		else
 		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+							(m_mipCount > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		}
 
-		//Specifies our image data as the source data for the new texture.
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		if (m_mipCount == 0)
+		{
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			return;
+		}
+
+		//Makes room for the texture and all its mip levels, without any data yet...
+		glTexStorage2D(GL_TEXTURE_2D, m_mipCount, GetGLFormat(m_format), m_width, m_height);
 
-		//Very important - after we send our data to OpenGL, make sure to free the memory
-		//used by STBI!
-		stbi_image_free(data);
+		//...which is then streamed in (see TextureUploader.h for why we don't just
+		//hand the data to glTexImage2D).
+		for (int i = 0; i < m_mipCount; ++i)
+		{
+			const TextureData::Level& level = data.levels[i];
+
+			if (IsCompressed(m_format))
+			{
+				TextureUploader::UploadCompressed(GL_TEXTURE_2D, i, level.width, level.height,
+												  GetGLFormat(m_format), data.GetLevelData(i), level.size);
+			}
+			else
+			{
+				TextureUploader::Upload(GL_TEXTURE_2D, i, level.width, level.height, GL_RGBA, GL_UNSIGNED_BYTE,
+										data.GetLevelData(i), level.size);
+			}
+		}
 	}
 
 	Texture2D::~Texture2D()
 	{
+		//Materials might still be using us through the MaterialTable.
+		MaterialTable::ForgetTexture(m_id);
 		glDeleteTextures(1, &m_id);
 	}
 
@@ -75,4 +168,24 @@ namespace nou
 		width = m_width;
 		height = m_height;
 	}
+
+	TextureFormat Texture2D::GetFormat() const
+	{
+		return m_format;
+	}
+
+	int Texture2D::GetMipCount() const
+	{
+		return m_mipCount;
+	}
+
+	size_t Texture2D::GetSize() const
+	{
+		return m_size;
+	}
+
+	bool Texture2D::IsNearest() const
+	{
+		return m_nearest;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TextureCache.cpp
+Makes sure each texture is only loaded (and only takes up VRAM) once,
+however many materials use it.
+*/
+
+#include "NOU/TextureCache.h"
+
+#include <filesystem>
+#include <list>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace nou
+{
+	struct TextureHandle::Entry
+	{
+		std::string key;
+		std::unique_ptr<Texture2D> texture;
+		size_t bytes;
+		size_t refs;
+
+		//Where the entry is in the LRU list, while it's unreferenced.
+		//(A default list iterator can't be compared against, so inLru says
+		//whether lru means anything.)
+		std::list<Entry*>::iterator lru;
+		bool inLru;
+	};
+
+	namespace
+	{
+		std::unordered_map<std::string, std::unique_ptr<TextureHandle::Entry>> s_entries;
+
+		//Unreferenced entries, least recently used first.
+		std::list<TextureHandle::Entry*> s_lru;
+
+		size_t s_budget = size_t(512) << 20;
+		size_t s_resident = 0;
+
+		size_t s_hits = 0;
+		size_t s_misses = 0;
+		size_t s_evictions = 0;
+
+		std::string MakeKey(const std::string& key, bool useNearest, bool mipmaps)
+		{
+			return key + ((useNearest) ? "|nearest" : "|linear") + ((mipmaps) ? "|mips" : "");
+		}
+
+		//The same file can be reached by different relative paths,
+		//so files go by their absolute path instead.
+		std::string AbsolutePath(const std::string& filename)
+		{
+			std::error_code ec;
+			fs::path absolute = fs::absolute(filename, ec);
+
+			return (ec) ? filename : absolute.lexically_normal().generic_string();
+		}
+	}
+
+	TextureHandle::TextureHandle(Entry* entry)
+	{
+		m_entry = entry;
+		TextureCache::AddRef(m_entry);
+	}
+
+	TextureHandle::~TextureHandle()
+	{
+		Reset();
+	}
+
+	TextureHandle::TextureHandle(const TextureHandle& other)
+		: TextureHandle()
+	{
+		*this = other;
+	}
+
+	TextureHandle& TextureHandle::operator=(const TextureHandle& other)
+	{
+		//Add the new reference first, in case both handles point at the same texture
+		//(or are the same handle).
+		Entry* entry = other.m_entry;
+
+		if (entry != nullptr)
+			TextureCache::AddRef(entry);
+
+		Reset();
+		m_entry = entry;
+
+		return *this;
+	}
+
+	TextureHandle::TextureHandle(TextureHandle&& other) noexcept
+	{
+		m_entry = other.m_entry;
+		other.m_entry = nullptr;
+	}
+
+	TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Reset();
+			m_entry = other.m_entry;
+			other.m_entry = nullptr;
+		}
+
+		return *this;
+	}
+
+	const Texture2D* TextureHandle::Get() const
+	{
+		return (m_entry != nullptr) ? m_entry->texture.get() : nullptr;
+	}
+
+	void TextureHandle::Reset()
+	{
+		if (m_entry != nullptr)
+			TextureCache::Release(m_entry);
+
+		m_entry = nullptr;
+	}
+
+	TextureHandle TextureCache::Load(const std::string& filename, bool useNearest, bool mipmaps)
+	{
+		return Get(AbsolutePath(filename), useNearest, mipmaps, [&]()
+		{
+			return std::make_unique<Texture2D>(filename, useNearest, mipmaps);
+		});
+	}
+
+	TextureHandle TextureCache::Get(const std::string& key, bool useNearest, bool mipmaps,
+									const std::function<std::unique_ptr<Texture2D>()>& create)
+	{
+		std::string fullKey = MakeKey(key, useNearest, mipmaps);
+		auto it = s_entries.find(fullKey);
+
+		if (it != s_entries.end())
+		{
+			++s_hits;
+			return TextureHandle(it->second.get());
+		}
+
+		++s_misses;
+
+		auto entry = std::make_unique<TextureHandle::Entry>();
+		entry->key = fullKey;
+		entry->texture = create();
+		entry->bytes = entry->texture->GetSize();
+		entry->refs = 0;
+		entry->inLru = false;
+
+		s_resident += entry->bytes;
+
+		TextureHandle handle(entry.get());
+		s_entries.emplace(std::move(fullKey), std::move(entry));
+
+		//Something new came in, so something old might have to go.
+		Trim();
+
+		return handle;
+	}
+
+	void TextureCache::SetBudget(size_t bytes)
+	{
+		s_budget = bytes;
+		Trim();
+	}
+
+	size_t TextureCache::GetBudget()
+	{
+		return s_budget;
+	}
+
+	void TextureCache::EvictUnused()
+	{
+		size_t budget = s_budget;
+
+		s_budget = 0;
+		Trim();
+		s_budget = budget;
+	}
+
+	TextureCache::Stats TextureCache::GetStats()
+	{
+		Stats stats;
+
+		stats.hits = s_hits;
+		stats.misses = s_misses;
+		stats.evictions = s_evictions;
+		stats.textureCount = s_entries.size();
+		stats.unreferencedCount = s_lru.size();
+		stats.residentBytes = s_resident;
+		stats.budgetBytes = s_budget;
+
+		return stats;
+	}
+
+	void TextureCache::AddRef(TextureHandle::Entry* entry)
+	{
+		//Back in use, so it's safe from eviction.
+		if (entry->refs++ == 0 && entry->inLru)
+		{
+			s_lru.erase(entry->lru);
+			entry->inLru = false;
+		}
+	}
+
+	void TextureCache::Release(TextureHandle::Entry* entry)
+	{
+		if (--entry->refs > 0)
+			return;
+
+		entry->lru = s_lru.insert(s_lru.end(), entry);
+		entry->inLru = true;
+
+		Trim();
+	}
+
+	void TextureCache::Trim()
+	{
+		while (s_resident > s_budget && !s_lru.empty())
+		{
+			TextureHandle::Entry* entry = s_lru.front();
+			s_lru.pop_front();
+			entry->inLru = false;
+
+			s_resident -= entry->bytes;
+			++s_evictions;
+
+			//(Destroys the entry, and with it, the texture.)
+			s_entries.erase(entry->key);
+		}
+	}
+}
@@ -0,0 +1,508 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TextureData.cpp
+Texture data on the CPU side: mip chains, block-compressed formats,
+and reading/writing them in KTX files.
+*/
+
+#include "NOU/TextureData.h"
+#include "NOU/JobSystem.h"
+#include "NOU/MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace nou
+{
+	const unsigned char* TextureData::GetLevelData(size_t level) const
+	{
+		return bytes.data() + levels[level].offset;
+	}
+
+	size_t TextureData::GetSize() const
+	{
+		return bytes.size();
+	}
+
+	bool IsCompressed(TextureFormat format)
+	{
+		return format != TextureFormat::RGBA8;
+	}
+
+	GLenum GetGLFormat(TextureFormat format)
+	{
+		switch (format)
+		{
+			case TextureFormat::BC1:
+				return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			case TextureFormat::BC3:
+				return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			case TextureFormat::BC5:
+				return GL_COMPRESSED_RG_RGTC2;
+			case TextureFormat::BC7:
+				return GL_COMPRESSED_RGBA_BPTC_UNORM;
+			default:
+				return GL_RGBA8;
+		}
+	}
+
+	size_t GetImageSize(TextureFormat format, int width, int height)
+	{
+		if (format == TextureFormat::RGBA8)
+			return static_cast<size_t>(width) * height * 4;
+
+		//Block formats round up to whole 4x4 blocks.
+		size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+
+		return blocks * ((format == TextureFormat::BC1) ? 8 : 16);
+	}
+
+	int GetMipCount(int width, int height)
+	{
+		int count = 1;
+
+		while (width > 1 || height > 1)
+		{
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+			++count;
+		}
+
+		return count;
+	}
+
+	namespace
+	{
+		//The modified Bessel function of the first kind, which the Kaiser window is built on.
+		//The series converges quickly for the small arguments we use.
+		double BesselI0(double x)
+		{
+			double sum = 1.0, term = 1.0;
+
+			for (int k = 1; k < 32; ++k)
+			{
+				term *= (x / (2.0 * k)) * (x / (2.0 * k));
+				sum += term;
+			}
+
+			return sum;
+		}
+
+		//Filter width (in destination texels either side) and sharpness.
+		constexpr double KAISER_RADIUS = 3.0;
+		constexpr double KAISER_ALPHA = 4.0;
+
+		double Kaiser(double x)
+		{
+			double sinc = (x == 0.0) ? 1.0 : std::sin(3.14159265358979 * x) / (3.14159265358979 * x);
+			double t = x / KAISER_RADIUS;
+
+			if (t <= -1.0 || t >= 1.0)
+				return 0.0;
+
+			return sinc * BesselI0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) / BesselI0(KAISER_ALPHA);
+		}
+
+		//Which source texels one destination texel reads from, and how much of each.
+		struct Taps
+		{
+			int first;
+			std::vector<float> weights;
+		};
+
+		//Works out the taps for shrinking srcSize texels down to dstSize (along one axis).
+		//Edges are clamped, so texels past the edge just repeat the last one.
+		std::vector<Taps> BuildKaiserTaps(int srcSize, int dstSize)
+		{
+			std::vector<Taps> taps(dstSize);
+			double scale = static_cast<double>(srcSize) / dstSize;
+
+			for (int d = 0; d < dstSize; ++d)
+			{
+				double centre = (d + 0.5) * scale;
+				int first = static_cast<int>(std::floor(centre - KAISER_RADIUS * scale));
+				int last = static_cast<int>(std::ceil(centre + KAISER_RADIUS * scale));
+
+				taps[d].first = first;
+
+				double total = 0.0;
+				std::vector<double> weights;
+
+				for (int s = first; s <= last; ++s)
+				{
+					double w = Kaiser((s + 0.5 - centre) / scale);
+					weights.push_back(w);
+					total += w;
+				}
+
+				for (double w : weights)
+					taps[d].weights.push_back(static_cast<float>(w / total));
+			}
+
+			return taps;
+		}
+
+		unsigned char ToByte(float v)
+		{
+			return static_cast<unsigned char>(std::clamp(v + 0.5f, 0.0f, 255.0f));
+		}
+
+		void DownsampleBox(const unsigned char* src, int srcWidth, int srcHeight,
+						   unsigned char* dst, int dstWidth, int dstHeight)
+		{
+			JobSystem::ParallelFor(0, dstHeight, [&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; ++y)
+				{
+					//Clamped, for levels that are already 1 texel wide/tall in one direction.
+					int y0 = std::min(static_cast<int>(y) * 2, srcHeight - 1);
+					int y1 = std::min(y0 + 1, srcHeight - 1);
+
+					for (int x = 0; x < dstWidth; ++x)
+					{
+						int x0 = std::min(x * 2, srcWidth - 1);
+						int x1 = std::min(x0 + 1, srcWidth - 1);
+
+						for (int c = 0; c < 4; ++c)
+						{
+							int sum = src[(static_cast<size_t>(y0) * srcWidth + x0) * 4 + c] +
+									  src[(static_cast<size_t>(y0) * srcWidth + x1) * 4 + c] +
+									  src[(static_cast<size_t>(y1) * srcWidth + x0) * 4 + c] +
+									  src[(static_cast<size_t>(y1) * srcWidth + x1) * 4 + c];
+
+							dst[(y * dstWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+						}
+					}
+				}
+			});
+		}
+
+		//Separable, so it's done as a horizontal pass into a float buffer, then a vertical one.
+		void DownsampleKaiser(const unsigned char* src, int srcWidth, int srcHeight,
+							  unsigned char* dst, int dstWidth, int dstHeight)
+		{
+			std::vector<Taps> tapsX = BuildKaiserTaps(srcWidth, dstWidth);
+			std::vector<Taps> tapsY = BuildKaiserTaps(srcHeight, dstHeight);
+
+			std::vector<float> temp(static_cast<size_t>(dstWidth) * srcHeight * 4);
+
+			JobSystem::ParallelFor(0, srcHeight, [&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; ++y)
+				{
+					const unsigned char* row = src + y * srcWidth * 4;
+
+					for (int x = 0; x < dstWidth; ++x)
+					{
+						float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+						const Taps& t = tapsX[x];
+
+						for (size_t i = 0; i < t.weights.size(); ++i)
+						{
+							int sx = std::clamp(t.first + static_cast<int>(i), 0, srcWidth - 1);
+
+							for (int c = 0; c < 4; ++c)
+								sum[c] += t.weights[i] * row[sx * 4 + c];
+						}
+
+						memcpy(&temp[(y * dstWidth + x) * 4], sum, sizeof(sum));
+					}
+				}
+			});
+
+			JobSystem::ParallelFor(0, dstHeight, [&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; ++y)
+				{
+					const Taps& t = tapsY[y];
+
+					for (int x = 0; x < dstWidth; ++x)
+					{
+						float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+						for (size_t i = 0; i < t.weights.size(); ++i)
+						{
+							size_t sy = std::clamp(t.first + static_cast<int>(i), 0, srcHeight - 1);
+
+							for (int c = 0; c < 4; ++c)
+								sum[c] += t.weights[i] * temp[(sy * dstWidth + x) * 4 + c];
+						}
+
+						for (int c = 0; c < 4; ++c)
+							dst[(y * dstWidth + x) * 4 + c] = ToByte(sum[c]);
+					}
+				}
+			});
+		}
+	}
+
+	namespace Mipmap
+	{
+		void Build(const unsigned char* pixels, int width, int height, TextureData& out,
+				   bool mipmaps, MipFilter filter)
+		{
+			out.format = TextureFormat::RGBA8;
+			out.width = width;
+			out.height = height;
+			out.levels.clear();
+
+			int count = (mipmaps) ? GetMipCount(width, height) : 1;
+			size_t total = 0;
+
+			for (int i = 0, w = width, h = height; i < count; ++i)
+			{
+				size_t size = GetImageSize(TextureFormat::RGBA8, w, h);
+				out.levels.push_back({ w, h, total, size });
+				total += size;
+
+				w = std::max(w / 2, 1);
+				h = std::max(h / 2, 1);
+			}
+
+			out.bytes.resize(total);
+
+			if (total == 0)
+				return;
+
+			memcpy(out.bytes.data(), pixels, out.levels[0].size);
+
+			//Each level is made from the one before it, which is both faster and
+			//(for the box filter) exactly what a bigger box would give us anyway.
+			for (size_t i = 1; i < out.levels.size(); ++i)
+			{
+				const TextureData::Level& prev = out.levels[i - 1];
+				const TextureData::Level& level = out.levels[i];
+
+				Downsample(out.bytes.data() + prev.offset, prev.width, prev.height,
+						   out.bytes.data() + level.offset, level.width, level.height, filter);
+			}
+		}
+
+		void Downsample(const unsigned char* src, int srcWidth, int srcHeight,
+						unsigned char* dst, int dstWidth, int dstHeight, MipFilter filter)
+		{
+			if (filter == MipFilter::KAISER)
+				DownsampleKaiser(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+			else
+				DownsampleBox(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+		}
+	}
+
+	namespace KTX
+	{
+		namespace
+		{
+			const unsigned char IDENTIFIER[12] =
+			{
+				0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+			};
+
+			//Written in the file's byte order, so a reader can tell if it needs to swap.
+			constexpr uint32_t ENDIANNESS = 0x04030201;
+
+			struct Header
+			{
+				unsigned char identifier[12];
+				uint32_t endianness;
+				uint32_t glType;
+				uint32_t glTypeSize;
+				uint32_t glFormat;
+				uint32_t glInternalFormat;
+				uint32_t glBaseInternalFormat;
+				uint32_t pixelWidth;
+				uint32_t pixelHeight;
+				uint32_t pixelDepth;
+				uint32_t numberOfArrayElements;
+				uint32_t numberOfFaces;
+				uint32_t numberOfMipmapLevels;
+				uint32_t bytesOfKeyValueData;
+			};
+
+			const TextureFormat FORMATS[] =
+			{
+				TextureFormat::RGBA8, TextureFormat::BC1, TextureFormat::BC3,
+				TextureFormat::BC5, TextureFormat::BC7
+			};
+
+			GLenum GetBaseFormat(TextureFormat format)
+			{
+				switch (format)
+				{
+					case TextureFormat::BC1:
+						return GL_RGB;
+					case TextureFormat::BC5:
+						return GL_RG;
+					default:
+						return GL_RGBA;
+				}
+			}
+		}
+
+		bool Read(const unsigned char* data, size_t size, TextureData& out, std::string& err)
+		{
+			Header header;
+
+			if (size < sizeof(Header))
+			{
+				err = "File is too small.";
+				return false;
+			}
+
+			memcpy(&header, data, sizeof(Header));
+
+			if (memcmp(header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0)
+			{
+				err = "Not a KTX file.";
+				return false;
+			}
+
+			//We only ever write files in our own byte order, so don't bother swapping.
+			if (header.endianness != ENDIANNESS)
+			{
+				err = "File has the wrong byte order.";
+				return false;
+			}
+
+			if (header.pixelDepth > 1 || header.numberOfArrayElements > 0 || header.numberOfFaces != 1 ||
+				header.pixelWidth == 0 || header.pixelHeight == 0)
+			{
+				err = "Only 2D textures are supported.";
+				return false;
+			}
+
+			auto format = std::find_if(std::begin(FORMATS), std::end(FORMATS), [&](TextureFormat f)
+			{
+				return GetGLFormat(f) == header.glInternalFormat;
+			});
+
+			//(Uncompressed data also has to be plain bytes, not, e.g., packed 5:6:5.)
+			if (format == std::end(FORMATS) ||
+				(*format == TextureFormat::RGBA8 && (header.glFormat != GL_RGBA || header.glType != GL_UNSIGNED_BYTE)))
+			{
+				err = "Unsupported texture format.";
+				return false;
+			}
+
+			out.format = *format;
+			out.width = static_cast<int>(header.pixelWidth);
+			out.height = static_cast<int>(header.pixelHeight);
+			out.levels.clear();
+			out.bytes.clear();
+
+			//0 levels means "generate them yourself" - we just use the one we're given.
+			uint32_t levelCount = std::max(header.numberOfMipmapLevels, 1u);
+
+			if (static_cast<int>(levelCount) > GetMipCount(out.width, out.height))
+			{
+				err = "Too many mip levels.";
+				return false;
+			}
+
+			size_t pos = sizeof(Header) + header.bytesOfKeyValueData;
+
+			for (uint32_t i = 0, w = header.pixelWidth, h = header.pixelHeight; i < levelCount; ++i)
+			{
+				uint32_t imageSize;
+
+				if (pos + sizeof(imageSize) > size)
+				{
+					err = "File is truncated.";
+					return false;
+				}
+
+				memcpy(&imageSize, data + pos, sizeof(imageSize));
+				pos += sizeof(imageSize);
+
+				size_t expected = GetImageSize(out.format, w, h);
+
+				if (imageSize != expected || pos + imageSize > size)
+				{
+					err = "Mip level " + std::to_string(i) + " has the wrong size.";
+					return false;
+				}
+
+				out.levels.push_back({ static_cast<int>(w), static_cast<int>(h), out.bytes.size(), imageSize });
+				out.bytes.insert(out.bytes.end(), data + pos, data + pos + imageSize);
+
+				//Each level is padded out to a multiple of 4 bytes.
+				pos += (imageSize + 3) & ~3u;
+
+				w = std::max(w / 2, 1u);
+				h = std::max(h / 2, 1u);
+			}
+
+			return true;
+		}
+
+		bool Load(const std::string& filename, TextureData& out, std::string& err)
+		{
+			MappedFile file;
+
+			if (!file.Open(filename))
+			{
+				err = "Couldn't open file.";
+				return false;
+			}
+
+			return Read(reinterpret_cast<const unsigned char*>(file.Data()), file.Size(), out, err);
+		}
+
+		bool Save(const std::string& filename, const TextureData& data)
+		{
+			std::ofstream file(filename, std::ios::binary);
+
+			if (!file)
+				return false;
+
+			Header header = {};
+			memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+			header.endianness = ENDIANNESS;
+
+			//Compressed formats have no type or format of their own - just an internal format.
+			bool compressed = IsCompressed(data.format);
+
+			header.glType = (compressed) ? 0 : GL_UNSIGNED_BYTE;
+			header.glTypeSize = 1;
+			header.glFormat = (compressed) ? 0 : GL_RGBA;
+			header.glInternalFormat = GetGLFormat(data.format);
+			header.glBaseInternalFormat = GetBaseFormat(data.format);
+			header.pixelWidth = data.width;
+			header.pixelHeight = data.height;
+			header.numberOfFaces = 1;
+			header.numberOfMipmapLevels = static_cast<uint32_t>(data.levels.size());
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+			const char padding[4] = {};
+
+			for (size_t i = 0; i < data.levels.size(); ++i)
+			{
+				uint32_t imageSize = static_cast<uint32_t>(data.levels[i].size);
+
+				file.write(reinterpret_cast<const char*>(&imageSize), sizeof(imageSize));
+				file.write(reinterpret_cast<const char*>(data.GetLevelData(i)), imageSize);
+				file.write(padding, ((imageSize + 3) & ~3u) - imageSize);
+			}
+
+			return static_cast<bool>(file);
+		}
+
+		bool IsKTXFile(const std::string& filename)
+		{
+			std::string ext = fs::path(filename).extension().string();
+			std::transform(ext.begin(), ext.end(), ext.begin(),
+						   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+			return ext == ".ktx";
+		}
+	}
+}
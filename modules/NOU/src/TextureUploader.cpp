@@ -0,0 +1,245 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TextureUploader.cpp
+Streams pixel data to textures through a ring of pixel buffer memory.
+*/
+
+#include "NOU/TextureUploader.h"
+
+#include <cstring>
+#include <deque>
+
+namespace nou
+{
+	namespace
+	{
+		//A stretch of the ring that an upload is (or was) reading from.
+		struct Region
+		{
+			size_t begin, end;
+			GLsync fence;
+		};
+
+		size_t s_ringSize = 32 << 20;
+		size_t s_frameBudget = 16 << 20;
+		size_t s_bytesThisFrame = 0;
+		size_t s_stalls = 0;
+
+		GLuint s_pbo = 0;
+		char* s_mapped = nullptr;
+		size_t s_capacity = 0;
+		size_t s_head = 0;
+		//Oldest first - which is also the order their fences will signal in.
+		std::deque<Region> s_regions;
+
+		//Keeps offsets into the ring aligned for any pixel type.
+		constexpr size_t ALIGNMENT = 16;
+
+		void Retire(size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				glDeleteSync(s_regions[i].fence);
+
+			s_regions.erase(s_regions.begin(), s_regions.begin() + count);
+		}
+	}
+
+	void TextureUploader::SetRingSize(size_t bytes)
+	{
+		s_ringSize = bytes;
+	}
+
+	size_t TextureUploader::GetRingSize()
+	{
+		return s_ringSize;
+	}
+
+	void TextureUploader::SetFrameBudget(size_t bytes)
+	{
+		s_frameBudget = bytes;
+	}
+
+	size_t TextureUploader::GetFrameBudget()
+	{
+		return s_frameBudget;
+	}
+
+	size_t TextureUploader::GetBytesThisFrame()
+	{
+		return s_bytesThisFrame;
+	}
+
+	bool TextureUploader::IsFrameBudgetSpent()
+	{
+		return s_bytesThisFrame >= s_frameBudget;
+	}
+
+	void TextureUploader::BeginFrame()
+	{
+		s_bytesThisFrame = 0;
+	}
+
+	size_t TextureUploader::GetStallCount()
+	{
+		return s_stalls;
+	}
+
+	void TextureUploader::Upload(GLenum target, GLint level, GLsizei width, GLsizei height,
+								 GLenum format, GLenum type, const void* pixels, size_t size)
+	{
+		if (pixels == nullptr)
+			return;
+
+		size_t offset;
+
+		if (!Stage(pixels, size, offset))
+		{
+			glTexSubImage2D(target, level, 0, 0, width, height, format, type, pixels);
+			return;
+		}
+
+		//With a buffer bound to GL_PIXEL_UNPACK_BUFFER, the "pointer" we pass
+		//is really an offset into that buffer.
+		glTexSubImage2D(target, level, 0, 0, width, height, format, type,
+						reinterpret_cast<const void*>(offset));
+
+		Finish(offset, size);
+	}
+
+	void TextureUploader::UploadCompressed(GLenum target, GLint level, GLsizei width, GLsizei height,
+										   GLenum format, const void* data, size_t size)
+	{
+		if (data == nullptr)
+			return;
+
+		size_t offset;
+
+		if (!Stage(data, size, offset))
+		{
+			glCompressedTexSubImage2D(target, level, 0, 0, width, height, format,
+									  static_cast<GLsizei>(size), data);
+			return;
+		}
+
+		glCompressedTexSubImage2D(target, level, 0, 0, width, height, format,
+								  static_cast<GLsizei>(size), reinterpret_cast<const void*>(offset));
+
+		Finish(offset, size);
+	}
+
+	bool TextureUploader::Stage(const void* data, size_t size, size_t& offset)
+	{
+		s_bytesThisFrame += size;
+
+		if (size == 0 || size > s_ringSize || !CreateRing())
+			return false;
+
+		offset = Allocate(size);
+		memcpy(s_mapped + offset, data, size);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_pbo);
+
+		return true;
+	}
+
+	void TextureUploader::Finish(size_t offset, size_t size)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		s_regions.push_back({ offset, offset + size, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+	}
+
+	bool TextureUploader::CreateRing()
+	{
+		if (s_mapped != nullptr)
+			return true;
+
+		//Persistent mapping needs GL 4.4 (or ARB_buffer_storage).
+		if (glBufferStorage == nullptr)
+			return false;
+
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glGenBuffers(1, &s_pbo);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_pbo);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, s_ringSize, nullptr, flags);
+		s_mapped = static_cast<char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, s_ringSize, flags));
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (s_mapped == nullptr)
+		{
+			glDeleteBuffers(1, &s_pbo);
+			s_pbo = 0;
+			return false;
+		}
+
+		s_capacity = s_ringSize;
+		s_head = 0;
+
+		return true;
+	}
+
+	size_t TextureUploader::Allocate(size_t size)
+	{
+		//Skip to the start if there isn't room left before the end.
+		size_t begin = (s_head + size > s_capacity) ? 0 : s_head;
+		size_t end = begin + size;
+
+		//Let go of anything the GPU is already done with, without waiting.
+		size_t done = 0;
+
+		while (done < s_regions.size() &&
+			   glClientWaitSync(s_regions[done].fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+			++done;
+
+		Retire(done);
+
+		//Find the newest upload we'd be writing over. Fences signal in order,
+		//so once that one's done, so is everything before it.
+		size_t overlap = s_regions.size();
+
+		for (size_t i = 0; i < s_regions.size(); ++i)
+		{
+			if (s_regions[i].begin < end && begin < s_regions[i].end)
+				overlap = i;
+		}
+
+		if (overlap < s_regions.size())
+		{
+			++s_stalls;
+
+			//The flush makes sure the fence is actually on its way to the GPU,
+			//otherwise we could be waiting on something that was never sent.
+			while (glClientWaitSync(s_regions[overlap].fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+									1000000) == GL_TIMEOUT_EXPIRED)
+			{
+			}
+
+			Retire(overlap + 1);
+		}
+
+		s_head = (end + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+		return begin;
+	}
+
+	void TextureUploader::Shutdown()
+	{
+		Retire(s_regions.size());
+
+		if (s_pbo != 0)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_pbo);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &s_pbo);
+		}
+
+		s_pbo = 0;
+		s_mapped = nullptr;
+		s_capacity = 0;
+		s_head = 0;
+	}
+}
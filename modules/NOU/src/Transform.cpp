@@ -8,125 +8,113 @@ Simple class for managing object transforms with basic hierarchy support.
 
 #include "NOU/Transform.h"
 
-#include "GLM/gtx/transform.hpp"
-
 namespace nou
 {
-	Transform::Transform()
+	Transform::Transform(TransformStore& store)
+	{
+		m_store = &store;
+		m_handle = m_store->Create();
+	}
+
+	Transform::Transform(const Transform& other)
 	{
-		m_parent = nullptr;
+		m_store = other.m_store;
+		m_handle = m_store->Create();
 
-		m_pos = glm::vec3(0.0f);
-		m_scale = glm::vec3(1.0f);
-		m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		*this = other;
+		m_store->SetParent(m_handle, m_store->GetParent(other.m_handle));
+	}
+
+	Transform& Transform::operator=(const Transform& other)
+	{
+		//Assignment only copies the local transform - our place
+		//in the hierarchy stays the same.
+		SetPosition(other.GetPosition());
+		SetRotation(other.GetRotation());
+		SetScale(other.GetScale());
 
-		m_global = glm::mat4(1.0f);
+		return *this;
 	}
 
 	Transform::~Transform()
 	{
-		SetParent(nullptr);
+		m_store->Destroy(m_handle);
 	}
 
-	void Transform::DoFK()
+	const glm::vec3& Transform::GetPosition() const
 	{
-		//First, grab our local transform...
-		glm::mat4 local = glm::translate(m_pos) *
-						  glm::toMat4(glm::normalize(m_rotation)) *
-						  glm::scale(m_scale);
+		return m_store->GetPosition(m_handle);
+	}
 
-		//If we have a parent, we need to multiply by our parent's
-		//global transform.
-		if (m_parent != nullptr)
-			m_global = m_parent->m_global * local;
+	const glm::quat& Transform::GetRotation() const
+	{
+		return m_store->GetRotation(m_handle);
+	}
 
-		//If we have no parent object, our global transform is our
-		//local transform!
-		else
-			m_global = local;
+	const glm::vec3& Transform::GetScale() const
+	{
+		return m_store->GetScale(m_handle);
+	}
 
-		//FK is recursive - we now repeat this process on our child nodes.
-		//Eventually, we'll be at the bottom of the hierarchy and this will
-		//return.
-		for (auto* child : m_children)
-		{
-			child->DoFK();
-		}
+	void Transform::SetPosition(const glm::vec3& pos)
+	{
+		m_store->SetPosition(m_handle, pos);
 	}
 
-	const glm::mat4& Transform::RecomputeGlobal()
+	void Transform::SetRotation(const glm::quat& rotation)
 	{
-		//Just as with FK, compute our local, then multiply with
-		//our parent's transform if applicable.
+		m_store->SetRotation(m_handle, rotation);
+	}
 
-		glm::mat4 local = glm::translate(m_pos) *
-						  glm::toMat4(m_rotation) *
-						  glm::scale(m_scale);
+	void Transform::SetScale(const glm::vec3& scale)
+	{
+		m_store->SetScale(m_handle, scale);
+	}
 
-		if (m_parent != nullptr)
-			m_global = m_parent->RecomputeGlobal() * local;
-		else
-			m_global = local;
+	void Transform::DoFK()
+	{
+		//Our subtree is one contiguous range in the store, so this
+		//is a single loop rather than a recursive walk.
+		m_store->DoFK(m_handle);
+	}
 
-		return m_global;
+	const glm::mat4& Transform::RecomputeGlobal()
+	{
+		return m_store->RecomputeGlobal(m_handle);
 	}
 
 	const glm::mat4& Transform::GetGlobal() const
 	{
-		return m_global;
+		return m_store->GetGlobal(m_handle);
 	}
 
-	glm::mat3 Transform::GetNormal() const
+	const glm::mat3& Transform::GetNormal() const
 	{
-		//The normal matrix is used to transform the normals of our mesh
-		//for correct lighting.
-		//Basically, we need to orient the normals and undo any non-uniform scaling
-		//to prevent strange artifacts (since normals are just directions.)
-		//If we're using a uniform scale, then we can just pass the top 3x3 of our
-		//transform matrix (the rotation/scale bit) - since we'll re-normalize
-		//the normals in our shader anyways.
-		if(m_scale.x == m_scale.y && m_scale.x == m_scale.z)
-			return glm::mat3(m_global);
-
-		//If we do have a non-uniform scale, then we need to undo that scale, 
-		//hence the inverse. However, we want to preserve our rotation.
-		//Since the inverse of a rotation matrix IS its transpose, by adding
-		//in the transpose we can effectively spit our rotation matrix with
-		//the inverse of our scale applied.
-		//You could also do some trickery here with the reciprocal of your
-		//scale vector and your rotation quaternion, but this is a bit more
-		//"bulletproof" and straightforward if you're doing oddball transformations.
-		return glm::inverse(glm::transpose(glm::mat3(m_global)));
+		return m_store->GetNormal(m_handle);
 	}
 
-	void Transform::SetParent(Transform* parent)
+	void Transform::SetBounds(const glm::vec4& sphere)
 	{
-		//If we had a parent before, remove this as a child from that object.
-		if(m_parent != nullptr)
-			m_parent->RemoveChild(this);
-
-		m_parent = parent;
+		m_store->SetBounds(m_handle, sphere);
+	}
 
-		//If we have a parent now, add this as a child to that object.
-		if(m_parent != nullptr)
-			m_parent->AddChild(this);			
+	bool Transform::IsVisible() const
+	{
+		return m_store->IsVisible(m_handle);
 	}
 
-	void Transform::AddChild(Transform* child)
+	void Transform::SetParent(Transform* parent)
 	{
-		m_children.push_back(child);
+		m_store->SetParent(m_handle, (parent != nullptr) ? parent->m_handle : TransformStore::NONE);
 	}
 
-	void Transform::RemoveChild(Transform* child)
+	TransformStore& Transform::GetStore() const
 	{
-		for (auto it = m_children.begin(); it != m_children.end(); ++it)
-		{
-			if (*it == child)
-			{
-				m_children.erase(it);
-				break;
-			}
+		return *m_store;
+	}
 
-		}
+	TransformStore::Handle Transform::GetHandle() const
+	{
+		return m_handle;
 	}
-}
\ No newline at end of file
+}
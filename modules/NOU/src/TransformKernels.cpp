@@ -0,0 +1,451 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TransformKernels.cpp
+Batched (SIMD) routines for building transform matrices.
+*/
+
+#include "NOU/TransformKernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define NOU_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//MSVC lets us use any intrinsic anywhere, but GCC and Clang need to be told
+//which functions are allowed to use instructions beyond the baseline.
+#if defined(__GNUC__) || defined(__clang__)
+#define NOU_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NOU_TARGET(isa)
+#endif
+
+namespace nou::TransformKernels
+{
+	using ComposeFn = void(*)(const glm::vec3*, const glm::quat*, const glm::vec3*, glm::mat4*, size_t);
+	using ConcatFn = void(*)(const uint32_t*, const glm::mat4*, glm::mat4*, const uint32_t*, size_t);
+
+	//Scalar versions - also used for any leftover objects at the end of a batch.
+
+	static inline void ComposeOne(const glm::vec3& pos, const glm::quat& rot, const glm::vec3& scale, glm::mat4& out)
+	{
+		glm::quat q = glm::normalize(rot);
+
+		float qxx = q.x * q.x, qyy = q.y * q.y, qzz = q.z * q.z;
+		float qxz = q.x * q.z, qxy = q.x * q.y, qyz = q.y * q.z;
+		float qwx = q.w * q.x, qwy = q.w * q.y, qwz = q.w * q.z;
+
+		//Same as glm::toMat4, with each column multiplied by its scale factor
+		//and the translation dropped straight into the last column.
+		out[0] = glm::vec4(1.0f - 2.0f * (qyy + qzz), 2.0f * (qxy + qwz), 2.0f * (qxz - qwy), 0.0f) * scale.x;
+		out[1] = glm::vec4(2.0f * (qxy - qwz), 1.0f - 2.0f * (qxx + qzz), 2.0f * (qyz + qwx), 0.0f) * scale.y;
+		out[2] = glm::vec4(2.0f * (qxz + qwy), 2.0f * (qyz - qwx), 1.0f - 2.0f * (qxx + qyy), 0.0f) * scale.z;
+		out[3] = glm::vec4(pos, 1.0f);
+	}
+
+	static void ComposeScalar(const glm::vec3* pos, const glm::quat* rot, const glm::vec3* scale,
+							  glm::mat4* out, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			ComposeOne(pos[i], rot[i], scale[i], out[i]);
+	}
+
+	static void ConcatScalar(const uint32_t* parent, const glm::mat4* local, glm::mat4* global,
+							 const uint32_t* indices, size_t count)
+	{
+		for (size_t k = 0; k < count; ++k)
+		{
+			uint32_t i = indices[k];
+			uint32_t p = parent[i];
+
+			global[i] = (p == NONE) ? local[i] : global[p] * local[i];
+		}
+	}
+
+#ifdef NOU_X86
+
+	//Splits 4 packed vec3s (12 floats) into separate x, y and z vectors.
+	static inline void LoadVec3x4(const glm::vec3* v, __m128& x, __m128& y, __m128& z)
+	{
+		const float* f = &v[0].x;
+
+		__m128 a = _mm_loadu_ps(f);     //x0 y0 z0 x1
+		__m128 b = _mm_loadu_ps(f + 4); //y1 z1 x2 y2
+		__m128 c = _mm_loadu_ps(f + 8); //z2 x3 y3 z3
+
+		__m128 t1 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		x = _mm_shuffle_ps(a, t1, _MM_SHUFFLE(2, 0, 3, 0));
+
+		t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		__m128 t2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+		y = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(2, 0, 2, 0));
+
+		t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		t2 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+		z = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	//Splits 4 quaternions into separate x, y, z and w vectors.
+	static inline void LoadQuatx4(const glm::quat* q, __m128& x, __m128& y, __m128& z, __m128& w)
+	{
+		x = _mm_loadu_ps(&q[0].x);
+		y = _mm_loadu_ps(&q[1].x);
+		z = _mm_loadu_ps(&q[2].x);
+		w = _mm_loadu_ps(&q[3].x);
+
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+	}
+
+	//Writes column col of 4 consecutive matrices, given the column's components
+	//for each matrix packed into x, y, z and w.
+	static inline void StoreColumnx4(glm::mat4* out, int col, __m128 x, __m128 y, __m128 z, __m128 w)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		_mm_storeu_ps(&out[0][col].x, x);
+		_mm_storeu_ps(&out[1][col].x, y);
+		_mm_storeu_ps(&out[2][col].x, z);
+		_mm_storeu_ps(&out[3][col].x, w);
+	}
+
+	NOU_TARGET("sse4.1")
+	static void ComposeSSE4(const glm::vec3* pos, const glm::quat* rot, const glm::vec3* scale,
+							glm::mat4* out, size_t count)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 qx, qy, qz, qw;
+			LoadQuatx4(rot + i, qx, qy, qz, qw);
+
+			//Normalize, falling back to identity for zero-length quaternions (like GLM does).
+			__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+												_mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw))));
+			__m128 valid = _mm_cmpgt_ps(len, zero);
+			__m128 inv = _mm_div_ps(one, len);
+
+			qx = _mm_blendv_ps(zero, _mm_mul_ps(qx, inv), valid);
+			qy = _mm_blendv_ps(zero, _mm_mul_ps(qy, inv), valid);
+			qz = _mm_blendv_ps(zero, _mm_mul_ps(qz, inv), valid);
+			qw = _mm_blendv_ps(one, _mm_mul_ps(qw, inv), valid);
+
+			__m128 qxx = _mm_mul_ps(qx, qx), qyy = _mm_mul_ps(qy, qy), qzz = _mm_mul_ps(qz, qz);
+			__m128 qxz = _mm_mul_ps(qx, qz), qxy = _mm_mul_ps(qx, qy), qyz = _mm_mul_ps(qy, qz);
+			__m128 qwx = _mm_mul_ps(qw, qx), qwy = _mm_mul_ps(qw, qy), qwz = _mm_mul_ps(qw, qz);
+
+			__m128 sx, sy, sz;
+			LoadVec3x4(scale + i, sx, sy, sz);
+
+			__m128 px, py, pz;
+			LoadVec3x4(pos + i, px, py, pz);
+
+			StoreColumnx4(out + i, 0,
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qyy, qzz))), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qxy, qwz)), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qxz, qwy)), sx),
+				zero);
+
+			StoreColumnx4(out + i, 1,
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qxy, qwz)), sy),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qzz))), sy),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qyz, qwx)), sy),
+				zero);
+
+			StoreColumnx4(out + i, 2,
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qxz, qwy)), sz),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qyz, qwx)), sz),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qyy))), sz),
+				zero);
+
+			StoreColumnx4(out + i, 3, px, py, pz, one);
+		}
+
+		ComposeScalar(pos + i, rot + i, scale + i, out + i, count - i);
+	}
+
+	//out = a * b, one column at a time: each column of the result is a
+	//weighted sum of the columns of a.
+	static inline void MulMat4SSE(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+	{
+		__m128 a0 = _mm_loadu_ps(&a[0].x);
+		__m128 a1 = _mm_loadu_ps(&a[1].x);
+		__m128 a2 = _mm_loadu_ps(&a[2].x);
+		__m128 a3 = _mm_loadu_ps(&a[3].x);
+
+		for (int j = 0; j < 4; ++j)
+		{
+			__m128 bj = _mm_loadu_ps(&b[j].x);
+
+			__m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(0, 0, 0, 0)));
+			r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(1, 1, 1, 1))));
+			r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(2, 2, 2, 2))));
+			r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(3, 3, 3, 3))));
+
+			_mm_storeu_ps(&out[j].x, r);
+		}
+	}
+
+	NOU_TARGET("sse4.1")
+	static void ConcatSSE4(const uint32_t* parent, const glm::mat4* local, glm::mat4* global,
+						   const uint32_t* indices, size_t count)
+	{
+		for (size_t k = 0; k < count; ++k)
+		{
+			uint32_t i = indices[k];
+			uint32_t p = parent[i];
+
+			if (p == NONE)
+				global[i] = local[i];
+			else
+				MulMat4SSE(global[p], local[i], global[i]);
+		}
+	}
+
+	NOU_TARGET("avx2,fma")
+	static void ComposeAVX2(const glm::vec3* pos, const glm::quat* rot, const glm::vec3* scale,
+							glm::mat4* out, size_t count)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			//Load each half with the SSE helpers, then glue them together.
+			__m128 lo[4], hi[4];
+
+			LoadQuatx4(rot + i, lo[0], lo[1], lo[2], lo[3]);
+			LoadQuatx4(rot + i + 4, hi[0], hi[1], hi[2], hi[3]);
+
+			__m256 qx = _mm256_set_m128(hi[0], lo[0]);
+			__m256 qy = _mm256_set_m128(hi[1], lo[1]);
+			__m256 qz = _mm256_set_m128(hi[2], lo[2]);
+			__m256 qw = _mm256_set_m128(hi[3], lo[3]);
+
+			__m256 len = _mm256_sqrt_ps(_mm256_fmadd_ps(qx, qx, _mm256_fmadd_ps(qy, qy,
+										_mm256_fmadd_ps(qz, qz, _mm256_mul_ps(qw, qw)))));
+			__m256 valid = _mm256_cmp_ps(len, zero, _CMP_GT_OQ);
+			__m256 inv = _mm256_div_ps(one, len);
+
+			qx = _mm256_blendv_ps(zero, _mm256_mul_ps(qx, inv), valid);
+			qy = _mm256_blendv_ps(zero, _mm256_mul_ps(qy, inv), valid);
+			qz = _mm256_blendv_ps(zero, _mm256_mul_ps(qz, inv), valid);
+			qw = _mm256_blendv_ps(one, _mm256_mul_ps(qw, inv), valid);
+
+			__m256 qxx = _mm256_mul_ps(qx, qx), qyy = _mm256_mul_ps(qy, qy), qzz = _mm256_mul_ps(qz, qz);
+			__m256 qxz = _mm256_mul_ps(qx, qz), qxy = _mm256_mul_ps(qx, qy), qyz = _mm256_mul_ps(qy, qz);
+			__m256 qwx = _mm256_mul_ps(qw, qx), qwy = _mm256_mul_ps(qw, qy), qwz = _mm256_mul_ps(qw, qz);
+
+			LoadVec3x4(scale + i, lo[0], lo[1], lo[2]);
+			LoadVec3x4(scale + i + 4, hi[0], hi[1], hi[2]);
+
+			__m256 sx = _mm256_set_m128(hi[0], lo[0]);
+			__m256 sy = _mm256_set_m128(hi[1], lo[1]);
+			__m256 sz = _mm256_set_m128(hi[2], lo[2]);
+
+			//cols[c][r] holds component r of column c, for all 8 objects at once.
+			__m256 cols[4][4];
+
+			cols[0][0] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(qyy, qzz), one), sx);
+			cols[0][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qxy, qwz)), sx);
+			cols[0][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qxz, qwy)), sx);
+			cols[0][3] = zero;
+
+			cols[1][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qxy, qwz)), sy);
+			cols[1][1] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(qxx, qzz), one), sy);
+			cols[1][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qyz, qwx)), sy);
+			cols[1][3] = zero;
+
+			cols[2][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qxz, qwy)), sz);
+			cols[2][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qyz, qwx)), sz);
+			cols[2][2] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(qxx, qyy), one), sz);
+			cols[2][3] = zero;
+
+			for (int c = 0; c < 3; ++c)
+			{
+				StoreColumnx4(out + i, c,
+					_mm256_castps256_ps128(cols[c][0]), _mm256_castps256_ps128(cols[c][1]),
+					_mm256_castps256_ps128(cols[c][2]), _mm256_castps256_ps128(cols[c][3]));
+
+				StoreColumnx4(out + i + 4, c,
+					_mm256_extractf128_ps(cols[c][0], 1), _mm256_extractf128_ps(cols[c][1], 1),
+					_mm256_extractf128_ps(cols[c][2], 1), _mm256_extractf128_ps(cols[c][3], 1));
+			}
+
+			//The translation column doesn't need any math, so we can stay in SSE.
+			__m128 px, py, pz;
+			const __m128 one4 = _mm_set1_ps(1.0f);
+
+			LoadVec3x4(pos + i, px, py, pz);
+			StoreColumnx4(out + i, 3, px, py, pz, one4);
+
+			LoadVec3x4(pos + i + 4, px, py, pz);
+			StoreColumnx4(out + i + 4, 3, px, py, pz, one4);
+		}
+
+		ComposeScalar(pos + i, rot + i, scale + i, out + i, count - i);
+	}
+
+	NOU_TARGET("avx2,fma")
+	static void ConcatAVX2(const uint32_t* parent, const glm::mat4* local, glm::mat4* global,
+						   const uint32_t* indices, size_t count)
+	{
+		for (size_t k = 0; k < count; ++k)
+		{
+			uint32_t i = indices[k];
+			uint32_t p = parent[i];
+
+			if (p == NONE)
+			{
+				global[i] = local[i];
+				continue;
+			}
+
+			//Same as the SSE version, but two columns of the result at a time.
+			const glm::mat4& a = global[p];
+			const glm::mat4& b = local[i];
+
+			__m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[0].x));
+			__m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[1].x));
+			__m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[2].x));
+			__m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[3].x));
+
+			for (int j = 0; j < 4; j += 2)
+			{
+				__m256 bj = _mm256_loadu_ps(&b[j].x);
+
+				__m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(bj, _MM_SHUFFLE(0, 0, 0, 0)));
+				r = _mm256_fmadd_ps(a1, _mm256_permute_ps(bj, _MM_SHUFFLE(1, 1, 1, 1)), r);
+				r = _mm256_fmadd_ps(a2, _mm256_permute_ps(bj, _MM_SHUFFLE(2, 2, 2, 2)), r);
+				r = _mm256_fmadd_ps(a3, _mm256_permute_ps(bj, _MM_SHUFFLE(3, 3, 3, 3)), r);
+
+				_mm256_storeu_ps(&global[i][j].x, r);
+			}
+		}
+	}
+
+#endif
+
+	struct KernelTable
+	{
+		ISA isa;
+		ComposeFn compose;
+		ConcatFn concat;
+	};
+
+	static KernelTable MakeTable(ISA isa)
+	{
+		switch (isa)
+		{
+#ifdef NOU_X86
+			case ISA::AVX2:
+			return { ISA::AVX2, ComposeAVX2, ConcatAVX2 };
+
+			case ISA::SSE4:
+			return { ISA::SSE4, ComposeSSE4, ConcatSSE4 };
+#endif
+			default:
+			return { ISA::SCALAR, ComposeScalar, ConcatScalar };
+		}
+	}
+
+	static KernelTable& Table()
+	{
+		static KernelTable table = MakeTable(Detect());
+		return table;
+	}
+
+	ISA Detect()
+	{
+#if defined(NOU_X86) && defined(_MSC_VER)
+		int info[4];
+
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bool sse41 = (info[2] & (1 << 19)) != 0;
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+
+		//The OS also has to be saving the upper halves of the AVX registers for us.
+		bool ymmEnabled = osxsave && avx && ((_xgetbv(0) & 0x6) == 0x6);
+
+		bool avx2 = false;
+
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		if (avx2 && fma && ymmEnabled)
+			return ISA::AVX2;
+
+		if (sse41)
+			return ISA::SSE4;
+#elif defined(NOU_X86) && (defined(__GNUC__) || defined(__clang__))
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+			return ISA::AVX2;
+
+		if (__builtin_cpu_supports("sse4.1"))
+			return ISA::SSE4;
+#endif
+		return ISA::SCALAR;
+	}
+
+	ISA GetISA()
+	{
+		return Table().isa;
+	}
+
+	void SetISA(ISA isa)
+	{
+		if (static_cast<int>(isa) > static_cast<int>(Detect()))
+			isa = Detect();
+
+		Table() = MakeTable(isa);
+	}
+
+	const char* GetISAName(ISA isa)
+	{
+		switch (isa)
+		{
+			case ISA::AVX2:
+			return "AVX2";
+
+			case ISA::SSE4:
+			return "SSE4";
+
+			default:
+			return "Scalar";
+		}
+	}
+
+	void ComposeTRS(const glm::vec3* pos, const glm::quat* rot, const glm::vec3* scale,
+					glm::mat4* out, size_t count)
+	{
+		Table().compose(pos, rot, scale, out, count);
+	}
+
+	void ConcatParents(const uint32_t* parent, const glm::mat4* local, glm::mat4* global,
+					   const uint32_t* indices, size_t count)
+	{
+		Table().concat(parent, local, global, indices, count);
+	}
+}
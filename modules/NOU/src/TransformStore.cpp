@@ -0,0 +1,866 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TransformStore.cpp
+Scene-level storage for transform hierarchies.
+*/
+
+#include "NOU/TransformStore.h"
+#include "NOU/TransformKernels.h"
+#include "NOU/JobSystem.h"
+#include "NOU/BVH.h"
+
+#include <algorithm>
+
+namespace nou
+{
+	//Reorders a dense array so that element k of the result is element order[k] of the input.
+	template<typename T>
+	static void Permute(std::vector<T>& data, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> sorted;
+		sorted.reserve(order.size());
+
+		for (uint32_t index : order)
+			sorted.push_back(data[index]);
+
+		data.swap(sorted);
+	}
+
+	//The normal matrix is used to transform the normals of our mesh
+	//for correct lighting.
+	//Basically, we need to orient the normals and undo any non-uniform scaling
+	//to prevent strange artifacts (since normals are just directions) - which is
+	//what the inverse-transpose of our global rotation/scale does.
+	//Rather than a general 3x3 inverse, we use the fact that the inverse-transpose
+	//of a matrix is just its cofactor matrix divided by its determinant, and the
+	//cofactor columns are cross products of the original columns.
+	static glm::mat3 NormalMatrix(const glm::mat4& global)
+	{
+		glm::vec3 x = glm::vec3(global[0]);
+		glm::vec3 y = glm::vec3(global[1]);
+		glm::vec3 z = glm::vec3(global[2]);
+
+		glm::mat3 cofactor(glm::cross(y, z), glm::cross(z, x), glm::cross(x, y));
+		float det = glm::dot(x, cofactor[0]);
+
+		//A zero scale squashes everything flat, so there's nothing
+		//sensible to invert - just pass the matrix through.
+		if (det == 0.0f)
+			return glm::mat3(global);
+
+		return cofactor * (1.0f / det);
+	}
+
+	//Moves a local bounding sphere into world space. Scaling can stretch the
+	//sphere into an ellipsoid, so we use the largest axis scale to make sure
+	//the result still contains it.
+	static glm::vec4 WorldBounds(const glm::mat4& global, const glm::vec4& local)
+	{
+		if (local.w < 0.0f)
+			return local;
+
+		glm::vec3 center = glm::vec3(global * glm::vec4(glm::vec3(local), 1.0f));
+
+		float maxScale2 = glm::max(glm::dot(global[0], global[0]),
+						  glm::max(glm::dot(global[1], global[1]), glm::dot(global[2], global[2])));
+
+		return glm::vec4(center, local.w * glm::sqrt(maxScale2));
+	}
+
+	TransformStore& TransformStore::Default()
+	{
+		//Constructed on first use, so it will always outlive any
+		//transform that was created before it.
+		static TransformStore store;
+		return store;
+	}
+
+	TransformStore::TransformStore()
+	{
+		m_orderDirty = false;
+		m_fullUpdate = false;
+		m_lastUpdateCount = 0;
+		m_trackUpdates = false;
+		m_lastVisibleCount = 0;
+		m_lastCulledCount = 0;
+		m_parallelThreshold = 8192;
+		m_bvhCullThreshold = 200000;
+	}
+
+	TransformStore::Handle TransformStore::Create()
+	{
+		Handle handle;
+
+		if (!m_freeHandles.empty())
+		{
+			handle = m_freeHandles.back();
+			m_freeHandles.pop_back();
+		}
+		else
+		{
+			handle = static_cast<Handle>(m_dense.size());
+			m_dense.push_back(NONE);
+		}
+
+		//A new root at the end of the arrays is still in a valid
+		//parent-before-child order, so we don't need to re-sort here.
+		uint32_t index = static_cast<uint32_t>(m_handle.size());
+		m_dense[handle] = index;
+
+		m_pos.push_back(glm::vec3(0.0f));
+		m_rotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		m_scale.push_back(glm::vec3(1.0f));
+		m_local.push_back(glm::mat4(1.0f));
+		m_global.push_back(glm::mat4(1.0f));
+		m_normal.push_back(glm::mat3(1.0f));
+		m_localBounds.push_back(glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+		m_worldBounds.push_back(glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+		m_visible.push_back(1);
+		m_localDirty.push_back(0);
+		m_globalDirty.push_back(0);
+		m_parent.push_back(NONE);
+		m_subtreeSize.push_back(1);
+		m_handle.push_back(handle);
+
+		//Identity TRS gives an identity global, so a new transform starts out clean.
+		return handle;
+	}
+
+	void TransformStore::Destroy(Handle handle)
+	{
+		uint32_t index = Dense(handle);
+
+		//Detach our children. If we're sorted, they can only be inside our
+		//own subtree range - otherwise we have to look everywhere.
+		uint32_t begin = 0;
+		uint32_t end = static_cast<uint32_t>(m_parent.size());
+
+		if (!m_orderDirty)
+		{
+			begin = index + 1;
+			end = index + m_subtreeSize[index];
+		}
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			if (m_parent[i] == index)
+			{
+				m_parent[i] = NONE;
+				//Losing our parent changes our global transform.
+				m_globalDirty[i] = 1;
+			}
+		}
+
+		//We leave a dead slot behind rather than compacting right away,
+		//since compacting would invalidate the dense parent indices of other nodes.
+		//The next Reorder() will drop it.
+		m_parent[index] = NONE;
+		m_handle[index] = NONE;
+		m_globalDirty[index] = 0;
+		m_orderDirty = true;
+
+		m_dense[handle] = NONE;
+		m_freeHandles.push_back(handle);
+	}
+
+	bool TransformStore::SetParent(Handle handle, Handle parent)
+	{
+		uint32_t index = Dense(handle);
+		uint32_t parentIndex = (parent == NONE) ? NONE : Dense(parent);
+
+		if (m_parent[index] == parentIndex)
+			return true;
+
+		//Make sure we aren't about to parent an object to one of its own descendants.
+		for (uint32_t p = parentIndex; p != NONE; p = m_parent[p])
+		{
+			if (p == index)
+				return false;
+		}
+
+		m_parent[index] = parentIndex;
+		m_orderDirty = true;
+
+		//Our subtree gets marked once we've been re-sorted into place.
+		m_globalDirty[index] = 1;
+
+		return true;
+	}
+
+	TransformStore::Handle TransformStore::GetParent(Handle handle) const
+	{
+		uint32_t parent = m_parent[Dense(handle)];
+		return (parent == NONE) ? NONE : m_handle[parent];
+	}
+
+	const glm::vec3& TransformStore::GetPosition(Handle handle) const
+	{
+		return m_pos[Dense(handle)];
+	}
+
+	const glm::quat& TransformStore::GetRotation(Handle handle) const
+	{
+		return m_rotation[Dense(handle)];
+	}
+
+	const glm::vec3& TransformStore::GetScale(Handle handle) const
+	{
+		return m_scale[Dense(handle)];
+	}
+
+	void TransformStore::SetPosition(Handle handle, const glm::vec3& pos)
+	{
+		uint32_t index = Dense(handle);
+
+		m_pos[index] = pos;
+		m_localDirty[index] = 1;
+		MarkDirty(index);
+	}
+
+	void TransformStore::SetRotation(Handle handle, const glm::quat& rotation)
+	{
+		uint32_t index = Dense(handle);
+
+		m_rotation[index] = rotation;
+		m_localDirty[index] = 1;
+		MarkDirty(index);
+	}
+
+	void TransformStore::SetScale(Handle handle, const glm::vec3& scale)
+	{
+		uint32_t index = Dense(handle);
+
+		m_scale[index] = scale;
+		m_localDirty[index] = 1;
+		MarkDirty(index);
+	}
+
+	const glm::mat4& TransformStore::GetGlobal(Handle handle) const
+	{
+		return m_global[Dense(handle)];
+	}
+
+	const glm::mat3& TransformStore::GetNormal(Handle handle) const
+	{
+		return m_normal[Dense(handle)];
+	}
+
+	void TransformStore::SetBounds(Handle handle, const glm::vec4& sphere)
+	{
+		uint32_t index = Dense(handle);
+
+		m_localBounds[index] = sphere;
+
+		//If our global transform is up to date, FK won't come back for us,
+		//so bring the world bounds up to date now.
+		if (!IsDirty(handle))
+			m_worldBounds[index] = WorldBounds(m_global[index], sphere);
+	}
+
+	const glm::vec4& TransformStore::GetWorldBounds(Handle handle) const
+	{
+		return m_worldBounds[Dense(handle)];
+	}
+
+	size_t TransformStore::Cull(const Frustum& frustum)
+	{
+		//Since everything's in flat arrays, this is one pass over contiguous
+		//memory, rather than a test per draw call.
+		size_t count = m_worldBounds.size();
+
+		m_lastVisibleCount = frustum.TestSpheres(m_worldBounds.data(), count, m_visible.data());
+
+		//Dead slots (from Destroy) don't count towards anything.
+		size_t live = count;
+
+		if (m_orderDirty)
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (m_handle[i] == NONE)
+				{
+					--live;
+					m_lastVisibleCount -= m_visible[i];
+				}
+			}
+		}
+
+		m_lastCulledCount = live - m_lastVisibleCount;
+
+		return m_lastVisibleCount;
+	}
+
+	size_t TransformStore::Cull(const Frustum& frustum, const BVH& bvh)
+	{
+		size_t count = m_worldBounds.size();
+
+		if (count < m_bvhCullThreshold)
+			return Cull(frustum);
+
+		//Everything starts out culled, except for objects without bounds
+		//(which aren't in the BVH, and are always visible).
+		for (uint32_t i = 0; i < count; ++i)
+			m_visible[i] = (m_worldBounds[i].w < 0.0f) ? 1 : 0;
+
+		m_cullResults.clear();
+		bvh.QueryFrustum(frustum, m_cullResults);
+
+		for (Handle handle : m_cullResults)
+			m_visible[Dense(handle)] = 1;
+
+		m_lastVisibleCount = 0;
+		size_t live = 0;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (m_handle[i] == NONE)
+				continue;
+
+			++live;
+			m_lastVisibleCount += m_visible[i];
+		}
+
+		m_lastCulledCount = live - m_lastVisibleCount;
+
+		return m_lastVisibleCount;
+	}
+
+	bool TransformStore::IsVisible(Handle handle) const
+	{
+		return m_visible[Dense(handle)] != 0;
+	}
+
+	size_t TransformStore::LastVisibleCount() const
+	{
+		return m_lastVisibleCount;
+	}
+
+	size_t TransformStore::LastCulledCount() const
+	{
+		return m_lastCulledCount;
+	}
+
+	bool TransformStore::IsDirty(Handle handle) const
+	{
+		uint32_t index = Dense(handle);
+
+		if (!m_orderDirty)
+			return m_globalDirty[index] != 0;
+
+		//If we haven't re-sorted yet, dirtiness hasn't been pushed
+		//down to descendants, so we have to check our ancestors too.
+		for (uint32_t i = index; i != NONE; i = m_parent[i])
+		{
+			if (m_globalDirty[i])
+				return true;
+		}
+
+		return false;
+	}
+
+	void TransformStore::DoFK()
+	{
+		if (m_orderDirty)
+			Reorder();
+
+		m_ranges.clear();
+
+		if (m_fullUpdate)
+		{
+			m_ranges.push_back({ 0, static_cast<uint32_t>(m_handle.size()) });
+			m_fullUpdate = false;
+		}
+		else
+		{
+			//Visit each dirty subtree once. Sorting the roots lets us skip any
+			//that are nested inside a subtree we've already covered.
+			std::vector<uint32_t> roots;
+			roots.reserve(m_dirtyRoots.size());
+
+			for (Handle handle : m_dirtyRoots)
+			{
+				uint32_t index = m_dense[handle];
+
+				if (index != NONE)
+					roots.push_back(index);
+			}
+
+			std::sort(roots.begin(), roots.end());
+
+			uint32_t coveredEnd = 0;
+
+			for (uint32_t root : roots)
+			{
+				if (root < coveredEnd)
+					continue;
+
+				coveredEnd = root + m_subtreeSize[root];
+				m_ranges.push_back({ root, coveredEnd });
+			}
+		}
+
+		m_lastUpdateCount = UpdateRanges();
+		m_dirtyRoots.clear();
+	}
+
+	void TransformStore::DoFK(Handle root)
+	{
+		if (m_orderDirty)
+			Reorder();
+
+		uint32_t index = Dense(root);
+
+		//Make sure our parent's transform is up to date before we build on it.
+		if (m_parent[index] != NONE && m_globalDirty[m_parent[index]])
+			RecomputeGlobal(m_handle[m_parent[index]]);
+
+		m_ranges.clear();
+		m_ranges.push_back({ index, index + m_subtreeSize[index] });
+
+		m_lastUpdateCount = UpdateRanges();
+	}
+
+	const glm::mat4& TransformStore::RecomputeGlobal(Handle handle)
+	{
+		uint32_t index = Dense(handle);
+
+		//If our ordering is stale, our dirty flags might not have reached us yet,
+		//so we recompute the whole chain (but leave the flags alone for the next FK pass).
+		if (m_orderDirty)
+		{
+			std::vector<uint32_t> chain;
+
+			for (uint32_t i = index; i != NONE; i = m_parent[i])
+				chain.push_back(i);
+
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+			{
+				uint32_t i = *it;
+				uint32_t p = m_parent[i];
+
+				if (m_localDirty[i])
+					ComputeLocal(i);
+
+				m_global[i] = (p == NONE) ? m_local[i] : m_global[p] * m_local[i];
+				m_normal[i] = NormalMatrix(m_global[i]);
+				m_worldBounds[i] = WorldBounds(m_global[i], m_localBounds[i]);
+				if (m_trackUpdates)
+					m_updated.push_back(m_handle[i]);
+			}
+
+			return m_global[index];
+		}
+
+		//Otherwise, since a dirty parent always means a dirty child, we only need
+		//to walk up until we find a clean ancestor - then compute back down.
+		uint32_t top = index;
+
+		while (m_globalDirty[top] && m_parent[top] != NONE && m_globalDirty[m_parent[top]])
+			top = m_parent[top];
+
+		if (m_globalDirty[top])
+		{
+			std::vector<uint32_t> chain;
+
+			for (uint32_t i = index; i != top; i = m_parent[i])
+				chain.push_back(i);
+
+			ComputeGlobal(top);
+
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+				ComputeGlobal(*it);
+		}
+
+		return m_global[index];
+	}
+
+	size_t TransformStore::Size() const
+	{
+		return m_dense.size() - m_freeHandles.size();
+	}
+
+	size_t TransformStore::LastUpdateCount() const
+	{
+		return m_lastUpdateCount;
+	}
+
+	void TransformStore::SetTrackUpdates(bool track)
+	{
+		m_trackUpdates = track;
+
+		if (!track)
+			m_updated.clear();
+	}
+
+	const std::vector<TransformStore::Handle>& TransformStore::GetUpdated() const
+	{
+		return m_updated;
+	}
+
+	void TransformStore::ClearUpdated()
+	{
+		m_updated.clear();
+	}
+
+	void TransformStore::SetParallelThreshold(size_t threshold)
+	{
+		m_parallelThreshold = threshold;
+	}
+
+	void TransformStore::SetBVHCullThreshold(size_t threshold)
+	{
+		m_bvhCullThreshold = threshold;
+	}
+
+	uint32_t TransformStore::Dense(Handle handle) const
+	{
+		return m_dense[handle];
+	}
+
+	void TransformStore::Reorder()
+	{
+		uint32_t count = static_cast<uint32_t>(m_handle.size());
+
+		//Build a list of children for every node (packed into one array, with
+		//childStart[i] being the index of node i's first child).
+		std::vector<uint32_t> childStart(count + 1, 0);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (m_parent[i] != NONE)
+				++childStart[m_parent[i] + 1];
+		}
+
+		for (uint32_t i = 0; i < count; ++i)
+			childStart[i + 1] += childStart[i];
+
+		std::vector<uint32_t> children(childStart[count]);
+		std::vector<uint32_t> cursor(childStart.begin(), childStart.end() - 1);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (m_parent[i] != NONE)
+				children[cursor[m_parent[i]]++] = i;
+		}
+
+		//Walk each tree depth-first, recording the order we visit nodes in.
+		//That gives us parent-before-child order with contiguous subtrees.
+		//Dead slots (left behind by Destroy) have no parent or children,
+		//so we can drop them by just skipping them here.
+		std::vector<uint32_t> order;
+		order.reserve(count);
+
+		std::vector<uint32_t> stack;
+
+		for (uint32_t root = 0; root < count; ++root)
+		{
+			if (m_parent[root] != NONE || m_handle[root] == NONE)
+				continue;
+
+			stack.push_back(root);
+
+			while (!stack.empty())
+			{
+				uint32_t node = stack.back();
+				stack.pop_back();
+
+				order.push_back(node);
+
+				//Push in reverse so that children keep their relative order.
+				for (uint32_t c = childStart[node + 1]; c > childStart[node]; --c)
+					stack.push_back(children[c - 1]);
+			}
+		}
+
+		std::vector<uint32_t> newIndex(count, NONE);
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(order.size()); ++i)
+			newIndex[order[i]] = i;
+
+		Permute(m_pos, order);
+		Permute(m_rotation, order);
+		Permute(m_scale, order);
+		Permute(m_local, order);
+		Permute(m_global, order);
+		Permute(m_normal, order);
+		Permute(m_localBounds, order);
+		Permute(m_worldBounds, order);
+		Permute(m_visible, order);
+		Permute(m_localDirty, order);
+		Permute(m_globalDirty, order);
+		Permute(m_parent, order);
+		Permute(m_handle, order);
+
+		count = static_cast<uint32_t>(order.size());
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (m_parent[i] != NONE)
+			{
+				m_parent[i] = newIndex[m_parent[i]];
+
+				//While we were unsorted, dirty flags couldn't be pushed down to
+				//descendants. Parents come first now, so one sweep fixes that.
+				if (m_globalDirty[m_parent[i]])
+					m_globalDirty[i] = 1;
+			}
+
+			m_dense[m_handle[i]] = i;
+		}
+
+		//Since parents always come first, we can accumulate subtree sizes
+		//in a single backwards sweep.
+		m_subtreeSize.assign(count, 1);
+
+		for (uint32_t i = count; i > 0; --i)
+		{
+			if (m_parent[i - 1] != NONE)
+				m_subtreeSize[m_parent[i - 1]] += m_subtreeSize[i - 1];
+		}
+
+		//Our list of dirty roots doesn't account for anything that was marked
+		//while we were unsorted, so the next FK pass checks every flag instead.
+		m_orderDirty = false;
+		m_fullUpdate = true;
+	}
+
+	void TransformStore::MarkDirty(uint32_t index)
+	{
+		//If we're already dirty, then so is our subtree - nothing more to do.
+		if (m_globalDirty[index])
+			return;
+
+		m_globalDirty[index] = 1;
+
+		//While we're unsorted we can't find our subtree; Reorder() will finish the job.
+		if (m_orderDirty)
+			return;
+
+		std::fill(m_globalDirty.begin() + index,
+				  m_globalDirty.begin() + index + m_subtreeSize[index], 1);
+
+		m_dirtyRoots.push_back(m_handle[index]);
+	}
+
+	void TransformStore::ComputeLocal(uint32_t index)
+	{
+		TransformKernels::ComposeTRS(&m_pos[index], &m_rotation[index], &m_scale[index],
+									 &m_local[index], 1);
+
+		m_localDirty[index] = 0;
+	}
+
+	void TransformStore::ComputeGlobal(uint32_t index)
+	{
+		if (m_localDirty[index])
+			ComputeLocal(index);
+
+		//Our parent is guaranteed to be up to date before we get here.
+		TransformKernels::ConcatParents(m_parent.data(), m_local.data(), m_global.data(), &index, 1);
+		m_normal[index] = NormalMatrix(m_global[index]);
+		m_worldBounds[index] = WorldBounds(m_global[index], m_localBounds[index]);
+		if (m_trackUpdates)
+			m_updated.push_back(m_handle[index]);
+
+		m_globalDirty[index] = 0;
+	}
+
+	size_t TransformStore::UpdateRanges()
+	{
+		size_t total = 0;
+
+		for (const Range& range : m_ranges)
+			total += range.second - range.first;
+
+		size_t threads = JobSystem::GetWorkerCount() + 1;
+
+		if (m_scratch.size() < threads)
+			m_scratch.resize(threads);
+
+		Scratch& scratch = m_scratch[JobSystem::GetThreadIndex()];
+
+		size_t count = 0;
+
+		if (threads == 1 || total < m_parallelThreshold)
+		{
+			for (const Range& range : m_ranges)
+				count += UpdateRange(range.first, range.second, scratch);
+
+			m_updated.insert(m_updated.end(), scratch.updated.begin(), scratch.updated.end());
+			scratch.updated.clear();
+
+			return count;
+		}
+
+		//Aim for a few chunks per thread, so that if one chunk turns out
+		//to be mostly clean, the others can steal the slack.
+		const size_t minChunk = 1024;
+		size_t target = std::max(minChunk, total / (threads * 4));
+
+		m_chunkRanges.clear();
+		m_chunks.assign(1, 0);
+		m_heads.clear();
+
+		size_t chunkSize = 0;
+
+		for (const Range& range : m_ranges)
+			SplitRange(range, target, chunkSize);
+
+		if (chunkSize > 0)
+			m_chunks.push_back(m_chunkRanges.size());
+
+		//Heads are the ancestors of our chunks, so they have to go first.
+		//Sorting puts them in parent-before-child order, and lets us hand
+		//runs of consecutive heads (e.g., a long chain) over as one range.
+		std::sort(m_heads.begin(), m_heads.end());
+
+		for (size_t i = 0; i < m_heads.size();)
+		{
+			size_t len = 1;
+
+			while (i + len < m_heads.size() && m_heads[i + len] == m_heads[i] + len)
+				++len;
+
+			count += UpdateRange(m_heads[i], m_heads[i] + static_cast<uint32_t>(len), scratch);
+			i += len;
+		}
+
+		//Every chunk is made of whole subtrees whose parents are already done,
+		//and no two chunks share a node - so they can all run at once.
+		size_t numChunks = m_chunks.size() - 1;
+		m_chunkCounts.assign(numChunks, 0);
+
+		JobSystem::ParallelFor(0, numChunks, [this](size_t begin, size_t end)
+		{
+			Scratch& threadScratch = m_scratch[JobSystem::GetThreadIndex()];
+
+			for (size_t c = begin; c < end; ++c)
+			{
+				for (size_t r = m_chunks[c]; r < m_chunks[c + 1]; ++r)
+					m_chunkCounts[c] += UpdateRange(m_chunkRanges[r].first, m_chunkRanges[r].second, threadScratch);
+			}
+		}, 1);
+
+		for (size_t chunkCount : m_chunkCounts)
+			count += chunkCount;
+
+		for (Scratch& threadScratch : m_scratch)
+		{
+			m_updated.insert(m_updated.end(), threadScratch.updated.begin(), threadScratch.updated.end());
+			threadScratch.updated.clear();
+		}
+
+		return count;
+	}
+
+	void TransformStore::SplitRange(const Range& range, size_t target, size_t& chunkSize)
+	{
+		//Ranges here are always a run of whole sibling subtrees, so we can
+		//step from one subtree to the next by its size.
+		//(Done with our own stack rather than recursion, since a hierarchy
+		//can easily be deeper than the call stack.)
+		std::vector<Range> stack = { range };
+
+		while (!stack.empty())
+		{
+			Range current = stack.back();
+			stack.pop_back();
+
+			for (uint32_t i = current.first; i < current.second; i += m_subtreeSize[i])
+			{
+				uint32_t size = m_subtreeSize[i];
+
+				if (size <= target)
+				{
+					AddToChunk(i, i + size, target, chunkSize);
+				}
+				else
+				{
+					//Too big for one chunk - we'll update this node up front,
+					//then split its children up instead.
+					m_heads.push_back(i);
+					stack.push_back({ i + 1, i + size });
+				}
+			}
+		}
+	}
+
+	void TransformStore::AddToChunk(uint32_t begin, uint32_t end, size_t target, size_t& chunkSize)
+	{
+		//Neighbouring subtrees in the same chunk are merged into one range,
+		//so the kernels can batch across them.
+		if (chunkSize > 0 && m_chunkRanges.back().second == begin)
+			m_chunkRanges.back().second = end;
+		else
+			m_chunkRanges.push_back({ begin, end });
+
+		chunkSize += end - begin;
+
+		if (chunkSize >= target)
+		{
+			m_chunks.push_back(m_chunkRanges.size());
+			chunkSize = 0;
+		}
+	}
+
+	size_t TransformStore::UpdateRange(uint32_t begin, uint32_t end, Scratch& scratch)
+	{
+		std::vector<uint32_t>& dirty = scratch.dirty;
+
+		//Gather up the dirty nodes in this range.
+		//(We have to check every flag, since RecomputeGlobal may have cleaned
+		//part of a dirty subtree ahead of time.)
+		dirty.clear();
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			if (m_globalDirty[i])
+				dirty.push_back(i);
+		}
+
+		//Rebuild stale local matrices in batches - each run of consecutive
+		//nodes is handed to the SIMD kernel in one go.
+		size_t k = 0;
+
+		while (k < dirty.size())
+		{
+			if (!m_localDirty[dirty[k]])
+			{
+				++k;
+				continue;
+			}
+
+			uint32_t first = dirty[k];
+			size_t len = 1;
+
+			while (k + len < dirty.size() && m_localDirty[dirty[k + len]] && dirty[k + len] == first + len)
+				++len;
+
+			TransformKernels::ComposeTRS(&m_pos[first], &m_rotation[first], &m_scale[first],
+										 &m_local[first], len);
+
+			std::fill(m_localDirty.begin() + first, m_localDirty.begin() + first + len, 0);
+
+			k += len;
+		}
+
+		//Parents come before their children, so by the time we reach a node,
+		//its parent's global transform is already up to date.
+		TransformKernels::ConcatParents(m_parent.data(), m_local.data(), m_global.data(),
+										dirty.data(), dirty.size());
+
+		for (uint32_t i : dirty)
+		{
+			m_normal[i] = NormalMatrix(m_global[i]);
+			m_worldBounds[i] = WorldBounds(m_global[i], m_localBounds[i]);
+			m_globalDirty[i] = 0;
+
+			if (m_trackUpdates)
+				scratch.updated.push_back(m_handle[i]);
+		}
+
+		return dirty.size();
+	}
+}
@@ -16,6 +16,7 @@
 #include <string>
 #include "glad/glad.h"
 #include <memory>
+#include <vector>
 
 namespace TTK {
 	class  Texture2D
@@ -23,6 +24,16 @@ namespace TTK {
 	public:
 		typedef std::shared_ptr<Texture2D> Ptr;
 
+		/*
+		 * Decoded pixels, as read from an image file by DecodeFile
+		 */
+		struct ImageData {
+			int Width = 0;
+			int Height = 0;
+			int NumChannels = 0;
+			std::vector<unsigned char> Pixels;
+		};
+
 		/*
 		 * Creates a blank texture object. Load data into it with
 		 * CreateTexture and LoadTextureFromFile
@@ -70,10 +81,27 @@ namespace TTK {
 		 */
 		void LoadTextureFromFile(const std::string& filePath);
 
+		/*
+		 * Reads and decodes an image file, without touching OpenGL, so this can be
+		 * called from a worker thread (see nou::AssetManager::Load). Images are flipped
+		 * according to stbi_set_flip_vertically_on_load, so set that before loading starts.
+		 * @param filePath The path to the file relative to the current working directory
+		 * @param result Receives the decoded pixels
+		 * @returns True if the file could be decoded
+		 */
+		static bool DecodeFile(const std::string& filePath, ImageData& result);
+
+		/*
+		 * Uploads pixels decoded by DecodeFile into this texture instance
+		 * @param image The decoded image
+		 */
+		void LoadTextureFromData(const ImageData& image);
+
 		/*
 		 * Creates the texture, allocates memory and uploads data to GPU
 		 * If you do not want to upload data to the GPU pass in a nullptr for the dataPtr.
 		 * For a description on filtering and edgeBehaviour see https://www.khronos.org/opengles/sdk/docs/man/xhtml/glTexParameter.xml
+		 * Mipmapped filters (such as GL_LINEAR_MIPMAP_LINEAR) generate the texture's mipmaps after uploading
 		 * For a description on internalFormat, textureFormat and dataType see https://www.opengl.org/sdk/docs/man/html/glTexImage2D.xhtml
 		 *
 		 * @param w The width of the texture, in pixels
@@ -99,6 +127,15 @@ namespace TTK {
 		unsigned int GetID() const { return m_TexID; };
 
 	private:
+		/*
+		 * Whether the given minification filter samples mipmaps
+		 */
+		static bool IsMipmapped(GLenum filtering);
+		/*
+		 * Whether the given minification filter picks the nearest texel
+		 */
+		static bool IsNearest(GLenum filtering);
+
 		unsigned int m_TexWidth;
 		unsigned int m_TexHeight;
 		unsigned int m_TexID;
@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This header is a part of the Tutorial Tool Kit (TTK) library. 
+// You may not use this header in your GDW games.
+//
+// This header contains a streaming uploader for texture data. Pixels are
+// copied into a persistently mapped pixel buffer object (PBO), used as a
+// ring, and glTexSubImage2D reads them from there instead of from client
+// memory, so the call doesn't have to wait for the driver to copy them.
+// Fences keep us from overwriting ring memory the GPU hasn't read yet.
+//
+// Shawn Matthews 2019
+//
+//////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "glad/glad.h"
+#include <cstddef>
+#include <deque>
+
+namespace TTK
+{
+	class TextureUploader
+	{
+	public:
+		inline static TextureUploader& Instance() {
+			if (m_Instance == nullptr)
+				m_Instance = new TextureUploader();
+			return *m_Instance;
+		}
+		inline static void DestroyContext() {
+			delete m_Instance;
+			m_Instance = nullptr;
+		}
+
+		~TextureUploader();
+
+		/*
+		 * Uploads pixels to the given mip level of the texture bound to target, like glTexSubImage2D
+		 * Data too big for the ring (or a driver older than GL 4.4) falls back to a direct upload
+		 * @param target The target the texture is bound to, usually GL_TEXTURE_2D
+		 * @param level The mip level to write to
+		 * @param w The width of the data, in pixels
+		 * @param h The height of the data, in pixels (or layers, for GL_TEXTURE_1D_ARRAY)
+		 * @param textureFormat The format of the data, such as GL_RGBA
+		 * @param dataType The type of each component, such as GL_UNSIGNED_BYTE
+		 * @param data A pointer to the data to upload
+		 */
+		void Upload(GLenum target, GLint level, int w, int h, GLenum textureFormat, GLenum dataType, const void* data);
+
+		/*
+		 * Gets the number of bytes that the given data takes up in client memory, using
+		 * the default unpack alignment of 4, or 0 for formats the uploader doesn't know
+		 */
+		static size_t GetDataSize(int w, int h, GLenum textureFormat, GLenum dataType);
+
+		/*
+		 * Gets the number of times an upload had to wait for the GPU to finish reading ring memory
+		 */
+		size_t GetStallCount() const { return m_Stalls; }
+
+		static const size_t RingSize = 16 << 20;
+
+	private:
+		TextureUploader();
+
+		static TextureUploader* m_Instance;
+
+		struct Region {
+			size_t Begin, End;
+			GLsync Fence;
+		};
+
+		size_t Allocate(size_t size);
+		void Retire(size_t count);
+
+		GLuint m_Buffer;
+		char*  m_Mapped;
+		size_t m_Head;
+		size_t m_Stalls;
+		std::deque<Region> m_Regions;
+	};
+}
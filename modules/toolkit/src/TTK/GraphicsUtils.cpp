@@ -13,6 +13,7 @@
 
 #include "TTK/GraphicsUtils.h"
 #include "TTK/TTKContext.h"
+#include "TTK/TextureUploader.h"
 #include <GLM/gtc/matrix_transform.inl>
 
 #include "imgui.h"
@@ -94,6 +95,7 @@ void TTK::Graphics::DrawGrid(float gridWidth, AlignMode mode) {
 void TTK::Graphics::Cleanup() {
 	TTK::Context::DestroyContext();
 	TTK::FontRenderer::DestroyContext();
+	TTK::TextureUploader::DestroyContext();
 }
 
 void TTK::Graphics::DrawText2D(const std::string& text, float posX, float posY, float fontSize) {
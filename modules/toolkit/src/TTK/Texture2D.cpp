@@ -1,4 +1,5 @@
 #include "TTK/Texture2D.h"
+#include "TTK/TextureUploader.h"
 #include "stb_image.h"
 
 #include <iostream>
@@ -37,12 +38,39 @@ namespace TTK {
 	}
 
 	void Texture2D::LoadTextureFromFile(const std::string& filePath)
+	{
+		ImageData image;
+		bool decoded = DecodeFile(filePath, image);
+
+		LOG_ASSERT(decoded, "Failed to load texture from \"{}\"", filePath);
+
+		LoadTextureFromData(image);
+	}
+
+	bool Texture2D::DecodeFile(const std::string& filePath, ImageData& result)
 	{
 		int numChannels = 0;
-		int width, height; 
+		int width, height;
 		unsigned char* imageData = stbi_load(filePath.c_str(), &width, &height, &numChannels, 0);
 
-		LOG_ASSERT(imageData != nullptr, "Failed to load texture from \"{}\"", filePath);
+		if (imageData == nullptr)
+			return false;
+
+		result.Width = width;
+		result.Height = height;
+		result.NumChannels = numChannels;
+		result.Pixels.assign(imageData, imageData + (size_t)width * height * numChannels);
+
+		// Free stb's copy, since we have our own
+		stbi_image_free(imageData);
+
+		return true;
+	}
+
+	void Texture2D::LoadTextureFromData(const ImageData& image)
+	{
+		int numChannels = image.NumChannels;
+		int width = image.Width, height = image.Height;
 
 		// We have data!
 		GLenum internal_format, image_format;
@@ -63,7 +91,7 @@ namespace TTK {
 			break;
 
 		default:
-			std::cout << "Unsupported texture format. Texture may look strange." + filePath << std::endl;
+			std::cout << "Unsupported texture format. Texture may look strange." << std::endl;
 			internal_format = GL_RGB8;
 			image_format = GL_RGB;
 			break;
@@ -73,11 +101,16 @@ namespace TTK {
 			LOG_ERROR("Cannot load texture! The line size must be a multiple of 4! If your texture has less than 4 channels, ensure that the width of the texture * the number of channels is 4!");
 
 		} else {
-			CreateTexture(width, height, GL_TEXTURE_2D, GL_LINEAR, GL_CLAMP_TO_EDGE, internal_format, image_format, GL_UNSIGNED_BYTE, imageData);
+			CreateTexture(width, height, GL_TEXTURE_2D, GL_LINEAR_MIPMAP_LINEAR, GL_CLAMP_TO_EDGE, internal_format, image_format, GL_UNSIGNED_BYTE, (void*)image.Pixels.data());
 		}
-		
-		// Free our image data, since it is already on the GPU
-		stbi_image_free(imageData);
+	}
+
+	bool Texture2D::IsMipmapped(GLenum filtering) {
+		return filtering != GL_NEAREST && filtering != GL_LINEAR;
+	}
+
+	bool Texture2D::IsNearest(GLenum filtering) {
+		return filtering == GL_NEAREST || filtering == GL_NEAREST_MIPMAP_NEAREST || filtering == GL_NEAREST_MIPMAP_LINEAR;
 	}
 
 	void Texture2D::CreateTexture(int w, int h, GLenum target, GLenum filtering, GLenum edgeBehaviour, GLenum internalFormat, GLenum textureFormat, GLenum dataType, void* data) {
@@ -103,13 +136,18 @@ namespace TTK {
 		glBindTexture(target, m_TexID);
 		error = glGetError();
 
+		// Magnification never uses mipmaps, so it gets the matching non-mipmapped filter
 		glTexParameteri(m_Target, GL_TEXTURE_MIN_FILTER, filtering);
-		glTexParameteri(m_Target, GL_TEXTURE_MAG_FILTER, filtering);
+		glTexParameteri(m_Target, GL_TEXTURE_MAG_FILTER, IsNearest(filtering) ? GL_NEAREST : GL_LINEAR);
 		glTexParameteri(m_Target, GL_TEXTURE_WRAP_S, edgeBehaviour);
 		glTexParameteri(m_Target, GL_TEXTURE_WRAP_T, edgeBehaviour);
 		error = glGetError();
 
-		glTexImage2D(m_Target, 0, internalFormat, w, h, 0, textureFormat, dataType, data);
+		// Allocate the storage, then stream the data in (see TextureUploader.h)
+		glTexImage2D(m_Target, 0, internalFormat, w, h, 0, textureFormat, dataType, nullptr);
+		TextureUploader::Instance().Upload(m_Target, 0, w, h, textureFormat, dataType, data);
+		if (data != nullptr && IsMipmapped(filtering))
+			glGenerateMipmap(m_Target);
 		error = glGetError();
 
 		if (error != 0)
@@ -127,7 +165,10 @@ namespace TTK {
 		glBindTexture(m_Target, m_TexID);
 
 		if (newDataPtr != nullptr)
-			glTexSubImage2D(m_Target, 0, 0, 0, m_TexWidth, m_TexHeight, m_TextureFormat, m_DataType, newDataPtr);
+			TextureUploader::Instance().Upload(m_Target, 0, m_TexWidth, m_TexHeight, m_TextureFormat, m_DataType, newDataPtr);
+
+		if (IsMipmapped(m_Filtering))
+			glGenerateMipmap(m_Target);
 
 		glBindTexture(m_Target, 0);
 	}
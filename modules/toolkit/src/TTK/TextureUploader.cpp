@@ -0,0 +1,126 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is a part of the Tutorial Tool Kit (TTK) library. 
+// You may not use this file in your GDW games.
+//
+// This file implements the TTK texture uploader
+//
+// Shawn Matthews 2019
+//
+//////////////////////////////////////////////////////////////////////////
+
+#include "TTK/TextureUploader.h"
+#include <cstring>
+
+TTK::TextureUploader* TTK::TextureUploader::m_Instance = nullptr;
+
+TTK::TextureUploader::TextureUploader() :
+	m_Buffer(0),
+	m_Mapped(nullptr),
+	m_Head(0),
+	m_Stalls(0)
+{
+	// Persistent mapping needs GL 4.4, without it everything is uploaded directly
+	if (glBufferStorage == nullptr)
+		return;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &m_Buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Buffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, RingSize, nullptr, flags);
+	m_Mapped = (char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, RingSize, flags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+TTK::TextureUploader::~TextureUploader() {
+	Retire(m_Regions.size());
+
+	if (m_Buffer) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &m_Buffer);
+	}
+}
+
+size_t TTK::TextureUploader::GetDataSize(int w, int h, GLenum textureFormat, GLenum dataType) {
+	size_t components = 0, componentSize = 0;
+
+	switch (textureFormat) {
+	case GL_RED: components = 1; break;
+	case GL_RG: components = 2; break;
+	case GL_RGB: case GL_BGR: components = 3; break;
+	case GL_RGBA: case GL_BGRA: components = 4; break;
+	}
+
+	switch (dataType) {
+	case GL_UNSIGNED_BYTE: case GL_BYTE: componentSize = 1; break;
+	case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: componentSize = 2; break;
+	case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: componentSize = 4; break;
+	}
+
+	if (w <= 0 || h <= 0)
+		return 0;
+
+	// Every row but the last is padded out to the unpack alignment
+	size_t rowSize = w * components * componentSize;
+	size_t paddedRowSize = (rowSize + 3) & ~(size_t)3;
+
+	return paddedRowSize * (h - 1) + rowSize;
+}
+
+void TTK::TextureUploader::Upload(GLenum target, GLint level, int w, int h, GLenum textureFormat, GLenum dataType, const void* data) {
+	if (data == nullptr)
+		return;
+
+	size_t size = GetDataSize(w, h, textureFormat, dataType);
+
+	if (m_Mapped == nullptr || size == 0 || size > RingSize) {
+		glTexSubImage2D(target, level, 0, 0, w, h, textureFormat, dataType, data);
+		return;
+	}
+
+	size_t offset = Allocate(size);
+	memcpy(m_Mapped + offset, data, size);
+
+	// With a buffer bound to GL_PIXEL_UNPACK_BUFFER, the data pointer is an offset into it
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Buffer);
+	glTexSubImage2D(target, level, 0, 0, w, h, textureFormat, dataType, (const void*)offset);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	m_Regions.push_back({ offset, offset + size, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+}
+
+size_t TTK::TextureUploader::Allocate(size_t size) {
+	// Wrap around to the start if there isn't room left at the end
+	size_t begin = (m_Head + size > RingSize) ? 0 : m_Head;
+	size_t end = begin + size;
+
+	// Find the newest upload still using the memory we want, fences signal in order so
+	// once that one is done, everything before it is as well
+	size_t overlap = m_Regions.size();
+	for (size_t ix = 0; ix < m_Regions.size(); ix++) {
+		if (m_Regions[ix].Begin < end && begin < m_Regions[ix].End)
+			overlap = ix;
+	}
+
+	if (overlap < m_Regions.size()) {
+		if (glClientWaitSync(m_Regions[overlap].Fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+			m_Stalls++;
+			while (glClientWaitSync(m_Regions[overlap].Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+		}
+		Retire(overlap + 1);
+	}
+
+	// Keep offsets aligned for any data type
+	m_Head = (end + 15) & ~(size_t)15;
+
+	return begin;
+}
+
+void TTK::TextureUploader::Retire(size_t count) {
+	for (size_t ix = 0; ix < count; ix++)
+		glDeleteSync(m_Regions[ix].Fence);
+	m_Regions.erase(m_Regions.begin(), m_Regions.begin() + count);
+}
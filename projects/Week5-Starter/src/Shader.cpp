@@ -2,6 +2,7 @@
 #include "Logging.h"
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 Shader::Shader() :
 	// We zero out all of our members so we don't have garbage data in our class
@@ -124,6 +125,8 @@ bool Shader::Link()
 		} else {
 			LOG_ERROR("Shader failed to link for an unknown reason!");
 		}
+	} else {
+		__ReflectUniforms();
 	}
 	return status != GL_FALSE;
 }
@@ -188,15 +191,26 @@ void Shader::SetUniform(int location, const glm::bvec4* value, int count) {
 	glProgramUniform4i(location, value->x, value->y, value->z, value->w, 1);
 }
 
+const Shader::UniformInfo* Shader::FindUniform(UniformID id) const {
+	std::unordered_map<uint32_t, size_t>::const_iterator it = _uniformLookup.find(id.hash);
+	return it != _uniformLookup.end() ? &_uniforms[it->second] : nullptr;
+}
+
+const Shader::BlockInfo* Shader::FindBlock(UniformID id) const {
+	std::unordered_map<uint32_t, size_t>::const_iterator it = _blockLookup.find(id.hash);
+	return it != _blockLookup.end() ? &_blocks[it->second] : nullptr;
+}
+
 int Shader::__GetUniformLocation(const std::string& name) {
-	// Search the map for the given name
-	std::unordered_map<std::string, int>::const_iterator it = _uniformLocs.find(name);
+	// Search the map for the given name's hash
+	UniformID id(name);
+	std::unordered_map<uint32_t, int>::const_iterator it = _uniformLocs.find(id.hash);
 	int result = -1;
 
-	// If our entry was not found, we call glGetUniform and store it for next time
+	// If our entry was not found (ex: an element of an array, like "u_Lights[2]"), we call glGetUniform and store it for next time
 	if (it == _uniformLocs.end()) {
 		result = glGetUniformLocation(_handle, name.c_str());
-		_uniformLocs[name] = result;
+		_uniformLocs[id.hash] = result;
 	}
 	// Otherwise, we had a value in the map, return it
 	else {
@@ -204,4 +218,115 @@ int Shader::__GetUniformLocation(const std::string& name) {
 	}
 
 	return result;
-}
\ No newline at end of file
+}
+
+int Shader::__GetUniformLocation(UniformID id) const {
+	// Everything the shader has was put in the map when it was linked, so if it's not there, it doesn't exist
+	std::unordered_map<uint32_t, int>::const_iterator it = _uniformLocs.find(id.hash);
+	return it != _uniformLocs.end() ? it->second : -1;
+}
+
+void Shader::__ReflectUniforms() {
+	_uniforms.clear();
+	_blocks.clear();
+	_uniformLookup.clear();
+	_blockLookup.clear();
+	_uniformLocs.clear();
+
+	// We'll need somewhere to put names, so find out how long the longest one is
+	GLint maxNameLength = 0;
+	glGetProgramInterfaceiv(_handle, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+	std::vector<char> name(std::max(maxNameLength, 1));
+
+	// Uniforms
+	GLint count = 0;
+	glGetProgramInterfaceiv(_handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+	const GLenum uniformProps[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX };
+	for (GLint ix = 0; ix < count; ix++) {
+		GLint values[4];
+		glGetProgramResourceiv(_handle, GL_UNIFORM, ix, 4, uniformProps, 4, nullptr, values);
+
+		// Skip uniforms that live in blocks (and atomic counters), they don't have locations
+		if (values[3] != -1 || values[2] < 0) {
+			continue;
+		}
+
+		GLsizei length = 0;
+		glGetProgramResourceName(_handle, GL_UNIFORM, ix, (GLsizei)name.size(), &length, name.data());
+
+		UniformInfo uniform;
+		uniform.Name = std::string(name.data(), length);
+		uniform.Type = (GLenum)values[0];
+		uniform.ArraySize = values[1];
+		uniform.Location = values[2];
+		uniform.Binding = -1;
+
+		// OpenGL calls arrays "name[0]", we want to be able to find them by either name
+		const std::string suffix = "[0]";
+		if (uniform.Name.size() > suffix.size() && uniform.Name.compare(uniform.Name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+			_uniformLocs[UniformID(uniform.Name).hash] = uniform.Location;
+			uniform.Name.resize(uniform.Name.size() - suffix.size());
+		}
+
+		// Samplers store which texture unit they read from
+		if (__IsSamplerType(uniform.Type)) {
+			glGetUniformiv(_handle, uniform.Location, &uniform.Binding);
+		}
+
+		// Two names with the same hash is very unlikely, but we want to know if it happens
+		uint32_t hash = UniformID(uniform.Name).hash;
+		if (!_uniformLocs.emplace(hash, uniform.Location).second) {
+			LOG_WARN("Uniform \"{}\" has the same hash as another uniform, rename one of them!", uniform.Name);
+		}
+		_uniformLookup.emplace(hash, _uniforms.size());
+
+		_uniforms.push_back(uniform);
+	}
+
+	// Uniform blocks and shader storage blocks
+	const GLenum blockTypes[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+	const GLenum blockProps[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+	for (GLenum blockType : blockTypes) {
+		glGetProgramInterfaceiv(_handle, blockType, GL_MAX_NAME_LENGTH, &maxNameLength);
+		glGetProgramInterfaceiv(_handle, blockType, GL_ACTIVE_RESOURCES, &count);
+		name.resize(std::max(maxNameLength, 1));
+
+		for (GLint ix = 0; ix < count; ix++) {
+			GLint values[2];
+			glGetProgramResourceiv(_handle, blockType, ix, 2, blockProps, 2, nullptr, values);
+
+			GLsizei length = 0;
+			glGetProgramResourceName(_handle, blockType, ix, (GLsizei)name.size(), &length, name.data());
+
+			BlockInfo block;
+			block.Name = std::string(name.data(), length);
+			block.BlockType = blockType;
+			block.Binding = values[0];
+			block.Size = values[1];
+
+			if (!_blockLookup.emplace(UniformID(block.Name).hash, _blocks.size()).second) {
+				LOG_WARN("Block \"{}\" has the same hash as another block, rename one of them!", block.Name);
+			}
+
+			_blocks.push_back(block);
+		}
+	}
+}
+
+bool Shader::__IsSamplerType(GLenum type) {
+	switch (type) {
+		case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+		case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_CUBE_MAP_ARRAY:
+		case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW: case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+		case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_RECT: case GL_SAMPLER_2D_RECT_SHADOW:
+		case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE: case GL_INT_SAMPLER_2D_ARRAY:
+		case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D:
+		case GL_UNSIGNED_INT_SAMPLER_CUBE: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+			return true;
+		default:
+			return false;
+	}
+}
@@ -3,9 +3,16 @@
 #include <memory>
 #include <string>               // for std::string
 #include <unordered_map>        // for std::unordered_map
+#include <vector>               // for std::vector
 #include <GLM/glm.hpp>          // for our GLM types
 #include <GLM/gtc/type_ptr.hpp> // for glm::value_ptr
 #include "Logging.h"            // for the logging functions
+#include <NOU/UniformID.h>      // for compile-time hashed uniform names
+
+// Lets us write "u_ModelViewProjection"_u to get a uniform ID that's hashed at compile time,
+// so setting a uniform doesn't need to build a string or hash one every frame
+using nou::UniformID;
+using nou::operator""_u;
 
 // We can use an enum to make our code more readable and restrict
 // values to only ones we want to accept
@@ -78,6 +85,50 @@ public:
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
 
+public:
+	/// <summary>
+	/// Describes one of the shader's active uniforms, as found when the shader was linked
+	/// </summary>
+	struct UniformInfo {
+		std::string Name;      // Arrays go by their plain name (ex: "u_Lights" instead of "u_Lights[0]")
+		int         Location;
+		GLenum      Type;      // ex: GL_FLOAT_MAT4 or GL_SAMPLER_2D
+		int         ArraySize;
+		int         Binding;   // The texture unit for samplers, -1 for anything else
+	};
+
+	/// <summary>
+	/// Describes one of the shader's uniform or shader storage blocks, as found when the shader was linked
+	/// </summary>
+	struct BlockInfo {
+		std::string Name;
+		GLenum      BlockType; // GL_UNIFORM_BLOCK or GL_SHADER_STORAGE_BLOCK
+		int         Binding;
+		int         Size;      // In bytes
+	};
+
+	/// <summary>
+	/// Gets all of the active uniforms outside of blocks (empty until the shader is linked)
+	/// </summary>
+	const std::vector<UniformInfo>& GetUniforms() const { return _uniforms; }
+	/// <summary>
+	/// Gets all of the active uniform and shader storage blocks (empty until the shader is linked)
+	/// </summary>
+	const std::vector<BlockInfo>& GetBlocks() const { return _blocks; }
+
+	/// <summary>
+	/// Finds an active uniform by its ID
+	/// </summary>
+	/// <param name="id">The uniform's ID (ex: "u_ModelViewProjection"_u)</param>
+	/// <returns>The uniform's info, or nullptr if the shader has no such uniform</returns>
+	const UniformInfo* FindUniform(UniformID id) const;
+	/// <summary>
+	/// Finds an active uniform or shader storage block by its ID
+	/// </summary>
+	/// <param name="id">The block's ID (ex: "b_Lights"_u)</param>
+	/// <returns>The block's info, or nullptr if the shader has no such block</returns>
+	const BlockInfo* FindBlock(UniformID id) const;
+
 public:
 	void SetUniformMatrix(int location, const glm::mat3* value, int count = 1, bool transposed = false);
 	void SetUniformMatrix(int location, const glm::mat4* value, int count = 1, bool transposed = false);
@@ -112,6 +163,26 @@ public:
 			LOG_WARN("Ignoring uniform \"{}\"", name);
 		}
 	}
+
+	// These versions are the ones to use every frame, since looking up an ID doesn't allocate or hash anything
+	template <typename T>
+	void SetUniform(UniformID id, const T& value) {
+		int location = __GetUniformLocation(id);
+		if (location != -1) {
+			SetUniform(location, &value, 1);
+		} else {
+			LOG_WARN("Ignoring uniform {:#010x}", id.hash);
+		}
+	}
+	template <typename T>
+	void SetUniformMatrix(UniformID id, const T& value, bool transposed = false) {
+		int location = __GetUniformLocation(id);
+		if (location != -1) {
+			SetUniformMatrix(location, &value, 1, transposed);
+		} else {
+			LOG_WARN("Ignoring uniform {:#010x}", id.hash);
+		}
+	}
 	
 protected:
 	// Stores the vertex and fragment shader handles
@@ -121,7 +192,18 @@ protected:
 	// Stores the shader program handle
 	GLuint _handle;
 
-	// Map and access to look up uniform locations
-	std::unordered_map<std::string, int> _uniformLocs;
+	// What we found out about the shader when it was linked
+	std::vector<UniformInfo> _uniforms;
+	std::vector<BlockInfo> _blocks;
+	std::unordered_map<uint32_t, size_t> _uniformLookup;
+	std::unordered_map<uint32_t, size_t> _blockLookup;
+
+	// Map and access to look up uniform locations by the hash of their names
+	std::unordered_map<uint32_t, int> _uniformLocs;
 	int __GetUniformLocation(const std::string& name);
+	int __GetUniformLocation(UniformID id) const;
+
+	// Asks OpenGL about all of the active uniforms and blocks, and fills in the tables above
+	void __ReflectUniforms();
+	static bool __IsSamplerType(GLenum type);
 };
\ No newline at end of file
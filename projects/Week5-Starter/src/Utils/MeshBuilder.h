@@ -1,5 +1,9 @@
 #pragma once
 #include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <NOU/MeshOptimizer.h>
 #include "VertexArrayObject.h"
 
 /// <summary>
@@ -116,16 +120,46 @@ public:
 	/// </summary>
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
+	/// <summary>
+	/// Reorders the triangles and vertices of this mesh so the GPU can draw it faster (better
+	/// vertex cache use, less overdraw, and more linear vertex fetches), without changing what
+	/// gets drawn. Vertex indices returned by AddVertex are no longer valid afterwards!
+	/// Only works for meshes with indices, and vertex types with a Position field
+	/// </summary>
+	/// <returns>The vertex cache stats (ACMR/ATVR) before and after optimizing</returns>
+	nou::MeshOptimizer::Report Optimize() {
+		if (_indices.empty()) {
+			return nou::MeshOptimizer::Report();
+		}
+		return nou::MeshOptimizer::Optimize(_vertices, _indices, offsetof(VertType, Position));
+	}
+
 	/// <summary>
 	/// Creates and returns a VertexArraybject from the current data
 	/// </summary>
+	/// <param name="optimize">If true, the mesh will be optimized (see Optimize) before creating the VAO</param>
 	/// <returns>A VertexArrayObject</returns>
-	VertexArrayObject::Sptr Bake() {
+	VertexArrayObject::Sptr Bake(bool optimize = true) {
+		if (optimize) {
+			Optimize();
+		}
+		
 		VertexBuffer::Sptr vbo = VertexBuffer::Create();
 		vbo->LoadData(GetVertexDataPtr(), _vertices.size());
 
+		// Use the smallest index type that can hold all our indices, smaller indices mean less memory to read per vertex.
+		// We stop at 16 bits: plenty of GPUs don't support 8 bit indices natively, and convert them behind our back
+		uint32_t maxIndex = 0;
+		for (uint32_t index : _indices) {
+			maxIndex = std::max(maxIndex, index);
+		}
+
 		IndexBuffer::Sptr ebo = IndexBuffer::Create();
-		ebo->LoadData(GetIndexDataPtr(), _indices.size());
+		if (maxIndex <= UINT16_MAX) {
+			LoadIndicesAs<uint16_t>(ebo);
+		} else {
+			ebo->LoadData(GetIndexDataPtr(), _indices.size());
+		}
 
 		VertexArrayObject::Sptr result = VertexArrayObject::Create();
 		result->AddVertexBuffer(vbo, VertType::V_DECL);
@@ -151,6 +185,20 @@ public:
 	
 protected:
 	friend class MeshFactory;
+
+	/// <summary>
+	/// Uploads our indices to the given index buffer, narrowed down to the given type
+	/// </summary>
+	/// <typeparam name="T">The type to store indices as, must be able to hold every index in the mesh</typeparam>
+	/// <param name="ebo">The buffer to upload to</param>
+	template <typename T>
+	void LoadIndicesAs(const IndexBuffer::Sptr& ebo) const {
+		std::vector<T> narrowed(_indices.size());
+		for (size_t ix = 0; ix < _indices.size(); ix++) {
+			narrowed[ix] = static_cast<T>(_indices[ix]);
+		}
+		ebo->LoadData(narrowed.data(), narrowed.size());
+	}
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
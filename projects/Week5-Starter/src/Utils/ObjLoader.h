@@ -6,6 +6,12 @@
 class ObjLoader
 {
 public:
+	/// <summary>
+	/// Loads a mesh from an OBJ file (using nou::OBJ), reading positions, normals and UVs. Face corners
+	/// with the same attributes are welded into a single vertex, and drawn using an index buffer
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <returns>A VertexArrayObject with the mesh's vertices and indices</returns>
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
 
 protected:
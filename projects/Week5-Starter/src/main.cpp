@@ -871,27 +871,27 @@ int main() {
 		// Draw MeshFactory Sample
 
 																								
-		shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* paddle);
+		shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* paddle);
 		paddleVAO->Draw();
 
 		VertexArrayObject::Unbind();
 
-		shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* ball);
+		shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* ball);
 		ballVAO->Draw();
 
 		VertexArrayObject::Unbind(); 
 
 
 		///////////// WALLS /////////////////
-		shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* Walls);
+		shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* Walls);
 		leftWallVAO->Draw();
 		VertexArrayObject::Unbind();
 
-		shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* Walls);
+		shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* Walls);
 		rightWallVAO->Draw();
 		VertexArrayObject::Unbind();
 
-		shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * Walls);
+		shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection() * Walls);
 		ceilingVAO->Draw();
 		VertexArrayObject::Unbind();
 		/////////////////////////////////////
@@ -930,12 +930,12 @@ int main() {
 					}
 					else
 					{
-						shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * boxes[counter]);
+						shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection() * boxes[counter]);
 						boxVAO[counter]->Draw();
 
 						VertexArrayObject::Unbind();
 
-						shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* boxText[counter]);
+						shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* boxText[counter]);
 						vao2->Bind();
 						glDrawElements(GL_TRIANGLES, interleaved_ibo->GetElementCount(), (GLenum)interleaved_ibo->GetElementType(), nullptr);
 
@@ -969,7 +969,7 @@ int main() {
 					else
 					{
 						//draw undamaged box
-						shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * boxes[counter]);
+						shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection() * boxes[counter]);
 						boxVAO[counter]->Draw();
 
 						if (counter == 0)
@@ -1044,12 +1044,12 @@ int main() {
 					else
 					{
 						//draw damaged box
-						shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * boxes[counter]);
+						shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection() * boxes[counter]);
 						boxVAO[counter]->Draw();
 
 						VertexArrayObject::Unbind();
 
-						shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* boxText[counter]);
+						shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* boxText[counter]);
 						vao2->Bind();
 						glDrawElements(GL_TRIANGLES, interleaved_ibo->GetElementCount(), (GLenum)interleaved_ibo->GetElementType(), nullptr);
 
@@ -1065,57 +1065,57 @@ int main() {
 		
 		//////////////////////////////        UI        ///////////////////////////////////////////
 		if (score % 10 == 0) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* zero);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* zero);
 			for (int counter = 0; counter < 6; counter++)
 				zeroVAO[counter]->Draw();
 		}
 		if (score % 10 == 1) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* one[0]);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* one[0]);
 			oneVAO[0]->Draw();
 		}
 		if (score % 10 == 2) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* two);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* two);
 			for (int counter = 0; counter < 5; counter++)
 				twoVAO[counter]->Draw();
 		}
 		if (score % 10 == 3) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* three);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* three);
 			for (int counter = 0; counter < 5; counter++)
 				threeVAO[counter]->Draw();
 		}
 		if (score % 10 == 4) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* four);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* four);
 			for (int counter = 0; counter < 4; counter++)
 				fourVAO[counter]->Draw();
 		}
 		if (score % 10 == 5) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* five);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* five);
 			for (int counter = 0; counter < 5; counter++)
 				fiveVAO[counter]->Draw();
 		}
 		if (score % 10 == 6) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* six);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* six);
 			for (int counter = 0; counter < 6; counter++)
 				sixVAO[counter]->Draw();
 		}
 		if (score % 10 == 7) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* seven);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* seven);
 			for (int counter = 0; counter < 3; counter++)
 				sevenVAO[counter]->Draw();
 		}
 		if (score % 10 == 8) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* eight);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* eight);
 			for (int counter = 0; counter < 7; counter++)
 				eightVAO[counter]->Draw();
 		}
 		if (score % 10 == 9) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* nine);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* nine);
 			for (int counter = 0; counter < 6; counter++)
 				nineVAO[counter]->Draw();
 		}
 		
 		if (score >= 10) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* one[1]);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* one[1]);
 			oneVAO[1]->Draw();
 		}
 
@@ -1156,12 +1156,12 @@ int main() {
 
 		/*
 		// Draw OBJ loaded model
-		shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection() * transform3);
+		shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection() * transform3);
 		vao4->Draw();
 		
 		VertexArrayObject::Unbind();
 		
-		shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* test);
+		shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* test);
 		vao2->Bind();
 		glDrawElements(GL_TRIANGLES, interleaved_ibo->GetElementCount(), (GLenum)interleaved_ibo->GetElementType(), nullptr);
 
@@ -1173,15 +1173,15 @@ int main() {
 		}
 
 		if (lives >= 5) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* life[2]);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* life[2]);
 			lifeVAO[2]->Draw();
 		}
 		if (lives >= 3) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* life[1]);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* life[1]);
 			lifeVAO[1]->Draw();
 		}
 		if (lives >= 1) {
-			shader->SetUniformMatrix("u_ModelViewProjection", camera->GetViewProjection()* life[0]);
+			shader->SetUniformMatrix("u_ModelViewProjection"_u, camera->GetViewProjection()* life[0]);
 			lifeVAO[0]->Draw();
 		}
 		//////////////////////////////////Debug Testing Zone
@@ -0,0 +1,254 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+BVH benchmark.
+Compares BVH queries (frustum, ray, and overlap) against brute force -
+testing every object - at 10k, 100k, and 1M objects. Also times building
+the tree, and refitting it after 1% of the objects have moved.
+
+Objects are scattered through a cube that grows with the object count,
+so the density (and thus how much of the scene the camera sees) stays
+about the same at every size.
+*/
+
+#include "NOU/BVH.h"
+#include "NOU/Frustum.h"
+
+#include "GLM/gtc/matrix_transform.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace nou;
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double Millis(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+//Brute force version of BVH::Raycast.
+static bool RaycastAll(const std::vector<AABB>& boxes, const glm::vec3& origin,
+					   const glm::vec3& direction, float maxDistance)
+{
+	glm::vec3 invDir = 1.0f / direction;
+	float best = maxDistance;
+	bool found = false;
+
+	for (const AABB& box : boxes)
+	{
+		glm::vec3 t0 = (box.min - origin) * invDir;
+		glm::vec3 t1 = (box.max - origin) * invDir;
+		glm::vec3 entry = glm::min(t0, t1);
+		glm::vec3 exit = glm::max(t0, t1);
+
+		float tNear = std::max(std::max(entry.x, entry.y), std::max(entry.z, 0.0f));
+		float tFar = std::min(std::min(exit.x, exit.y), std::min(exit.z, best));
+
+		if (tNear <= tFar)
+		{
+			best = tNear;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+static void RunBenchmark(size_t count)
+{
+	std::mt19937 rng(1234);
+
+	//About one object per 1000 cubic units.
+	float halfSize = 0.5f * std::cbrt(count * 1000.0f);
+
+	std::uniform_real_distribution<float> position(-halfSize, halfSize);
+	std::uniform_real_distribution<float> radius(0.5f, 2.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<glm::vec4> spheres(count);
+	std::vector<AABB> boxes(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		spheres[i] = glm::vec4(position(rng), position(rng), position(rng), radius(rng));
+		boxes[i] = AABB::FromSphere(spheres[i]);
+	}
+
+	printf("%zu objects:\n", count);
+
+	//Building.
+	BVH incremental;
+	std::vector<BVH::Proxy> proxies(count);
+
+	auto start = Clock::now();
+
+	for (size_t i = 0; i < count; ++i)
+		proxies[i] = incremental.Insert(boxes[i], static_cast<uint32_t>(i));
+
+	auto end = Clock::now();
+
+	printf("  Insert one at a time: %9.2f ms  (height %d, cost %.1f)\n",
+		   Millis(start, end), incremental.GetHeight(), incremental.GetCost());
+
+	BVH bvh;
+
+	for (size_t i = 0; i < count; ++i)
+		proxies[i] = bvh.Insert(boxes[i], static_cast<uint32_t>(i));
+
+	start = Clock::now();
+	bvh.Build();
+	end = Clock::now();
+
+	printf("  SAH build:            %9.2f ms  (height %d, cost %.1f)\n",
+		   Millis(start, end), bvh.GetHeight(), bvh.GetCost());
+
+	//Frustum culling, from a few different spots looking in a few different directions.
+	const int numViews = 16;
+	std::vector<Frustum> frustums;
+
+	for (int i = 0; i < numViews; ++i)
+	{
+		glm::vec3 eye = glm::vec3(unit(rng), unit(rng), unit(rng)) * halfSize * 0.5f;
+		glm::vec3 target = eye + glm::vec3(unit(rng), unit(rng) * 0.2f, unit(rng));
+
+		frustums.emplace_back(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f) *
+							  glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+
+	std::vector<uint8_t> visible(count);
+	size_t bruteVisible = 0;
+
+	start = Clock::now();
+
+	for (const Frustum& frustum : frustums)
+		bruteVisible += frustum.TestSpheres(spheres.data(), count, visible.data());
+
+	end = Clock::now();
+	double bruteMs = Millis(start, end) / numViews;
+
+	std::vector<uint32_t> results;
+	size_t bvhVisible = 0;
+
+	start = Clock::now();
+
+	for (const Frustum& frustum : frustums)
+	{
+		results.clear();
+		bvhVisible += bvh.QueryFrustum(frustum, results);
+	}
+
+	end = Clock::now();
+	double bvhMs = Millis(start, end) / numViews;
+
+	printf("  Frustum: brute force (SSE) %8.3f ms, BVH %8.3f ms  (%.1fx)  [~%zu visible]\n",
+		   bruteMs, bvhMs, bruteMs / bvhMs, bvhVisible / numViews);
+
+	//Ray casts. Brute force gets far fewer rays, since it's so much slower.
+	const int numRays = 1000;
+	const int numBruteRays = 20;
+
+	std::vector<glm::vec3> origins(numRays), directions(numRays);
+
+	for (int i = 0; i < numRays; ++i)
+	{
+		origins[i] = glm::vec3(position(rng), position(rng), position(rng));
+		directions[i] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)));
+	}
+
+	size_t hits = 0;
+
+	start = Clock::now();
+
+	for (int i = 0; i < numBruteRays; ++i)
+		hits += RaycastAll(boxes, origins[i], directions[i], 1000.0f) ? 1 : 0;
+
+	end = Clock::now();
+	bruteMs = Millis(start, end) / numBruteRays;
+
+	BVH::RayHit hit;
+
+	start = Clock::now();
+
+	for (int i = 0; i < numRays; ++i)
+		hits += bvh.Raycast(origins[i], directions[i], 1000.0f, hit) ? 1 : 0;
+
+	end = Clock::now();
+	bvhMs = Millis(start, end) / numRays;
+
+	printf("  Ray:     brute force       %8.4f ms, BVH %8.4f ms  (%.0fx)\n",
+		   bruteMs, bvhMs, bruteMs / bvhMs);
+
+	//Overlap queries, about the size of an explosion.
+	const int numQueries = 1000;
+	const int numBruteQueries = 20;
+
+	std::vector<AABB> queries(numQueries);
+
+	for (int i = 0; i < numQueries; ++i)
+		queries[i] = AABB::FromSphere(glm::vec4(position(rng), position(rng), position(rng), 10.0f));
+
+	size_t overlaps = 0;
+
+	start = Clock::now();
+
+	for (int i = 0; i < numBruteQueries; ++i)
+	{
+		for (const AABB& box : boxes)
+			overlaps += box.Overlaps(queries[i]) ? 1 : 0;
+	}
+
+	end = Clock::now();
+	bruteMs = Millis(start, end) / numBruteQueries;
+
+	start = Clock::now();
+
+	for (int i = 0; i < numQueries; ++i)
+	{
+		results.clear();
+		overlaps += bvh.QueryOverlap(queries[i], results);
+	}
+
+	end = Clock::now();
+	bvhMs = Millis(start, end) / numQueries;
+
+	printf("  Overlap: brute force       %8.4f ms, BVH %8.4f ms  (%.0fx)\n",
+		   bruteMs, bvhMs, bruteMs / bvhMs);
+
+	//Move 1% of the objects a little, and refit.
+	size_t numMoved = count / 100;
+
+	for (size_t i = 0; i < numMoved; ++i)
+	{
+		size_t index = rng() % count;
+		glm::vec3 offset = glm::vec3(unit(rng), unit(rng), unit(rng));
+
+		boxes[index].min += offset;
+		boxes[index].max += offset;
+		bvh.Update(proxies[index], boxes[index]);
+	}
+
+	start = Clock::now();
+	bvh.Refit();
+	end = Clock::now();
+
+	printf("  Refit after moving 1%%:     %8.3f ms  (%zu boxes recomputed, cost %.1f)\n",
+		   Millis(start, end), bvh.LastRefitCount(), bvh.GetCost());
+
+	//So the compiler can't throw any of the work away.
+	printf("  (checksum %zu)\n\n", bruteVisible + hits + overlaps);
+}
+
+int main()
+{
+	RunBenchmark(10000);
+	RunBenchmark(100000);
+	RunBenchmark(1000000);
+
+	return 0;
+}
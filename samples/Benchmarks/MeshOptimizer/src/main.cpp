@@ -0,0 +1,151 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Mesh optimizer benchmark.
+Runs the MeshOptimizer pipeline on a few meshes and reports the vertex cache
+ACMR/ATVR before and after - no GPU (or even a window) needed.
+
+Pass the path to an OBJ file to try it out on your own model too.
+*/
+
+#include "NOU/MeshOptimizer.h"
+#include "NOU/OBJLoader.h"
+
+#include "GLM/gtc/constants.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nou;
+
+struct TestMesh
+{
+	std::string name;
+	std::vector<glm::vec3> verts;
+	std::vector<uint32_t> indices;
+};
+
+//A UV sphere, with its triangles in the order you'd naturally generate them
+//(row by row - which is decent, but far from the best for a small cache).
+static TestMesh MakeSphere(int rings, int segments)
+{
+	TestMesh mesh;
+	mesh.name = "Sphere (" + std::to_string(rings) + "x" + std::to_string(segments) + ", authored order)";
+
+	for (int r = 0; r <= rings; ++r)
+	{
+		float phi = glm::pi<float>() * r / rings;
+
+		for (int s = 0; s <= segments; ++s)
+		{
+			float theta = glm::two_pi<float>() * s / segments;
+			mesh.verts.push_back(glm::vec3(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta)));
+		}
+	}
+
+	for (int r = 0; r < rings; ++r)
+	{
+		for (int s = 0; s < segments; ++s)
+		{
+			uint32_t a = r * (segments + 1) + s;
+			uint32_t b = a + segments + 1;
+
+			mesh.indices.insert(mesh.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+		}
+	}
+
+	return mesh;
+}
+
+//The same, with its triangles in random order - e.g., what you might get
+//from a careless exporter, or after merging several meshes together.
+static TestMesh Shuffle(TestMesh mesh)
+{
+	mesh.name.replace(mesh.name.find("authored"), 8, "shuffled");
+
+	size_t triCount = mesh.indices.size() / 3;
+	std::vector<uint32_t> order(triCount);
+
+	for (size_t i = 0; i < triCount; ++i)
+		order[i] = static_cast<uint32_t>(i);
+
+	std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+	std::vector<uint32_t> shuffled;
+
+	for (uint32_t t : order)
+		shuffled.insert(shuffled.end(), mesh.indices.begin() + t * 3, mesh.indices.begin() + t * 3 + 3);
+
+	mesh.indices.swap(shuffled);
+
+	return mesh;
+}
+
+static bool LoadOBJ(const std::string& filename, TestMesh& mesh)
+{
+	OBJ::Geometry geom;
+	std::string err;
+
+	if (!OBJ::ParseFile(filename, geom, err))
+		return false;
+
+	//We only need the positions. Vertices that were split for their UVs or
+	//normals stay split, just like they would be on the GPU.
+	mesh.name = filename;
+	mesh.verts.swap(geom.verts);
+	mesh.indices.swap(geom.indices);
+
+	return !mesh.indices.empty();
+}
+
+static void Run(TestMesh mesh)
+{
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	MeshOptimizer::Report report = MeshOptimizer::OptimizeMesh(mesh.verts, normals, uvs, mesh.indices);
+	auto end = std::chrono::high_resolution_clock::now();
+
+	printf("%s:\n", mesh.name.c_str());
+	printf("  %zu triangles, %zu -> %zu vertices, %.2f ms\n", mesh.indices.size() / 3,
+		   report.vertsBefore, report.vertsAfter,
+		   std::chrono::duration<double, std::milli>(end - start).count());
+	printf("  ACMR %.3f -> %.3f\n", report.before.acmr, report.after.acmr);
+	printf("  ATVR %.3f -> %.3f\n", report.before.atvr, report.after.atvr);
+
+	//How the result holds up on caches of other sizes than we optimized for.
+	for (size_t cacheSize : { 8, 32 })
+	{
+		MeshOptimizer::CacheStats stats = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.verts.size(), cacheSize);
+		printf("  (with a %zu entry cache: ACMR %.3f, ATVR %.3f)\n", cacheSize, stats.acmr, stats.atvr);
+	}
+
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	TestMesh sphere = MakeSphere(64, 128);
+
+	Run(sphere);
+	Run(Shuffle(sphere));
+	Run(Shuffle(MakeSphere(512, 1024)));
+
+	for (int i = 1; i < argc; ++i)
+	{
+		TestMesh mesh;
+
+		if (LoadOBJ(argv[i], mesh))
+			Run(mesh);
+		else
+			printf("Couldn't load %s.\n", argv[i]);
+	}
+
+	return 0;
+}
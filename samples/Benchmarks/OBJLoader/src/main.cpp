@@ -0,0 +1,249 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+OBJ loader benchmark.
+Builds a big OBJ file out of many copies of monkey.obj, then times loading it
+with a stream-based loader (the way the Week 5 ObjLoader used to) against
+nou::OBJ, on one thread and then on the whole JobSystem.
+
+Usage: OBJLoader [path to monkey.obj (or any OBJ)] [number of copies]
+*/
+
+#include "NOU/JobSystem.h"
+#include "NOU/OBJLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace nou;
+
+//What a loader built with operator>> and a stringstream per face looks like.
+//Welds vertices the same way nou::OBJ does, so the results are comparable.
+static bool LoadWithStreams(const std::string& filename, OBJ::Geometry& geom)
+{
+	std::ifstream file(filename, std::ios::binary);
+
+	if (!file)
+		return false;
+
+	std::vector<glm::vec3> verts, normals;
+	std::vector<glm::vec2> uvs;
+	std::unordered_map<uint64_t, uint32_t> lookup;
+
+	std::string command, line, corner;
+
+	while (file >> command)
+	{
+		if (command == "v")
+		{
+			glm::vec3 v;
+			file >> v.x >> v.y >> v.z;
+			verts.push_back(v);
+		}
+		else if (command == "vn")
+		{
+			glm::vec3 n;
+			file >> n.x >> n.y >> n.z;
+			normals.push_back(n);
+		}
+		else if (command == "vt")
+		{
+			glm::vec2 uv;
+			file >> uv.x >> uv.y;
+			uvs.push_back(uv);
+		}
+		else if (command == "f")
+		{
+			std::getline(file, line);
+			std::stringstream stream(line);
+			std::vector<uint32_t> face;
+
+			while (stream >> corner)
+			{
+				//Assumes every corner is v/vt/vn, which is what Blender writes.
+				uint64_t v = 0, vt = 0, vn = 0;
+				char slash;
+				std::stringstream(corner) >> v >> slash >> vt >> slash >> vn;
+
+				uint64_t key = (v << 42) | (vt << 21) | vn;
+				auto it = lookup.find(key);
+
+				if (it == lookup.end())
+				{
+					it = lookup.emplace(key, static_cast<uint32_t>(geom.verts.size())).first;
+					geom.verts.push_back(verts[v - 1]);
+					geom.uvs.push_back(uvs[vt - 1]);
+					geom.normals.push_back(normals[vn - 1]);
+				}
+
+				face.push_back(it->second);
+			}
+
+			for (size_t i = 2; i < face.size(); ++i)
+				geom.indices.insert(geom.indices.end(), { face[0], face[i - 1], face[i] });
+
+			continue;
+		}
+
+		std::getline(file, line);
+	}
+
+	return true;
+}
+
+//Writes copies of the source OBJ one after the other, with each copy's face
+//indices shifted past the attributes of the copies before it.
+static size_t WriteScaledOBJ(const std::string& source, const std::string& dest, int copies)
+{
+	std::ifstream in(source, std::ios::binary);
+	std::stringstream buffer;
+	buffer << in.rdbuf();
+	std::string text = buffer.str();
+
+	//Count attributes, and split into lines once so we don't redo it per copy.
+	std::vector<std::string> lines;
+	int counts[3] = { 0, 0, 0 };
+	std::istringstream stream(text);
+	std::string line;
+
+	while (std::getline(stream, line))
+	{
+		if (line.compare(0, 2, "v ") == 0)
+			++counts[0];
+		else if (line.compare(0, 3, "vt ") == 0)
+			++counts[1];
+		else if (line.compare(0, 3, "vn ") == 0)
+			++counts[2];
+
+		lines.push_back(line);
+	}
+
+	std::ofstream out(dest, std::ios::binary);
+
+	for (int copy = 0; copy < copies; ++copy)
+	{
+		std::string chunk;
+
+		for (const std::string& l : lines)
+		{
+			if (l.compare(0, 2, "f ") != 0)
+			{
+				chunk += l;
+				chunk += '\n';
+				continue;
+			}
+
+			chunk += 'f';
+			std::istringstream corners(l.substr(2));
+			std::string corner;
+
+			while (corners >> corner)
+			{
+				chunk += ' ';
+				size_t start = 0;
+
+				for (int c = 0; c < 3 && start <= corner.size(); ++c)
+				{
+					size_t slash = std::min(corner.find('/', start), corner.size());
+
+					if (c > 0)
+						chunk += '/';
+
+					if (slash > start)
+						chunk += std::to_string(std::stoi(corner.substr(start, slash - start)) + copy * counts[c]);
+
+					start = slash + 1;
+				}
+			}
+
+			chunk += '\n';
+		}
+
+		out << chunk;
+	}
+
+	return static_cast<size_t>(out.tellp());
+}
+
+template<typename Load>
+static void Time(const char* name, size_t fileSize, Load load)
+{
+	OBJ::Geometry geom;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	bool result = load(geom);
+	auto end = std::chrono::high_resolution_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+
+	if (!result)
+	{
+		printf("%-28s failed!\n", name);
+		return;
+	}
+
+	printf("%-28s %8.1f ms %8.1f MB/s   (%zu vertices, %zu triangles)\n", name, seconds * 1000.0,
+		   fileSize / seconds / (1024.0 * 1024.0), geom.verts.size(), geom.indices.size() / 3);
+}
+
+int main(int argc, char** argv)
+{
+	std::string source = (argc > 1) ? argv[1] : "res/monkey.obj";
+	int copies = (argc > 2) ? std::atoi(argv[2]) : 1000;
+
+	//Fall back on the copy in the Week 5 project when run from the build folder.
+	if (!std::ifstream(source))
+		source = "../../../projects/Week5-Starter/res/monkey.obj";
+
+	if (!std::ifstream(source))
+	{
+		printf("Couldn't find monkey.obj - pass the path to an OBJ file instead.\n");
+		return 1;
+	}
+
+	const std::string scaled = "obj_benchmark.obj";
+	size_t fileSize = WriteScaledOBJ(source, scaled, copies);
+
+	printf("%d copies of %s: %.1f MB\n\n", copies, source.c_str(), fileSize / (1024.0 * 1024.0));
+
+	Time("Streams", fileSize, [&](OBJ::Geometry& geom)
+	{
+		return LoadWithStreams(scaled, geom);
+	});
+
+	std::string err;
+
+	Time("nou::OBJ (1 thread)", fileSize, [&](OBJ::Geometry& geom)
+	{
+		return OBJ::ParseFile(scaled, geom, err);
+	});
+
+	JobSystem::Init();
+
+	if (JobSystem::GetWorkerCount() > 0)
+	{
+		std::string name = "nou::OBJ (" + std::to_string(JobSystem::GetWorkerCount() + 1) + " threads)";
+
+		Time(name.c_str(), fileSize, [&](OBJ::Geometry& geom)
+		{
+			return OBJ::ParseFile(scaled, geom, err);
+		});
+	}
+
+	JobSystem::Shutdown();
+
+	if (!err.empty())
+		printf("%s\n", err.c_str());
+
+	std::remove(scaled.c_str());
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Parallel FK benchmark.
+Times a full FK pass over 100k transforms with the JobSystem running
+on 1 (i.e., no workers) up to N threads, for a few hierarchy shapes.
+*/
+
+#include "NOU/TransformStore.h"
+#include "NOU/JobSystem.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace nou;
+
+using Handle = TransformStore::Handle;
+
+static const size_t NUM_TRANSFORMS = 100000;
+
+//Lots of small, independent objects (e.g., characters with ~100 bones).
+static void BuildForest(TransformStore& store, std::vector<Handle>& roots, std::mt19937& rng)
+{
+	std::vector<Handle> tree;
+
+	for (size_t i = 0; i < NUM_TRANSFORMS; ++i)
+	{
+		if (i % 100 == 0)
+		{
+			tree.clear();
+			roots.push_back(store.Create());
+			tree.push_back(roots.back());
+			continue;
+		}
+
+		Handle handle = store.Create();
+		store.SetParent(handle, tree[rng() % tree.size()]);
+		store.SetPosition(handle, glm::vec3(0.0f, 1.0f, 0.0f));
+		tree.push_back(handle);
+	}
+}
+
+//Everything hangs off of one "world" root, a few levels deep.
+static void BuildSingleRoot(TransformStore& store, std::vector<Handle>& roots, std::mt19937& rng)
+{
+	std::vector<Handle> all;
+
+	roots.push_back(store.Create());
+	all.push_back(roots.back());
+
+	for (size_t i = 1; i < NUM_TRANSFORMS; ++i)
+	{
+		Handle handle = store.Create();
+		//Favour recent nodes, so we get some depth rather than one giant fan.
+		size_t back = rng() % std::min<size_t>(all.size(), 64);
+		store.SetParent(handle, all[all.size() - 1 - back]);
+		store.SetPosition(handle, glm::vec3(0.1f, 0.0f, 0.0f));
+		all.push_back(handle);
+	}
+}
+
+static double TimeFK(TransformStore& store, const std::vector<Handle>& roots, int iterations)
+{
+	float angle = 0.0f;
+
+	auto dirtyAll = [&]()
+	{
+		angle += 0.01f;
+
+		//Moving every root dirties the whole store.
+		for (Handle root : roots)
+			store.SetRotation(root, glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+	};
+
+	//Warm-up (this also takes care of the initial sort).
+	dirtyAll();
+	store.DoFK();
+
+	double total = 0.0;
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		dirtyAll();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		store.DoFK();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		total += std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	return total / iterations;
+}
+
+int main()
+{
+	const int iterations = 50;
+
+	size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	//Powers of two, plus every core we've got.
+	std::vector<size_t> threadCounts;
+
+	for (size_t threads = 1; threads < maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+
+	threadCounts.push_back(maxThreads);
+
+	struct Shape
+	{
+		const char* name;
+		void (*build)(TransformStore&, std::vector<Handle>&, std::mt19937&);
+	};
+
+	Shape shapes[] = { { "1000 roots x 100 nodes", BuildForest },
+					   { "1 root, 100k descendants", BuildSingleRoot } };
+
+	for (const Shape& shape : shapes)
+	{
+		std::mt19937 rng(1234);
+		TransformStore store;
+		std::vector<Handle> roots;
+
+		shape.build(store, roots, rng);
+
+		printf("%s:\n", shape.name);
+
+		double baseline = 0.0;
+
+		for (size_t threads : threadCounts)
+		{
+			//No workers at all for the single-threaded run.
+			if (threads > 1)
+				JobSystem::Init(threads - 1);
+
+			double ms = TimeFK(store, roots, iterations);
+
+			if (threads == 1)
+				baseline = ms;
+
+			printf("  %2zu thread(s): %7.3f ms  (%.2fx)\n", threads, ms, baseline / ms);
+
+			JobSystem::Shutdown();
+		}
+
+		printf("\n");
+	}
+
+	return 0;
+}
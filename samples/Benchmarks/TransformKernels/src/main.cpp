@@ -0,0 +1,125 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+TransformKernels benchmark.
+Compares building local and global matrices with plain GLM
+(translate * rotate * scale, then parent * local) against the batched
+kernels in NOU/TransformKernels.h, for every instruction set this CPU supports.
+*/
+
+#include "NOU/TransformKernels.h"
+
+#include "GLM/gtx/transform.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace nou;
+
+struct Scene
+{
+	std::vector<glm::vec3> pos;
+	std::vector<glm::quat> rot;
+	std::vector<glm::vec3> scale;
+	std::vector<uint32_t> parent;
+	std::vector<uint32_t> order;
+};
+
+//Builds a random forest where every parent comes before its children,
+//the same layout TransformStore uses.
+static Scene MakeScene(size_t count)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+	Scene scene;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		scene.pos.push_back(glm::vec3(dist(rng), dist(rng), dist(rng)) * 10.0f);
+		scene.rot.push_back(glm::quat(dist(rng), dist(rng), dist(rng), dist(rng)));
+		scene.scale.push_back(glm::vec3(1.0f) + glm::vec3(dist(rng), dist(rng), dist(rng)) * 0.5f);
+
+		//Roughly one root in eight, everything else hangs off a recent node.
+		bool root = i == 0 || (rng() % 8) == 0;
+		scene.parent.push_back(root ? TransformKernels::NONE : static_cast<uint32_t>(i - 1 - rng() % std::min<size_t>(i, 16)));
+		scene.order.push_back(static_cast<uint32_t>(i));
+	}
+
+	return scene;
+}
+
+template<typename Fn>
+static double TimeMs(int iterations, Fn fn)
+{
+	//One warm-up run so we aren't timing page faults.
+	fn();
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int i = 0; i < iterations; ++i)
+		fn();
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+int main()
+{
+	const size_t counts[] = { 10000, 100000, 1000000 };
+
+	printf("Best instruction set on this CPU: %s\n\n",
+		   TransformKernels::GetISAName(TransformKernels::Detect()));
+
+	for (size_t count : counts)
+	{
+		Scene scene = MakeScene(count);
+
+		std::vector<glm::mat4> local(count), global(count);
+
+		int iterations = static_cast<int>(std::max<size_t>(1, 10000000 / count));
+
+		double glmMs = TimeMs(iterations, [&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				local[i] = glm::translate(scene.pos[i]) *
+						   glm::toMat4(glm::normalize(scene.rot[i])) *
+						   glm::scale(scene.scale[i]);
+
+				uint32_t p = scene.parent[i];
+				global[i] = (p == TransformKernels::NONE) ? local[i] : global[p] * local[i];
+			}
+		});
+
+		printf("%zu transforms:\n", count);
+		printf("  %-8s %8.3f ms  (%6.2f ns/transform)\n", "GLM", glmMs, glmMs * 1e6 / count);
+
+		for (int isa = 0; isa <= static_cast<int>(TransformKernels::Detect()); ++isa)
+		{
+			TransformKernels::SetISA(static_cast<TransformKernels::ISA>(isa));
+
+			double ms = TimeMs(iterations, [&]()
+			{
+				TransformKernels::ComposeTRS(scene.pos.data(), scene.rot.data(), scene.scale.data(),
+											 local.data(), count);
+				TransformKernels::ConcatParents(scene.parent.data(), local.data(), global.data(),
+												scene.order.data(), count);
+			});
+
+			printf("  %-8s %8.3f ms  (%6.2f ns/transform, %.2fx vs GLM)\n",
+				   TransformKernels::GetISAName(TransformKernels::GetISA()),
+				   ms, ms * 1e6 / count, glmMs / ms);
+		}
+
+		printf("\n");
+	}
+
+	TransformKernels::SetISA(TransformKernels::Detect());
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*
+NOU Framework - Created for INFR 2310 at Ontario Tech.
+(c) Samantha Stahlke 2020
+
+Texture encoder.
+Converts an image (anything stb_image can read - PNG, JPG, TGA...) into a
+KTX file with a full mip chain, block compressed, ready for nou::Texture2D
+(or AssetManager::LoadTexture) to load straight onto the GPU.
+
+Usage: TextureEncoder <input image> [output.ktx] [options]
+  -f bc1|bc3|bc5|bc7|rgba8   Output format (default bc7). See TextureData.h.
+  -m kaiser|box|none         Mip filter (default kaiser), or no mipmaps at all.
+
+The output defaults to the input's name, with a .ktx extension.
+*/
+
+#include "NOU/BlockCompression.h"
+#include "NOU/JobSystem.h"
+#include "NOU/TextureData.h"
+
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+using namespace nou;
+
+static bool ParseFormat(const std::string& name, TextureFormat& format)
+{
+	const std::pair<const char*, TextureFormat> formats[] =
+	{
+		{ "bc1", TextureFormat::BC1 }, { "bc3", TextureFormat::BC3 }, { "bc5", TextureFormat::BC5 },
+		{ "bc7", TextureFormat::BC7 }, { "rgba8", TextureFormat::RGBA8 }
+	};
+
+	for (const auto& [formatName, value] : formats)
+	{
+		if (name == formatName)
+		{
+			format = value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void PrintUsage()
+{
+	printf("Usage: TextureEncoder <input image> [output.ktx] [-f bc1|bc3|bc5|bc7|rgba8] [-m kaiser|box|none]\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::string input, output;
+	TextureFormat format = TextureFormat::BC7;
+	MipFilter filter = MipFilter::KAISER;
+	bool mipmaps = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "-f" && i + 1 < argc)
+		{
+			if (!ParseFormat(argv[++i], format))
+			{
+				printf("Unknown format %s.\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (arg == "-m" && i + 1 < argc)
+		{
+			std::string mode = argv[++i];
+			mipmaps = mode != "none";
+			filter = (mode == "box") ? MipFilter::BOX : MipFilter::KAISER;
+		}
+		else if (input.empty())
+			input = arg;
+		else if (output.empty())
+			output = arg;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (input.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (output.empty())
+		output = std::filesystem::path(input).replace_extension(".ktx").string();
+
+	JobSystem::Init();
+
+	//Flipped, the same way Texture2D flips images it loads.
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* pixels = stbi_load(input.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+	if (pixels == nullptr)
+	{
+		printf("Couldn't load %s.\n", input.c_str());
+		JobSystem::Shutdown();
+		return 1;
+	}
+
+	using Clock = std::chrono::high_resolution_clock;
+	auto start = Clock::now();
+
+	TextureData source, encoded;
+	Mipmap::Build(pixels, width, height, source, mipmaps, filter);
+	stbi_image_free(pixels);
+
+	auto mipped = Clock::now();
+
+	BlockCompression::Encode(source, format, encoded);
+
+	auto done = Clock::now();
+
+	bool saved = KTX::Save(output, encoded);
+	JobSystem::Shutdown();
+
+	if (!saved)
+	{
+		printf("Couldn't write %s.\n", output.c_str());
+		return 1;
+	}
+
+	printf("%s -> %s\n", input.c_str(), output.c_str());
+	printf("  %dx%d, %zu mip levels\n", width, height, encoded.levels.size());
+	printf("  mipmaps %.1f ms, encoding %.1f ms\n",
+		   std::chrono::duration<double, std::milli>(mipped - start).count(),
+		   std::chrono::duration<double, std::milli>(done - mipped).count());
+	printf("  %.2f MB as RGBA8 -> %.2f MB (%.1fx smaller)\n",
+		   source.GetSize() / (1024.0 * 1024.0), encoded.GetSize() / (1024.0 * 1024.0),
+		   static_cast<double>(source.GetSize()) / encoded.GetSize());
+
+	return 0;
+}